@@ -55,6 +55,7 @@ recompute path. Also enables more complicated dependencies beyond trees.
 # include <algorithm>
 # include <sstream>
 # include <climits>
+# include <set>
 #endif
 
 #include <boost/graph/topological_sort.hpp>
@@ -68,6 +69,10 @@ recompute path. Also enables more complicated dependencies beyond trees.
 
 #include <QCoreApplication>
 #include <QCryptographicHash>
+#include <QFuture>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QtConcurrentMap>
 
 
 #include "Document.h"
@@ -117,7 +122,7 @@ using namespace zipios;
 typedef boost::adjacency_list <
 boost::vecS,           // class OutEdgeListS  : a Sequence or an AssociativeContainer
 boost::vecS,           // class VertexListS   : a Sequence or a RandomAccessContainer
-boost::directedS,      // class DirectedS     : This is a directed graph
+boost::bidirectionalS, // class DirectedS     : This is a directed graph with access to the in-edges
 boost::no_property,    // class VertexProperty:
 boost::no_property,    // class EdgeProperty:
 boost::no_property,    // class GraphProperty:
@@ -150,6 +155,16 @@ struct DocumentP
     unsigned int UndoMaxStackSize;
     DependencyList DepList;
     std::map<DocumentObject*,Vertex> VertexObjectList;
+    // vertex to object, removed objects leave a null pointer
+    std::vector<DocumentObject*> vertexObjects;
+    // objects whose links have changed since the last update of the graph
+    std::set<DocumentObject*> dirtyLinks;
+    std::size_t removedVertices;
+    // set while properties are changed in worker threads, i.e. during a
+    // parallel recompute or restore
+    bool queueChanges;
+    QMutex changeMutex;
+    std::vector<std::pair<const DocumentObject*, const Property*> > pendingChanges;
 
     DocumentP() {
         activeObject = 0;
@@ -163,6 +178,8 @@ struct DocumentP
         iUndoMode = 0;
         UndoMemSize = 0;
         UndoMaxStackSize = 20;
+        queueChanges = false;
+        removedVertices = 0;
     }
 };
 
@@ -300,6 +317,24 @@ std::vector<std::string> Document::getAvailableRedoNames() const
     return vList;
 }
 
+std::vector<unsigned int> Document::getAvailableUndoSizes() const
+{
+    std::vector<unsigned int> vList;
+    if (d->activeUndoTransaction)
+        vList.push_back(d->activeUndoTransaction->getMemSize());
+    for (std::list<Transaction*>::const_reverse_iterator It=mUndoTransactions.rbegin();It!=mUndoTransactions.rend();++It)
+        vList.push_back((**It).getMemSize());
+    return vList;
+}
+
+std::vector<unsigned int> Document::getAvailableRedoSizes() const
+{
+    std::vector<unsigned int> vList;
+    for (std::list<Transaction*>::const_reverse_iterator It=mRedoTransactions.rbegin();It!=mRedoTransactions.rend();++It)
+        vList.push_back((**It).getMemSize());
+    return vList;
+}
+
 void Document::openTransaction(const char* name)
 {
     if (d->iUndoMode) {
@@ -347,8 +382,24 @@ void Document::commitTransaction()
         mUndoTransactions.push_back(d->activeUndoTransaction);
         d->activeUndoTransaction = 0;
         // check the stack for the limits
-        if(mUndoTransactions.size() > d->UndoMaxStackSize){
-            delete mUndoTransactions.front();
+        _checkUndoLimits();
+    }
+}
+
+void Document::_checkUndoLimits()
+{
+    while (mUndoTransactions.size() > d->UndoMaxStackSize) {
+        delete mUndoTransactions.front();
+        mUndoTransactions.pop_front();
+    }
+
+    // the most recent Undo is always kept even if it alone exceeds the limit
+    if (d->UndoMemSize > 0) {
+        unsigned int size = getUndoMemSize();
+        while (size > d->UndoMemSize && mUndoTransactions.size() > 1) {
+            Transaction* undo = mUndoTransactions.front();
+            size -= std::min<unsigned int>(size, undo->getMemSize());
+            delete undo;
             mUndoTransactions.pop_front();
         }
     }
@@ -427,17 +478,32 @@ int Document::getUndoMode(void) const
 
 unsigned int Document::getUndoMemSize (void) const
 {
-    return d->UndoMemSize;
+    unsigned int size = 0;
+    if (d->activeUndoTransaction)
+        size += d->activeUndoTransaction->getMemSize();
+    std::list<Transaction*>::const_iterator It;
+    for (It = mUndoTransactions.begin(); It != mUndoTransactions.end(); ++It)
+        size += (*It)->getMemSize();
+    for (It = mRedoTransactions.begin(); It != mRedoTransactions.end(); ++It)
+        size += (*It)->getMemSize();
+    return size;
 }
 
 void Document::setUndoLimit(unsigned int UndoMemSize)
 {
     d->UndoMemSize = UndoMemSize;
+    _checkUndoLimits();
+}
+
+unsigned int Document::getUndoLimit(void) const
+{
+    return d->UndoMemSize;
 }
 
 void Document::setMaxUndoStackSize(unsigned int UndoMaxStackSize)
 {
      d->UndoMaxStackSize = UndoMaxStackSize;
+     _checkUndoLimits();
 }
 
 unsigned int Document::getMaxUndoStackSize(void)const
@@ -487,15 +553,32 @@ void Document::onChanged(const Property* prop)
 
 void Document::onBeforeChangeProperty(const DocumentObject *Who, const Property *What)
 {
+    QMutexLocker locker(d->queueChanges ? &d->changeMutex : 0);
     if (d->activeUndoTransaction && !d->rollback)
         d->activeUndoTransaction->addObjectChange(Who,What);
 }
 
 void Document::onChangedProperty(const DocumentObject *Who, const Property *What)
 {
+    QMutexLocker locker(d->queueChanges ? &d->changeMutex : 0);
     if (d->activeTransaction && !d->rollback)
         d->activeTransaction->addObjectChange(Who,What);
-    signalChangedObject(*Who, *What);
+    // a changed link requires to update the edges of this object in the dependency graph
+    Base::Type type = What->getTypeId();
+    if (type.isDerivedFrom(PropertyLink::getClassTypeId()) ||
+        type.isDerivedFrom(PropertyLinkSub::getClassTypeId()) ||
+        type.isDerivedFrom(PropertyLinkList::getClassTypeId()) ||
+        type.isDerivedFrom(PropertyLinkSubList::getClassTypeId())) {
+        DocumentObject* obj = const_cast<DocumentObject*>(Who);
+        if (d->VertexObjectList.find(obj) != d->VertexObjectList.end())
+            d->dirtyLinks.insert(obj);
+    }
+    // the observers are not thread-safe, so during a parallel recompute or
+    // restore the notification is sent afterwards from within the main thread
+    if (d->queueChanges)
+        d->pendingChanges.push_back(std::make_pair(Who, What));
+    else
+        signalChangedObject(*Who, *What);
 }
 
 void Document::setTransactionMode(int iMode)
@@ -750,6 +833,10 @@ void Document::exportObjects(const std::vector<App::DocumentObject*>& obj,
                              std::ostream& out)
 {
     Base::ZipWriter writer(out);
+    ParameterGrp::handle hGrp = App::GetApplication().GetParameterGroupByPath
+        ("User parameter:BaseApp/Preferences/Document");
+    if (hGrp->GetBool("SaveBinaryBrep", false))
+        writer.setMode("BinaryBrep");
     writer.putNextEntry("Document.xml");
     writer.Stream() << "<?xml version='1.0' encoding='utf-8'?>" << endl;
     writer.Stream() << "<Document SchemaVersion=\"4\" ProgramVersion=\""
@@ -948,6 +1035,8 @@ bool Document::save (void)
 {
     int compression = App::GetApplication().GetParameterGroupByPath
         ("User parameter:BaseApp/Preferences/Document")->GetInt("CompressionLevel",3);
+    bool binary = App::GetApplication().GetParameterGroupByPath
+        ("User parameter:BaseApp/Preferences/Document")->GetBool("SaveBinaryBrep",false);
 
     if (*(FileName.getValue()) != '\0') {
         LastModifiedDate.setValue(Base::TimeInfo::currentDateTimeString());
@@ -966,6 +1055,9 @@ bool Document::save (void)
 
             writer.setComment("FreeCAD Document");
             writer.setLevel(compression);
+            // the shapes are written in the binary format of OCC
+            if (binary)
+                writer.setMode("BinaryBrep");
             writer.putNextEntry("Document.xml");
 
             Document::Save(writer);
@@ -1055,6 +1147,7 @@ void Document::restore (void)
     d->objectArray.clear();
     d->objectMap.clear();
     d->activeObject = 0;
+    _rebuildDependencyList();
 
     Base::FileInfo fi(FileName.getValue());
     Base::ifstream file(fi, std::ios::in | std::ios::binary);
@@ -1084,7 +1177,29 @@ void Document::restore (void)
     // Note: This file doesn't need to be available if the document has been created
     // without GUI. But if available then follow after all data files of the App document.
     signalRestoreDocument(reader);
-    reader.readFiles(zipstream);
+
+    // the data files of objects which support it are parsed in worker threads
+    ParameterGrp::handle hGrp = App::GetApplication().GetParameterGroupByPath
+        ("User parameter:BaseApp/Preferences/Document");
+    bool parallel = hGrp->GetBool("ParallelRestore", false);
+    // read here because the parameters must not be accessed from worker threads
+    reader.setLazyLoading(hGrp->GetBool("LazyLoadShapes", false));
+    if (parallel) {
+        d->queueChanges = true;
+        reader.setConcurrentRestore(true);
+    }
+    try {
+        reader.readFiles(zipstream);
+    }
+    catch (...) {
+        d->queueChanges = false;
+        d->pendingChanges.clear();
+        throw;
+    }
+    if (parallel) {
+        d->queueChanges = false;
+        _sendPendingChanges(d->objectArray);
+    }
     
     // reset all touched
     for (std::map<std::string,DocumentObject*>::iterator It= d->objectMap.begin();It!=d->objectMap.end();++It) {
@@ -1231,22 +1346,171 @@ Document::getDependencyList(const std::vector<App::DocumentObject*>& objs) const
 void Document::_rebuildDependencyList(void)
 {
     d->VertexObjectList.clear();
+    d->vertexObjects.clear();
+    d->dirtyLinks.clear();
+    d->removedVertices = 0;
     d->DepList.clear();
     // Filling up the adjacency List
     for (std::map<std::string,DocumentObject*>::const_iterator It = d->objectMap.begin(); It != d->objectMap.end();++It) {
         // add the object as Vertex and remember the index
         d->VertexObjectList[It->second] = add_vertex(d->DepList);
+        d->vertexObjects.push_back(It->second);
     }
     // add the edges
     for (std::map<std::string,DocumentObject*>::const_iterator It = d->objectMap.begin(); It != d->objectMap.end();++It) {
         std::vector<DocumentObject*> OutList = It->second->getOutList();
         for (std::vector<DocumentObject*>::const_iterator It2=OutList.begin();It2!=OutList.end();++It2) {
-            if (*It2)
-                add_edge(d->VertexObjectList[It->second],d->VertexObjectList[*It2],d->DepList);
+            if (!*It2)
+                continue;
+            std::map<DocumentObject*,Vertex>::iterator jt = d->VertexObjectList.find(*It2);
+            if (jt != d->VertexObjectList.end())
+                add_edge(d->VertexObjectList[It->second],jt->second,d->DepList);
+            else // the link points to an object that is currently not part of the document
+                d->dirtyLinks.insert(It->second);
         }
     }
 }
 
+void Document::_updateDependencyList(void)
+{
+    // too many dead vertices, it's faster to rebuild the whole graph
+    if (d->removedVertices > 64 && 2 * d->removedVertices > d->vertexObjects.size()) {
+        _rebuildDependencyList();
+        return;
+    }
+
+    std::set<DocumentObject*> dirty;
+    dirty.swap(d->dirtyLinks);
+    for (std::set<DocumentObject*>::iterator it = dirty.begin(); it != dirty.end(); ++it) {
+        std::map<DocumentObject*,Vertex>::iterator jt = d->VertexObjectList.find(*it);
+        if (jt == d->VertexObjectList.end())
+            continue;
+        Vertex v = jt->second;
+        clear_out_edges(v, d->DepList);
+        std::vector<DocumentObject*> OutList = (*it)->getOutList();
+        for (std::vector<DocumentObject*>::const_iterator It2=OutList.begin();It2!=OutList.end();++It2) {
+            if (!*It2)
+                continue;
+            std::map<DocumentObject*,Vertex>::iterator kt = d->VertexObjectList.find(*It2);
+            if (kt != d->VertexObjectList.end())
+                add_edge(v,kt->second,d->DepList);
+            else // check again when the linked object is back in the document
+                d->dirtyLinks.insert(*it);
+        }
+    }
+}
+
+void Document::_addToDependencyList(DocumentObject* pcObject)
+{
+    if (d->VertexObjectList.find(pcObject) != d->VertexObjectList.end())
+        return;
+    Vertex v = add_vertex(d->DepList);
+    d->VertexObjectList[pcObject] = v;
+    d->vertexObjects.push_back(pcObject);
+    // the edges are added with the next update
+    d->dirtyLinks.insert(pcObject);
+}
+
+void Document::_removeFromDependencyList(DocumentObject* pcObject)
+{
+    std::map<DocumentObject*,Vertex>::iterator it = d->VertexObjectList.find(pcObject);
+    if (it == d->VertexObjectList.end())
+        return;
+
+    // The objects linking to this object must be checked again. The vertex itself
+    // isn't removed as this would invalidate all other vertex descriptors.
+    Vertex v = it->second;
+    DependencyList::in_edge_iterator j, jend;
+    for (boost::tie(j, jend) = in_edges(v, d->DepList); j != jend; ++j) {
+        DocumentObject* pcSource = d->vertexObjects[source(*j, d->DepList)];
+        if (pcSource)
+            d->dirtyLinks.insert(pcSource);
+    }
+    clear_vertex(v, d->DepList);
+    d->vertexObjects[v] = 0;
+    d->VertexObjectList.erase(it);
+    d->dirtyLinks.erase(pcObject);
+    d->removedVertices++;
+}
+
+namespace App {
+
+// checks whether the object itself or one of its dependencies is touched
+static bool mustRecompute(DocumentObject* Cur, Vertex v, DocumentP* d)
+{
+#ifdef FC_LOGFEATUREUPDATE
+    std::clog << Cur->getNameInDocument() << " dep on: " ;
+#endif
+    bool NeedUpdate = false;
+
+    // ask the object if it should be recomputed
+    if (Cur->mustExecute() == 1)
+        NeedUpdate = true;
+    else {// if (Cur->mustExecute() == -1)
+        // update if one of the dependencies is touched
+        DependencyList::out_edge_iterator j, jend;
+        for (boost::tie(j, jend) = out_edges(v, d->DepList); j != jend; ++j) {
+            DocumentObject* Test = d->vertexObjects[target(*j, d->DepList)];
+            if (!Test) continue;
+#ifdef FC_LOGFEATUREUPDATE
+            std::clog << Test->getNameInDocument() << ", " ;
+#endif
+            if (Test->isTouched()) {
+                NeedUpdate = true;
+                break;
+            }
+        }
+#ifdef FC_LOGFEATUREUPDATE
+        std::clog << std::endl;
+#endif
+    }
+
+    return NeedUpdate;
+}
+
+// Recompute of a single feature inside a worker thread. Since the console and
+// the recompute log must only be accessed from the main thread the outcome is
+// kept and evaluated by Document::_recomputeFeatures() afterwards.
+struct RecomputeJob
+{
+    enum Failure { None, Abort, Memory, Exception, Unknown };
+
+    RecomputeJob(DocumentObject* f) : Feat(f), returnCode(0), failure(None) {}
+
+    void run()
+    {
+        try {
+            returnCode = Feat->recompute();
+        }
+        catch (const Base::AbortException& e) {
+            failure = Abort;
+            message = e.what();
+        }
+        catch (const Base::MemoryException& e) {
+            failure = Memory;
+            message = e.what();
+        }
+        catch (const Base::Exception& e) {
+            failure = Exception;
+            message = e.what();
+        }
+        catch (const std::exception& e) {
+            failure = Exception;
+            message = e.what();
+        }
+        catch (...) {
+            failure = Unknown;
+        }
+    }
+
+    DocumentObject* Feat;
+    DocumentObjectExecReturn* returnCode;
+    Failure failure;
+    std::string message;
+};
+
+} // namespace App
+
 void Document::recompute()
 {
     // delete recompute log
@@ -1255,66 +1519,106 @@ void Document::recompute()
     _RecomputeLog.clear();
 
     // updates the dependency graph
-    _rebuildDependencyList();
+    _updateDependencyList();
 
-    std::list<Vertex> make_order;
+    // Only the touched objects and the objects depending on them can be affected,
+    // so collect them by walking the graph against the direction of the links.
+    std::size_t numVertices = num_vertices(d->DepList);
+    std::vector<bool> affected(numVertices, false);
+    std::vector<Vertex> subgraph;
+    for (std::vector<DocumentObject*>::const_iterator it = d->objectArray.begin(); it != d->objectArray.end(); ++it) {
+        if ((*it)->isTouched() || (*it)->mustExecute() == 1) {
+            Vertex v = d->VertexObjectList[*it];
+            if (!affected[v]) {
+                affected[v] = true;
+                subgraph.push_back(v);
+            }
+        }
+    }
+
+    DependencyList::in_edge_iterator i, iend;
     DependencyList::out_edge_iterator j, jend;
+    for (std::size_t k = 0; k < subgraph.size(); k++) {
+        for (boost::tie(i, iend) = in_edges(subgraph[k], d->DepList); i != iend; ++i) {
+            Vertex s = source(*i, d->DepList);
+            if (!affected[s] && d->vertexObjects[s]) {
+                affected[s] = true;
+                subgraph.push_back(s);
+            }
+        }
+    }
 
-    try {
-        // this sort gives the execute
-        boost::topological_sort(d->DepList, std::front_inserter(make_order));
+    // Sort the affected objects into dependency levels. An object of level n only
+    // depends on objects of a level < n, so all objects of one level can also be
+    // recomputed at the same time.
+    std::vector<int> pending(numVertices, 0);
+    std::vector<Vertex> level;
+    for (std::vector<Vertex>::iterator it = subgraph.begin(); it != subgraph.end(); ++it) {
+        for (boost::tie(j, jend) = out_edges(*it, d->DepList); j != jend; ++j) {
+            if (affected[target(*j, d->DepList)])
+                pending[*it]++;
+        }
+        if (pending[*it] == 0)
+            level.push_back(*it);
+    }
+
+    std::vector< std::vector<Vertex> > levels;
+    std::size_t sorted = 0;
+    while (!level.empty()) {
+        std::vector<Vertex> next;
+        for (std::vector<Vertex>::iterator it = level.begin(); it != level.end(); ++it) {
+            for (boost::tie(i, iend) = in_edges(*it, d->DepList); i != iend; ++i) {
+                Vertex s = source(*i, d->DepList);
+                if (affected[s] && --pending[s] == 0)
+                    next.push_back(s);
+            }
+        }
+        sorted += level.size();
+        levels.push_back(level);
+        level.swap(next);
     }
-    catch (const std::exception& e) {
-        std::cerr << "Document::recompute: " << e.what() << std::endl;
+
+    if (sorted != subgraph.size()) {
+        std::cerr << "Document::recompute: The graph must be a DAG." << std::endl;
         return;
     }
 
     // caching vertex to DocObject
-    for (std::map<DocumentObject*,Vertex>::const_iterator It1= d->VertexObjectList.begin();It1 != d->VertexObjectList.end(); ++It1)
-        d->vertexMap[It1->second] = It1->first;
+    for (std::vector<Vertex>::iterator it = subgraph.begin(); it != subgraph.end(); ++it)
+        d->vertexMap[*it] = d->vertexObjects[*it];
 
 #ifdef FC_LOGFEATUREUPDATE
     std::clog << "make ordering: " << std::endl;
 #endif
 
-    for (std::list<Vertex>::reverse_iterator i = make_order.rbegin();i != make_order.rend(); ++i) {
-        DocumentObject* Cur = d->vertexMap[*i];
-        if (!Cur) continue;
-#ifdef FC_LOGFEATUREUPDATE
-        std::clog << Cur->getNameInDocument() << " dep on: " ;
-#endif
-        bool NeedUpdate = false;
-
-        // ask the object if it should be recomputed
-        if (Cur->mustExecute() == 1)
-            NeedUpdate = true;
-        else {// if (Cur->mustExecute() == -1)
-            // update if one of the dependencies is touched
-            for (boost::tie(j, jend) = out_edges(*i, d->DepList); j != jend; ++j) {
-                DocumentObject* Test = d->vertexMap[target(*j, d->DepList)];
-                if (!Test) continue;
+    bool parallel = App::GetApplication().GetParameterGroupByPath
+        ("User parameter:BaseApp/Preferences/Document")->GetBool("ParallelRecompute", false);
+    for (std::vector< std::vector<Vertex> >::iterator it = levels.begin(); it != levels.end(); ++it) {
+        std::vector<DocumentObject*> feats;
+        for (std::vector<Vertex>::iterator jt = it->begin(); jt != it->end(); ++jt) {
+            DocumentObject* Cur = d->vertexMap[*jt];
+            if (!Cur) continue;
+            // if one touched recompute
+            if (mustRecompute(Cur, *jt, d)) {
+                if (parallel) {
+                    feats.push_back(Cur);
+                    continue;
+                }
 #ifdef FC_LOGFEATUREUPDATE
-                std::clog << Test->getNameInDocument() << ", " ;
+                std::clog << "Recompute" << std::endl;
 #endif
-                if (Test->isTouched()) {
-                    NeedUpdate = true;
-                    break;
+                if (_recomputeFeature(Cur)) {
+                    // if somthing happen break execution of recompute
+                    d->vertexMap.clear();
+                    return;
                 }
             }
-#ifdef FC_LOGFEATUREUPDATE
-            std::clog << std::endl;
-#endif
         }
-        // if one touched recompute
-        if (NeedUpdate) {
-#ifdef FC_LOGFEATUREUPDATE
-            std::clog << "Recompute" << std::endl;
-#endif
-            if (_recomputeFeature(Cur)) {
-                // if somthing happen break execution of recompute
-                d->vertexMap.clear();
-                return;
-            }
+
+        if (!feats.empty() && _recomputeFeatures(feats)) {
+            // if somthing happen break execution of recompute
+            d->vertexMap.clear();
+            return;
         }
     }
 
@@ -1391,6 +1695,113 @@ bool Document::_recomputeFeature(DocumentObject* Feat)
     return false;
 }
 
+void Document::_sendPendingChanges(const std::vector<DocumentObject*>& order)
+{
+    // send the change notifications in the order of the objects to have a
+    // deterministic behaviour independent of the thread scheduling
+    std::map<const DocumentObject*, std::size_t> index;
+    for (std::vector<DocumentObject*>::const_iterator it = order.begin(); it != order.end(); ++it)
+        index.insert(std::make_pair(*it, index.size()));
+    std::vector<std::pair<std::size_t, std::size_t> > sorted;
+    std::vector<std::pair<const DocumentObject*, const Property*> > changes;
+    changes.swap(d->pendingChanges);
+    for (std::size_t i = 0; i < changes.size(); i++) {
+        std::map<const DocumentObject*, std::size_t>::iterator jt = index.find(changes[i].first);
+        sorted.push_back(std::make_pair(jt != index.end() ? jt->second : index.size(), i));
+    }
+    std::sort(sorted.begin(), sorted.end());
+    for (std::vector<std::pair<std::size_t, std::size_t> >::iterator it = sorted.begin(); it != sorted.end(); ++it)
+        signalChangedObject(*changes[it->second].first, *changes[it->second].second);
+}
+
+bool Document::_recomputeFeatures(const std::vector<DocumentObject*>& Feats)
+{
+    // objects that are not thread-safe are recomputed in the main thread afterwards
+    std::vector<RecomputeJob> jobs;
+    std::vector<DocumentObject*> serial;
+    for (std::vector<DocumentObject*>::const_iterator it = Feats.begin(); it != Feats.end(); ++it) {
+        if ((*it)->isThreadSafe())
+            jobs.push_back(RecomputeJob(*it));
+        else
+            serial.push_back(*it);
+    }
+
+    // not worth to start any threads
+    if (jobs.size() == 1) {
+        serial.insert(serial.begin(), jobs.front().Feat);
+        jobs.clear();
+    }
+
+    if (!jobs.empty()) {
+#ifdef FC_LOGFEATUREUPDATE
+        std::clog << "Recompute " << jobs.size() << " features in parallel" << std::endl;
+#endif
+        d->queueChanges = true;
+        QFuture<void> future = QtConcurrent::map(jobs, &RecomputeJob::run);
+        future.waitForFinished();
+        d->queueChanges = false;
+
+        std::vector<DocumentObject*> order;
+        for (std::vector<RecomputeJob>::iterator it = jobs.begin(); it != jobs.end(); ++it)
+            order.push_back(it->Feat);
+        _sendPendingChanges(order);
+
+        bool abort = false;
+        for (std::vector<RecomputeJob>::iterator it = jobs.begin(); it != jobs.end(); ++it) {
+            DocumentObject* Feat = it->Feat;
+            switch (it->failure) {
+            case RecomputeJob::Abort:
+                Base::AbortException(it->message.c_str()).ReportException();
+                _RecomputeLog.push_back(new DocumentObjectExecReturn("User abort",Feat));
+                Feat->setError();
+                abort = true;
+                break;
+            case RecomputeJob::Memory:
+                Base::Console().Error("Memory exception in feature '%s' thrown: %s\n",
+                    Feat->getNameInDocument(),it->message.c_str());
+                _RecomputeLog.push_back(new DocumentObjectExecReturn("Out of memory exception",Feat));
+                Feat->setError();
+                abort = true;
+                break;
+            case RecomputeJob::Exception:
+                Base::Console().Warning("exception in Feature \"%s\" thrown: %s\n",
+                    Feat->getNameInDocument(),it->message.c_str());
+                _RecomputeLog.push_back(new DocumentObjectExecReturn(it->message,Feat));
+                Feat->setError();
+                break;
+            case RecomputeJob::Unknown:
+                Base::Console().Error("App::Document::_recomputeFeatures(): Unknown exception in Feature \"%s\" thrown\n",
+                    Feat->getNameInDocument());
+                _RecomputeLog.push_back(new DocumentObjectExecReturn("Unknown exeption!",Feat));
+                Feat->setError();
+                abort = true;
+                break;
+            default:
+                if (it->returnCode == DocumentObject::StdReturn) {
+                    Feat->resetError();
+                }
+                else {
+                    it->returnCode->Which = Feat;
+                    _RecomputeLog.push_back(it->returnCode);
+                    Base::Console().Error("%s\n",it->returnCode->Why.c_str());
+                    Feat->setError();
+                }
+                break;
+            }
+        }
+
+        if (abort)
+            return true;
+    }
+
+    for (std::vector<DocumentObject*>::iterator it = serial.begin(); it != serial.end(); ++it) {
+        if (_recomputeFeature(*it))
+            return true;
+    }
+
+    return false;
+}
+
 void Document::recomputeFeature(DocumentObject* Feat)
 {
      // delete recompute log
@@ -1443,8 +1854,8 @@ DocumentObject * Document::addObject(const char* sType, const char* pObjectName)
     pcObject->pcNameInDocument = &(d->objectMap.find(ObjectName)->first);
     // insert in the vector
     d->objectArray.push_back(pcObject);
-    // insert in the adjacence list and referenc through the ConectionMap
-    //_DepConMap[pcObject] = add_vertex(_DepList);
+    // insert in the adjacence list
+    _addToDependencyList(pcObject);
 
     pcObject->Label.setValue( ObjectName );
 
@@ -1463,6 +1874,7 @@ void Document::_addObject(DocumentObject* pcObject, const char* pObjectName)
     d->objectArray.push_back(pcObject);
     // cache the pointer to the name string in the Object (for performance of DocumentObject::getNameInDocument())
     pcObject->pcNameInDocument = &(d->objectMap.find(pObjectName)->first);
+    _addToDependencyList(pcObject);
 
     // do no transactions if we do a rollback!
     if(!d->rollback){
@@ -1504,6 +1916,7 @@ void Document::remObject(const char* sName)
 
     // Before deleting we must nullify all dependant objects
     breakDependency(pos->second, true);
+    _removeFromDependencyList(pos->second);
 
     // do no transactions if we do a rollback!
     if(!d->rollback){
@@ -1530,9 +1943,6 @@ void Document::remObject(const char* sName)
             break;
         }
     }
-    // remove from adjancy list
-    //remove_vertex(_DepConMap[pos->second],_DepList);
-    //_DepConMap.erase(pos->second);
     d->objectMap.erase(pos);
 }
 
@@ -1560,6 +1970,7 @@ void Document::_remObject(DocumentObject* pcObject)
     }
     // remove from map
     d->objectMap.erase(pos);
+    _removeFromDependencyList(pcObject);
     //// set name cache false
     //pcObject->pcNameInDocument = 0;
 
@@ -233,8 +233,12 @@ public:
     void abortTransaction();
     /// Check if a transaction is open
     bool hasPendingTransaction() const;
-    /// Set the Undo limit in Byte!
+    /** Set the Undo limit in Byte! If the memory used by the Undo/Redo stack
+     * exceeds the limit the oldest Undos are removed. 0 means no limit.
+     */
     void setUndoLimit(unsigned int UndoMemSize=0);
+    /// Returns the Undo limit in Byte
+    unsigned int getUndoLimit(void) const;
     /// Returns the actual memory consumption of the Undo redo stuff.
     unsigned int getUndoMemSize (void) const;
     /// Set the Undo limit as stack size
@@ -247,12 +251,16 @@ public:
     int getAvailableUndos() const;
     /// Returns a list of the Undo names
     std::vector<std::string> getAvailableUndoNames() const;
+    /// Returns the memory consumption of each Undo in the order of getAvailableUndoNames()
+    std::vector<unsigned int> getAvailableUndoSizes() const;
     /// Will UNDO  one step, returns  False if no undo was done (Undos == 0).
     bool undo();
     /// Returns the number of stored Redos. If greater than 0 Redo will be effective.
     int getAvailableRedos() const;
     /// Returns a list of the Redo names.
     std::vector<std::string> getAvailableRedoNames() const;
+    /// Returns the memory consumption of each Redo in the order of getAvailableRedoNames()
+    std::vector<unsigned int> getAvailableRedoSizes() const;
     /// Will REDO  one step, returns  False if no redo was done (Redos == 0).
     bool redo() ;
     //@}
@@ -305,9 +313,20 @@ protected:
     void onChangedProperty(const DocumentObject *Who, const Property *What);
     /// helper which Recompute only this feature
     bool _recomputeFeature(DocumentObject* Feat);
+    /// helper which Recompute a set of features which don't depend on each other
+    bool _recomputeFeatures(const std::vector<DocumentObject*>& Feats);
+    /// sends the queued change notifications sorted by the given order of the objects
+    void _sendPendingChanges(const std::vector<DocumentObject*>& order);
+
     void _clearRedos();
+    /// removes the oldest Undos until the stack fits into the limits
+    void _checkUndoLimits();
     /// refresh the internal dependency graph
     void _rebuildDependencyList(void);
+    /// update the internal dependency graph for all objects whose links have changed
+    void _updateDependencyList(void);
+    void _addToDependencyList(DocumentObject* pcObject);
+    void _removeFromDependencyList(DocumentObject* pcObject);
     std::string getTransientDirectoryName(const std::string& uuid, const std::string& filename) const;
 
 
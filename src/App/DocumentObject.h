@@ -134,6 +134,15 @@ public:
      * -1: the document examine all links of this object and if one is touched -> recompute
      */
     virtual short mustExecute(void) const;
+    /** isThreadSafe
+     *  Returns true if execute() may run in a worker thread at the same time as
+     *  the execute() of other objects it doesn't depend on. This is used by the
+     *  parallel recompute of the document. By default an object is always
+     *  recomputed in the main thread.
+     */
+    virtual bool isThreadSafe(void) const {
+        return false;
+    }
 
     /// get the status Message
     const char *getStatusString(void) const;
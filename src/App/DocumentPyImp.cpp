@@ -437,6 +437,19 @@ Py::Int DocumentPy::getUndoRedoMemSize(void) const
     return Py::Int((long)getDocumentPtr()->getUndoMemSize());
 }
 
+Py::Int DocumentPy::getUndoLimit(void) const
+{
+    return Py::Int((long)getDocumentPtr()->getUndoLimit());
+}
+
+void DocumentPy::setUndoLimit(Py::Int arg)
+{
+    long limit = arg;
+    if (limit < 0)
+        throw Py::ValueError("Undo limit must not be negative");
+    getDocumentPtr()->setUndoLimit((unsigned int)limit);
+}
+
 Py::Int DocumentPy::getUndoCount(void) const
 {
     return Py::Int((long)getDocumentPtr()->getAvailableUndos());
@@ -469,6 +482,28 @@ Py::List DocumentPy::getRedoNames(void) const
     return res;
 }
 
+Py::List DocumentPy::getUndoSizes(void) const
+{
+    std::vector<unsigned int> vList = getDocumentPtr()->getAvailableUndoSizes();
+    Py::List res;
+
+    for (std::vector<unsigned int>::const_iterator It = vList.begin();It!=vList.end();++It)
+        res.append(Py::Int((long)*It));
+
+    return res;
+}
+
+Py::List DocumentPy::getRedoSizes(void) const
+{
+    std::vector<unsigned int> vList = getDocumentPtr()->getAvailableRedoSizes();
+    Py::List res;
+
+    for (std::vector<unsigned int>::const_iterator It = vList.begin();It!=vList.end();++It)
+        res.append(Py::Int((long)*It));
+
+    return res;
+}
+
 Py::String  DocumentPy::getDependencyGraph(void) const
 {
     std::stringstream out;
@@ -81,6 +81,10 @@ public:
             return 1;
         return FeatureT::mustExecute();
     }
+    /// Python features need the GIL and are thus always recomputed in the main thread
+    virtual bool isThreadSafe(void) const {
+        return false;
+    }
     /// recalculate the Feature
     virtual DocumentObjectExecReturn *execute(void) {
         return imp->execute();
@@ -114,6 +114,16 @@ void Property::Paste(const Property& /*from*/)
     assert(0);
 }
 
+Base::Persistence* Property::createDocFileBuffer() const
+{
+    return static_cast<Property*>(getTypeId().createInstance());
+}
+
+void Property::applyDocFileBuffer(Base::Persistence* buffer)
+{
+    Paste(*static_cast<Property*>(buffer));
+}
+
 std::string Property::encodeAttribute(const std::string& str) const
 {
     std::string tmp;
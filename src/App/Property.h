@@ -27,7 +27,9 @@
 // Std. configurations
 
 #include <Base/Persistence.h>
+#include <Base/Handle.h>
 #include <string>
+#include <vector>
 #include <bitset>
 
 
@@ -95,6 +97,10 @@ public:
     virtual Property *Copy(void) const = 0;
     /// Paste the value from the property (mainly for Undo/Redo and transactions)
     virtual void Paste(const Property &from) = 0;
+    /// Creates a property of the same type without container to restore a file into
+    virtual Base::Persistence* createDocFileBuffer() const;
+    /// Pastes the value of a property created by createDocFileBuffer()
+    virtual void applyDocFileBuffer(Base::Persistence* buffer);
     /// Encodes an attribute upon saving.
     std::string encodeAttribute(const std::string&) const;
 
@@ -141,6 +147,77 @@ class AppExport PropertyLists : public Property
 public:
     virtual void setSize(int newSize)=0;   
     virtual int getSize(void) const =0;   
+    /// the values of a list are written and read without side effects
+    virtual bool canSaveDocFileConcurrently() const {
+        return true;
+    }
+    virtual bool canRestoreDocFileConcurrently() const {
+        return true;
+    }
+};
+
+/** The values of a list property.
+ * The values are shared by the property and its copies, e.g. in the Undo/Redo
+ * stack. Before they are changed while still being shared the property gets its
+ * own copy of them (copy-on-write). So, recording a list property in a transaction
+ * doesn't copy its values.
+ */
+template <class T>
+class PropertyListValues
+{
+public:
+    typedef typename std::vector<T>::const_iterator const_iterator;
+
+    PropertyListValues() : _data(new Data()) {
+    }
+
+    const std::vector<T>& get() const {
+        return _data->values;
+    }
+    std::size_t size() const {
+        return _data->values.size();
+    }
+    const T& operator[] (std::size_t idx) const {
+        return _data->values[idx];
+    }
+    const_iterator begin() const {
+        return _data->values.begin();
+    }
+    const_iterator end() const {
+        return _data->values.end();
+    }
+
+    /// replaces the values, shared values are not copied
+    void set(const std::vector<T>& values) {
+        if (_data.getRefCount() > 1)
+            _data = new Data();
+        _data->values = values;
+    }
+    void resize(std::size_t size) {
+        edit().resize(size);
+    }
+    /// returns the values for modification, they are copied if they are shared
+    std::vector<T>& edit() {
+        if (_data.getRefCount() > 1) {
+            Data* data = new Data();
+            data->values = _data->values;
+            _data = data;
+        }
+        return _data->values;
+    }
+
+    /// the memory of the values divided by the number of lists sharing them
+    unsigned int getMemSize() const {
+        return static_cast<unsigned int>(_data->values.size() * sizeof(T) / _data.getRefCount());
+    }
+
+private:
+    class Data : public Base::Handled
+    {
+    public:
+        std::vector<T> values;
+    };
+    Base::Reference<Data> _data;
 };
 
 } // namespace App
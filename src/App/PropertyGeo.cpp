@@ -210,23 +210,21 @@ int PropertyVectorList::getSize(void) const
 void PropertyVectorList::setValue(const Base::Vector3d& lValue)
 {
     aboutToSetValue();
-    _lValueList.resize(1);
-    _lValueList[0]=lValue;
+    _lValueList.set(std::vector<Base::Vector3d>(1, lValue));
     hasSetValue();
 }
 
 void PropertyVectorList::setValue(double x, double y, double z)
 {
     aboutToSetValue();
-    _lValueList.resize(1);
-    _lValueList[0].Set(x,y,z);
+    _lValueList.set(std::vector<Base::Vector3d>(1, Base::Vector3d(x,y,z)));
     hasSetValue();
 }
 
 void PropertyVectorList::setValues(const std::vector<Base::Vector3d>& values)
 {
     aboutToSetValue();
-    _lValueList = values;
+    _lValueList.set(values);
     hasSetValue();
 }
 
@@ -348,7 +346,7 @@ void PropertyVectorList::Paste(const Property &from)
 
 unsigned int PropertyVectorList::getMemSize (void) const
 {
-    return static_cast<unsigned int>(_lValueList.size() * sizeof(Base::Vector3d));
+    return _lValueList.getMemSize();
 }
 
 //**************************************************************************
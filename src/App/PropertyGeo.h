@@ -131,7 +131,7 @@ public:
     }
 
     void set1Value (const int idx, const Base::Vector3d& value) {
-        _lValueList.operator[] (idx) = value;
+        _lValueList.edit()[idx] = value;
     }
 
     void setValues (const std::vector<Base::Vector3d>& values);
@@ -139,7 +139,7 @@ public:
     void setValue (void){};
 
     const std::vector<Base::Vector3d> &getValues(void) const {
-        return _lValueList;
+        return _lValueList.get();
     }
 
     virtual PyObject *getPyObject(void);
@@ -157,7 +157,7 @@ public:
     virtual unsigned int getMemSize (void) const;
 
 private:
-    std::vector<Base::Vector3d> _lValueList;
+    PropertyListValues<Base::Vector3d> _lValueList;
 };
 
 /** Vector properties
@@ -1063,15 +1063,14 @@ int PropertyFloatList::getSize(void) const
 void PropertyFloatList::setValue(double lValue)
 {
     aboutToSetValue();
-    _lValueList.resize(1);
-    _lValueList[0]=lValue;
+    _lValueList.set(std::vector<double>(1, lValue));
     hasSetValue();
 }
 
 void PropertyFloatList::setValues(const std::vector<double>& values)
 {
     aboutToSetValue();
-    _lValueList = values;
+    _lValueList.set(values);
     hasSetValue();
 }
 
@@ -1195,7 +1194,7 @@ void PropertyFloatList::Paste(const Property &from)
 
 unsigned int PropertyFloatList::getMemSize (void) const
 {
-    return static_cast<unsigned int>(_lValueList.size() * sizeof(double));
+    return _lValueList.getMemSize();
 }
 
 //**************************************************************************
@@ -2034,15 +2033,14 @@ int PropertyColorList::getSize(void) const
 void PropertyColorList::setValue(const Color& lValue)
 {
     aboutToSetValue();
-    _lValueList.resize(1);
-    _lValueList[0]=lValue;
+    _lValueList.set(std::vector<Color>(1, lValue));
     hasSetValue();
 }
 
 void PropertyColorList::setValues (const std::vector<Color>& values)
 {
     aboutToSetValue();
-    _lValueList=values;
+    _lValueList.set(values);
     hasSetValue();
 }
 
@@ -2161,7 +2159,7 @@ void PropertyColorList::Paste(const Property &from)
 
 unsigned int PropertyColorList::getMemSize (void) const
 {
-    return static_cast<unsigned int>(_lValueList.size() * sizeof(Color));
+    return _lValueList.getMemSize();
 }
 
 //**************************************************************************
@@ -530,10 +530,10 @@ public:
     double operator[] (const int idx) const {return _lValueList.operator[] (idx);} 
     
     
-    void set1Value (const int idx, double value){_lValueList.operator[] (idx) = value;}
+    void set1Value (const int idx, double value){_lValueList.edit()[idx] = value;}
     void setValues (const std::vector<double>& values);
     
-    const std::vector<double> &getValues(void) const{return _lValueList;}
+    const std::vector<double> &getValues(void) const{return _lValueList.get();}
     
     virtual PyObject *getPyObject(void);
     virtual void setPyObject(PyObject *);
@@ -549,7 +549,7 @@ public:
     virtual unsigned int getMemSize (void) const;
 
 private:
-    std::vector<double> _lValueList;
+    PropertyListValues<double> _lValueList;
 };
 
 
@@ -823,10 +823,10 @@ public:
     /// index operator
     const Color& operator[] (const int idx) const {return _lValueList.operator[] (idx);} 
     
-    void  set1Value (const int idx, const Color& value){_lValueList.operator[] (idx) = value;}
+    void  set1Value (const int idx, const Color& value){_lValueList.edit()[idx] = value;}
     
     void setValues (const std::vector<Color>& values);
-    const std::vector<Color> &getValues(void) const{return _lValueList;}
+    const std::vector<Color> &getValues(void) const{return _lValueList.get();}
     
     virtual PyObject *getPyObject(void);
     virtual void setPyObject(PyObject *);
@@ -842,7 +842,7 @@ public:
     virtual unsigned int getMemSize (void) const;
     
 private:
-    std::vector<Color> _lValueList;
+    PropertyListValues<Color> _lValueList;
 };
 
 /** Material properties
@@ -84,7 +84,18 @@ Transaction::~Transaction()
 
 unsigned int Transaction::getMemSize (void) const
 {
-    return 0;
+    // Not cached: the property copies may share their data with the document,
+    // which counts only in part and changes when the document is modified.
+    unsigned int size = 0;
+    std::map<const DocumentObject*,TransactionObject*>::const_iterator It;
+    for (It= _Objects.begin();It!=_Objects.end();++It) {
+        size += It->second->getMemSize();
+        // an object that has been removed from the document is kept by the transaction
+        if (It->second->status == TransactionObject::New && !It->first->pcNameInDocument)
+            size += It->first->getMemSize();
+    }
+
+    return size;
 }
 
 void Transaction::Save (Base::Writer &/*writer*/) const
@@ -264,7 +275,11 @@ void TransactionObject::setProperty(const Property* pcProp)
 
 unsigned int TransactionObject::getMemSize (void) const
 {
-    return 0;
+    unsigned int size = 0;
+    std::map<const Property*,Property*>::const_iterator It;
+    for (It=_PropChangeMap.begin();It!=_PropChangeMap.end();++It)
+        size += It->second->getMemSize();
+    return size;
 }
 
 void TransactionObject::Save (Base::Writer &/*writer*/) const
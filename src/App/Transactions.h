@@ -86,6 +86,10 @@ public:
     // the utf-8 name of the transaction
     std::string Name; 
 
+    /** Returns the memory used by the property copies and the removed objects
+     * of this transaction. Data shared with the document or other transactions
+     * is counted in proportion.
+     */
     virtual unsigned int getMemSize (void) const;
     virtual void Save (Base::Writer &writer) const;
     /// This method is used to restore properties from an XML document.
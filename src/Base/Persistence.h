@@ -146,6 +146,33 @@ public:
      * @see Base::Reader,Base::XMLReader
      */
     virtual void RestoreDocFile(Reader &/*reader*/);
+    /** Returns true if SaveDocFile() only reads the data of this object and
+     * doesn't add further files to the writer. Then the writer may save the
+     * file in a worker thread while other files are saved. By default the file
+     * is saved in the main thread.
+     */
+    virtual bool canSaveDocFileConcurrently() const {
+        return false;
+    }
+    /** Returns true if RestoreDocFile() only changes the data of this object
+     * and doesn't read further files. Then the reader may restore the file
+     * into an object of createDocFileBuffer() in a worker thread. By default
+     * the file is restored in the main thread.
+     */
+    virtual bool canRestoreDocFileConcurrently() const {
+        return false;
+    }
+    /** Creates an empty object of the same type which doesn't belong to any
+     * owner, so restoring a file into it doesn't notify anybody. The reader
+     * restores the file into it in a worker thread and passes it to
+     * applyDocFileBuffer() in the main thread. Returns null if not supported.
+     */
+    virtual Persistence* createDocFileBuffer() const {
+        return 0;
+    }
+    /// Takes over the data that was restored into an object of createDocFileBuffer()
+    virtual void applyDocFileBuffer(Persistence* /*buffer*/) {
+    }
 };
 
 } //namespace Base
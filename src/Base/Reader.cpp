@@ -30,7 +30,10 @@
 # include <xercesc/sax2/SAX2XMLReader.hpp>
 #endif
 
+#include <algorithm>
+#include <iterator>
 #include <locale>
+#include <sstream>
 
 /// Here the FreeCAD includes sorted by Base,App,Gui......
 #include "Reader.h"
@@ -41,6 +44,10 @@
 #include "Console.h"
 #include "Sequencer.h"
 
+#include <boost/bind.hpp>
+#include <QThread>
+#include <QtConcurrentMap>
+
 #include <zipios++/zipios-config.h>
 #include <zipios++/zipfile.h>
 #include <zipios++/zipinputstream.h>
@@ -60,7 +67,7 @@ using namespace std;
 // ---------------------------------------------------------------------------
 
 Base::XMLReader::XMLReader(const char* FileName, std::istream& str) 
-  : DocumentSchema(0), ProgramVersion(""), FileVersion(0), Level(0), _File(FileName)
+  : DocumentSchema(0), ProgramVersion(""), FileVersion(0), Level(0), _File(FileName), _concurrent(false), _lazy(false)
 {
 #ifdef _MSC_VER
     str.imbue(std::locale::empty());
@@ -273,6 +280,70 @@ void Base::XMLReader::readBinFile(const char* filename)
     to.close();
 }
 
+namespace Base {
+// the inflated content of a file which is restored in a worker thread into a buffer
+// object, the buffer is passed to the actual object in the main thread so that no
+// change notification is sent from a worker thread
+struct RestoreJob
+{
+    RestoreJob() : Object(0), Buffer(0), Schema(0), Lazy(false), Failed(false) {}
+
+    void run()
+    {
+        std::istringstream str(Data);
+        std::string().swap(Data);
+        try {
+            Base::Reader reader(str,FileName,Schema,Lazy);
+            Buffer->RestoreDocFile(reader);
+        }
+        catch(...) {
+            Failed = true;
+        }
+    }
+
+    Base::Persistence* Object;
+    Base::Persistence* Buffer;
+    std::string FileName;
+    std::string EntryName;
+    std::string Data;
+    int Schema;
+    bool Lazy;
+    bool Failed;
+};
+
+// restores the buffered files in worker threads
+static void restoreFiles(std::vector<RestoreJob>& jobs)
+{
+    if (jobs.size() > 1)
+        QtConcurrent::blockingMap(jobs, boost::bind(&RestoreJob::run, _1));
+    else if (jobs.size() == 1)
+        jobs.front().run();
+    for (std::vector<RestoreJob>::iterator it = jobs.begin(); it != jobs.end(); ++it) {
+        try {
+            if (!it->Failed)
+                it->Object->applyDocFileBuffer(it->Buffer);
+        }
+        catch(...) {
+            it->Failed = true;
+        }
+        delete it->Buffer;
+        if (it->Failed)
+            Base::Console().Error("Reading failed from embedded file: %s\n", it->EntryName.c_str());
+    }
+    jobs.clear();
+}
+}
+
+void Base::XMLReader::setConcurrentRestore(bool on)
+{
+    _concurrent = on && QThread::idealThreadCount() > 1;
+}
+
+void Base::XMLReader::setLazyLoading(bool on)
+{
+    _lazy = on;
+}
+
 void Base::XMLReader::readFiles(zipios::ZipInputStream &zipstream) const
 {
     // It's possible that not all objects inside the document could be created, e.g. if a module
@@ -292,6 +363,14 @@ void Base::XMLReader::readFiles(zipios::ZipInputStream &zipstream) const
         // project file was created without GUI
         return;
     }
+
+    // If enabled, the files of objects that allow it are inflated in the main thread and
+    // parsed in batches by worker threads. The results are passed to the objects in the
+    // main thread after each batch. Before any other file is restored the pending
+    // batch is finished. So, an object can rely on all files before it being restored.
+    std::vector<RestoreJob> jobs;
+    std::size_t batchSize = (std::size_t)std::max<int>(2 * QThread::idealThreadCount(), 1);
+
     std::vector<FileEntry>::const_iterator it = FileList.begin();
     Base::SequencerLauncher seq("Importing project files...", FileList.size());
     while (entry->isValid() && it != FileList.end()) {
@@ -303,17 +382,37 @@ void Base::XMLReader::readFiles(zipios::ZipInputStream &zipstream) const
         // If this condition is true both file names match and we can read-in the data, otherwise
         // no file name for the current entry in the zip was registered.
         if (jt != FileList.end()) {
-            try {
-                Base::Reader reader(zipstream,DocumentSchema);
-                jt->Object->RestoreDocFile(reader);
+            Base::Persistence* buffer = 0;
+            if (_concurrent && jt->Object->canRestoreDocFileConcurrently())
+                buffer = jt->Object->createDocFileBuffer();
+            if (buffer) {
+                RestoreJob job;
+                job.Object = jt->Object;
+                job.Buffer = buffer;
+                job.FileName = jt->FileName;
+                job.EntryName = entry->toString();
+                job.Schema = DocumentSchema;
+                job.Lazy = _lazy;
+                jobs.push_back(job);
+                jobs.back().Data.assign(std::istreambuf_iterator<char>(zipstream),
+                                        std::istreambuf_iterator<char>());
+                if (jobs.size() >= batchSize)
+                    restoreFiles(jobs);
             }
-            catch(...) {
-                // For any exception we just continue with the next file.
-                // It doesn't matter if the last reader has read more or
-                // less data than the file size would allow.
-                // All what we need to do is to notify the user about the
-                // failure.
-                Base::Console().Error("Reading failed from embedded file: %s\n", entry->toString().c_str());
+            else {
+                restoreFiles(jobs);
+                try {
+                    Base::Reader reader(zipstream,jt->FileName,DocumentSchema,_lazy);
+                    jt->Object->RestoreDocFile(reader);
+                }
+                catch(...) {
+                    // For any exception we just continue with the next file.
+                    // It doesn't matter if the last reader has read more or
+                    // less data than the file size would allow.
+                    // All what we need to do is to notify the user about the
+                    // failure.
+                    Base::Console().Error("Reading failed from embedded file: %s\n", entry->toString().c_str());
+                }
             }
             // Go to the next registered file name
             it = jt + 1;
@@ -330,6 +429,8 @@ void Base::XMLReader::readFiles(zipios::ZipInputStream &zipstream) const
             break;
         }
     }
+
+    restoreFiles(jobs);
 }
 
 const char *Base::XMLReader::addFile(const char* Name, Base::Persistence *Object)
@@ -481,9 +582,19 @@ void Base::XMLReader::resetErrors()
 
 // ----------------------------------------------------------
 
-Base::Reader::Reader(std::istream& str, int version)
-  : std::istream(str.rdbuf()), _str(str), fileVersion(version)
+Base::Reader::Reader(std::istream& str, const std::string& name, int version, bool lazy)
+  : std::istream(str.rdbuf()), _str(str), _name(name), fileVersion(version), lazyLoading(lazy)
+{
+}
+
+bool Base::Reader::isLazyLoading() const
+{
+    return lazyLoading;
+}
+
+std::string Base::Reader::getFileName() const
 {
+    return this->_name;
 }
 
 int Base::Reader::getFileVersion() const
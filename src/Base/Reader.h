@@ -156,6 +156,15 @@ public:
     const char *addFile(const char* Name, Base::Persistence *Object);
     /// process the requested file writes
     void readFiles(zipios::ZipInputStream &zipstream) const;
+    /** Allows to restore the files of objects that support it in worker threads.
+     * The caller must make sure that the change notifications of the objects
+     * are not handled inside the worker threads.
+     */
+    void setConcurrentRestore(bool on);
+    /** Allows objects to keep the data of their files and to decode it when
+     * it's accessed the first time. The flag is passed to each Reader.
+     */
+    void setLazyLoading(bool on);
     /// get all registered file names
     const std::vector<std::string>& getFilenames() const;
     bool isRegistered(Base::Persistence *Object) const;
@@ -224,6 +233,8 @@ protected:
     XERCES_CPP_NAMESPACE_QUALIFIER SAX2XMLReader* parser;
     XERCES_CPP_NAMESPACE_QUALIFIER XMLPScanToken token;
     bool _valid;
+    bool _concurrent;
+    bool _lazy;
 
     struct FileEntry {
         std::string FileName;
@@ -236,13 +247,19 @@ protected:
 class BaseExport Reader : public std::istream
 {
 public:
-    Reader(std::istream&, int version);
+    Reader(std::istream&, const std::string&, int version, bool lazy=false);
     int getFileVersion() const;
+    /// returns true if the data may be decoded when it's accessed the first time
+    bool isLazyLoading() const;
     std::istream& getStream();
+    /// the name of the file inside the document
+    std::string getFileName() const;
 
 private:
     std::istream& _str;
+    std::string _name;
     int fileVersion;
+    bool lazyLoading;
 };
 
 }
@@ -34,10 +34,16 @@
 #include "FileInfo.h"
 #include "Stream.h"
 #include "Tools.h"
+#include "Console.h"
+#include "TimeInfo.h"
 
 #include <algorithm>
 #include <locale>
 
+#include <boost/bind.hpp>
+#include <QThread>
+#include <QtConcurrentMap>
+
 using namespace Base;
 using namespace std;
 using namespace zipios;
@@ -108,6 +114,36 @@ int Writer::getFileVersion() const
     return fileVersion;
 }
 
+void Writer::setMode(const std::string& mode)
+{
+    Modes.insert(mode);
+}
+
+bool Writer::getMode(const std::string& mode) const
+{
+    std::set<std::string>::const_iterator it = Modes.find(mode);
+    return it != Modes.end();
+}
+
+void Writer::clearMode(const std::string& mode)
+{
+    std::set<std::string>::iterator it = Modes.find(mode);
+    if (it != Modes.end())
+        Modes.erase(it);
+}
+
+void Writer::addError(const std::string& msg)
+{
+    Errors.push_back(msg);
+}
+
+std::vector<std::string> Writer::takeErrors()
+{
+    std::vector<std::string> errors;
+    errors.swap(Errors);
+    return errors;
+}
+
 std::string Writer::addFile(const char* Name,const Base::Persistence *Object)
 {
     // always check isForceXML() before requesting a file!
@@ -204,16 +240,116 @@ ZipWriter::ZipWriter(std::ostream& os)
     ZipStream.setf(ios::fixed,ios::floatfield);
 }
 
+namespace Base {
+// the content of a file which is saved in a worker thread
+struct DocFileJob
+{
+    DocFileJob() : Object(0), Buffer(0), Time(0.0f) {}
+
+    void run()
+    {
+        TimeInfo start;
+        try {
+            Object->SaveDocFile(*Buffer);
+        }
+        catch (const Base::Exception& e) {
+            Error = e.what();
+        }
+        catch (const std::exception& e) {
+            Error = e.what();
+        }
+        catch (...) {
+            Error = "Unknown exception";
+        }
+        Time = TimeInfo::diffTimeF(start);
+    }
+
+    const Base::Persistence* Object;
+    StringWriter* Buffer;
+    std::string Error;
+    float Time;
+};
+}
+
 void ZipWriter::writeFiles(void)
 {
+    // Files of objects that allow it are saved in batches into memory buffers by
+    // worker threads. Afterwards the buffers and the other files are written in
+    // the order of their registration so that the archive has always the same
+    // layout. The compression itself is done by the zip stream.
+    size_t batchSize = (size_t)std::max<int>(2 * QThread::idealThreadCount(), 1);
+
     // use a while loop because it is possible that while
     // processing the files new ones can be added
     size_t index = 0;
     while (index < FileList.size()) {
-        FileEntry entry = FileList.begin()[index];
-        ZipStream.putNextEntry(entry.FileName);
-        entry.Object->SaveDocFile(*this);
-        index++;
+        size_t count = std::min<size_t>(batchSize, FileList.size() - index);
+        std::vector<DocFileJob> jobs(count);
+        std::vector<DocFileJob*> work;
+        if (count > 1) {
+            for (size_t i = 0; i < count; i++) {
+                const Base::Persistence* object = FileList[index + i].Object;
+                if (object->canSaveDocFileConcurrently()) {
+                    jobs[i].Object = object;
+                    jobs[i].Buffer = new StringWriter();
+                    jobs[i].Buffer->setFileVersion(fileVersion);
+                    for (std::set<std::string>::iterator it = Modes.begin(); it != Modes.end(); ++it)
+                        jobs[i].Buffer->setMode(*it);
+                    std::ostream& str = jobs[i].Buffer->Stream();
+                    str.imbue(ZipStream.getloc());
+                    str.precision(ZipStream.precision());
+                    str.flags(ZipStream.flags());
+                    work.push_back(&jobs[i]);
+                }
+            }
+        }
+        if (work.size() > 1)
+            QtConcurrent::blockingMap(work, boost::bind(&DocFileJob::run, _1));
+        else if (work.size() == 1)
+            work.front()->run();
+
+        std::string error;
+        for (size_t i = 0; i < count; i++) {
+            // copy the entry because new files may be added meanwhile
+            FileEntry entry = FileList[index + i];
+            ZipStream.putNextEntry(entry.FileName);
+            TimeInfo start;
+            if (jobs[i].Buffer) {
+                std::string data = jobs[i].Buffer->getString();
+                std::vector<std::string> errors = jobs[i].Buffer->takeErrors();
+                Errors.insert(Errors.end(), errors.begin(), errors.end());
+                delete jobs[i].Buffer;
+                jobs[i].Buffer = 0;
+                ZipStream.write(data.c_str(), data.size());
+                Console().Log("Saved '%s' in %.3f s (compressed in %.3f s)\n",
+                    entry.FileName.c_str(), jobs[i].Time, TimeInfo::diffTimeF(start));
+                if (error.empty() && !jobs[i].Error.empty())
+                    error = jobs[i].Error;
+            }
+            else if (error.empty()) {
+                try {
+                    entry.Object->SaveDocFile(*this);
+                }
+                catch (const Base::Exception& e) {
+                    error = e.what();
+                }
+                catch (const std::exception& e) {
+                    error = e.what();
+                }
+                Console().Log("Saved '%s' in %.3f s\n",
+                    entry.FileName.c_str(), TimeInfo::diffTimeF(start));
+            }
+
+            // the files were written nevertheless
+            std::vector<std::string> errors = takeErrors();
+            for (std::vector<std::string>::iterator it = errors.begin(); it != errors.end(); ++it)
+                Console().Error("%s\n", it->c_str());
+        }
+
+        // report a failure as if the files were saved one by one
+        if (!error.empty())
+            throw Base::Exception(error);
+        index += count;
     }
 }
 
@@ -28,6 +28,7 @@
 #include <sstream>
 #include <vector>
 #include <cassert>
+#include <set>
 
 #include <zipios++/zipios-config.h>
 #include <zipios++/zipfile.h>
@@ -65,6 +66,27 @@ public:
     void setFileVersion(int);
     int getFileVersion() const;
 
+    /** @name modes of the writer */
+    //@{
+    /// set a mode, e.g. "BinaryBrep" to write the shapes in binary format
+    void setMode(const std::string& mode);
+    /// check whether a mode is set
+    bool getMode(const std::string& mode) const;
+    /// clear a mode
+    void clearMode(const std::string& mode);
+    //@}
+
+    /** @name errors that don't abort writing */
+    //@{
+    /** Add an error message of a file that couldn't be written completely. The
+     * messages are printed by writeFiles() in the main thread because files may
+     * be written in worker threads.
+     */
+    void addError(const std::string& msg);
+    /// get and remove the collected error messages
+    std::vector<std::string> takeErrors();
+    //@}
+
     /// insert a file as CDATA section in the XML file
     void insertAsciiFile(const char* FileName);
     /// insert a binary file BASE64 coded as CDATA section in the XML file
@@ -109,6 +131,8 @@ protected:
 
     bool forceXML;
     int fileVersion;
+    std::set<std::string> Modes;
+    std::vector<std::string> Errors;
 };
 
 
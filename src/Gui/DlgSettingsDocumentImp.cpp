@@ -56,6 +56,7 @@ void DlgSettingsDocumentImp::saveSettings()
 
     prefUndoRedo->onSave();
     prefUndoRedoSize->onSave();
+    prefUndoRedoMemory->onSave();
     prefSaveTransaction->onSave();
     prefDiscardTransaction->onSave();
     prefSaveThumbnail->onSave();
@@ -71,6 +72,7 @@ void DlgSettingsDocumentImp::loadSettings()
 
     prefUndoRedo->onRestore();
     prefUndoRedoSize->onRestore();
+    prefUndoRedoMemory->onRestore();
     prefSaveTransaction->onRestore();
     prefDiscardTransaction->onRestore();
     prefSaveThumbnail->onRestore();
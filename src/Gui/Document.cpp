@@ -144,6 +144,8 @@ Document::Document(App::Document* pcDocument,Application * app)
         d->_pcDocument->setUndoMode(1);
         // set the maximum stack size
         d->_pcDocument->setMaxUndoStackSize(App::GetApplication().GetParameterGroupByPath("User parameter:BaseApp/Preferences/Document")->GetInt("MaxUndoSize",20));
+        // set the memory limit of the Undo/Redo stack in MB
+        d->_pcDocument->setUndoLimit((unsigned int)App::GetApplication().GetParameterGroupByPath("User parameter:BaseApp/Preferences/Document")->GetInt("MaxUndoMemory",0) * 1024 * 1024);
     }
 }
 
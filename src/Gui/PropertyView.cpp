@@ -54,7 +54,7 @@ using namespace Gui::PropertyEditor;
 /* TRANSLATOR Gui::PropertyView */
 
 PropertyView::PropertyView(QWidget *parent)
-  : QWidget(parent)
+  : QWidget(parent), SelectionObserver(true)
 {
     QGridLayout* pLayout = new QGridLayout( this ); 
     pLayout->setSpacing(0);
@@ -54,7 +54,7 @@
 using namespace Gui;
 using namespace std;
 
-SelectionObserver::SelectionObserver()
+SelectionObserver::SelectionObserver(bool resync) : resyncOnSetSelection(resync)
 {
     attachSelection();
 }
@@ -84,6 +84,8 @@ void SelectionObserver::attachSelection()
     if (!connectSelection.connected()) {
         connectSelection = Selection().signalSelectionChanged.connect(boost::bind
             (&SelectionObserver::onSelectionChanged, this, _1));
+        if (!resyncOnSetSelection)
+            Selection()._singleMessageObservers++;
     }
 }
 
@@ -91,6 +93,8 @@ void SelectionObserver::detachSelection()
 {
     if (connectSelection.connected()) {
         connectSelection.disconnect();
+        if (!resyncOnSetSelection)
+            Selection()._singleMessageObservers--;
     }
 }
 
@@ -661,6 +665,8 @@ bool SelectionSingleton::addSelection(const char* pDocName, const char* pObjectN
             temp.TypeName = temp.pObject->getTypeId().getName();
 
         _SelList.push_back(temp);
+        if (temp.pObject)
+            _SelIndex.insert(std::make_pair(SelKey(temp.pObject, temp.SubName), --_SelList.end()));
 
         SelectionChanges Chng;
 
@@ -689,34 +695,150 @@ bool SelectionSingleton::addSelection(const char* pDocName, const char* pObjectN
     }
 }
 
-void SelectionSingleton::rmvSelection(const char* pDocName, const char* pObjectName, const char* pSubName)
+bool SelectionSingleton::addSelections(const char* pDocName, const char* pObjectName, const std::vector<std::string>& pSubNames)
 {
-    std::vector<SelectionChanges> rmvList;
+    App::Document* pDoc = getDocument(pDocName);
+    if (!pDoc) {
+        Base::Console().Error("Cannot add to selection: no document '%s' found.\n", pDocName);
+        return false;
+    }
 
-    for (std::list<_SelObj>::iterator It = _SelList.begin();It != _SelList.end();) {
-        if ((It->DocName == pDocName && !pObjectName) ||
-            (It->DocName == pDocName && pObjectName && It->FeatName == pObjectName && !pSubName) ||
-            (It->DocName == pDocName && pObjectName && It->FeatName == pObjectName && pSubName && It->SubName == pSubName))
-        {
-            // save in tmp. string vars
-            std::string tmpDocName = It->DocName;
-            std::string tmpFeaName = It->FeatName;
-            std::string tmpSubName = It->SubName;
+    App::DocumentObject* pObject = pObjectName ? pDoc->getObject(pObjectName) : 0;
+    if (!pObject) {
+        Base::Console().Error("Cannot add to selection: no object '%s' found.\n", pObjectName);
+        return false;
+    }
 
-            // destroy the _SelObj item
-            It = _SelList.erase(It);
+    bool allowed = true;
+    std::vector<std::string> added;
+    for (std::vector<std::string>::const_iterator it = pSubNames.begin(); it != pSubNames.end(); ++it) {
+        // already in ?
+        if (_SelIndex.find(SelKey(pObject, *it)) != _SelIndex.end())
+            continue;
 
+        // check for a Selection Gate
+        if (ActiveGate && !ActiveGate->allow(pDoc, pObject, it->c_str())) {
+            allowed = false;
+            continue;
+        }
+
+        _SelObj temp;
+        temp.pDoc     = pDoc;
+        temp.pObject  = pObject;
+        temp.DocName  = pDoc->getName();
+        temp.FeatName = pObject->getNameInDocument();
+        temp.SubName  = *it;
+        temp.TypeName = pObject->getTypeId().getName();
+        temp.x        = 0.0f;
+        temp.y        = 0.0f;
+        temp.z        = 0.0f;
+
+        _SelList.push_back(temp);
+        _SelIndex.insert(std::make_pair(SelKey(pObject, *it), --_SelList.end()));
+        added.push_back(*it);
+    }
+
+    if (!allowed) {
+        if (getMainWindow()) {
+            getMainWindow()->showMessage(QString::fromAscii("Selection not allowed by filter"),5000);
+            Gui::MDIView* mdi = Gui::Application::Instance->activeDocument()->getActiveView();
+            mdi->setOverrideCursor(Qt::ForbiddenCursor);
+        }
+        QApplication::beep();
+    }
+
+    if (added.empty())
+        return allowed;
+
+    // the document and object name are copied as an observer may change the selection
+    std::string docName = pDoc->getName();
+    std::string objName = pObject->getNameInDocument();
+    if (_singleMessageObservers > 0) {
+        // some observers only react on AddSelection
+        for (std::vector<std::string>::const_iterator it = added.begin(); it != added.end(); ++it) {
             SelectionChanges Chng;
-            Chng.pDocName  = tmpDocName.c_str();
-            Chng.pObjectName = tmpFeaName.c_str();
-            Chng.pSubName  = tmpSubName.c_str();
-            Chng.Type      = SelectionChanges::RmvSelection;
+            Chng.pDocName  = docName.c_str();
+            Chng.pObjectName = objName.c_str();
+            Chng.pSubName  = it->c_str();
+            Chng.x         = 0.0f;
+            Chng.y         = 0.0f;
+            Chng.z         = 0.0f;
+            Chng.Type      = SelectionChanges::AddSelection;
 
             Notify(Chng);
             signalSelectionChanged(Chng);
-      
-            rmvList.push_back(Chng);
-            Base::Console().Log("Sel : Rmv Selection \"%s.%s.%s\"\n",pDocName,pObjectName,pSubName);
+        }
+    }
+    else {
+        // one notification for all added sub-elements
+        SelectionChanges Chng;
+        Chng.Type = SelectionChanges::SetSelection;
+        Chng.pDocName = docName.c_str();
+        Chng.pObjectName = "";
+        Chng.pSubName = "";
+
+        Notify(Chng);
+        signalSelectionChanged(Chng);
+    }
+
+    Base::Console().Log("Sel : Add %d selections \"%s.%s\"\n",(int)added.size(),docName.c_str(),objName.c_str());
+
+    return allowed;
+}
+
+std::list<SelectionSingleton::_SelObj>::iterator SelectionSingleton::rmvItem(std::list<_SelObj>::iterator It)
+{
+    // save in tmp. string vars
+    std::string tmpDocName = It->DocName;
+    std::string tmpFeaName = It->FeatName;
+    std::string tmpSubName = It->SubName;
+
+    // destroy the _SelObj item
+    if (It->pObject)
+        _SelIndex.erase(SelKey(It->pObject, It->SubName));
+    It = _SelList.erase(It);
+
+    SelectionChanges Chng;
+    Chng.pDocName  = tmpDocName.c_str();
+    Chng.pObjectName = tmpFeaName.c_str();
+    Chng.pSubName  = tmpSubName.c_str();
+    Chng.Type      = SelectionChanges::RmvSelection;
+
+    Notify(Chng);
+    signalSelectionChanged(Chng);
+
+    Base::Console().Log("Sel : Rmv Selection \"%s.%s.%s\"\n",tmpDocName.c_str(),tmpFeaName.c_str(),tmpSubName.c_str());
+    return It;
+}
+
+void SelectionSingleton::rmvSelection(const char* pDocName, const char* pObjectName, const char* pSubName)
+{
+    App::Document* pDoc = App::GetApplication().getDocument(pDocName);
+    App::DocumentObject* pObject = (pDoc && pObjectName) ? pDoc->getObject(pObjectName) : 0;
+
+    if (pObject) {
+        // use the index to find the items of the object, look them up again after
+        // each removal because an observer may change the selection
+        std::map<SelKey, std::list<_SelObj>::iterator>::iterator it;
+        if (pSubName) {
+            it = _SelIndex.find(SelKey(pObject, pSubName));
+            if (it != _SelIndex.end())
+                rmvItem(it->second);
+        }
+        else {
+            while ((it = _SelIndex.lower_bound(SelKey(pObject, std::string()))) != _SelIndex.end() &&
+                   it->first.first == pObject)
+                rmvItem(it->second);
+        }
+        return;
+    }
+
+    for (std::list<_SelObj>::iterator It = _SelList.begin();It != _SelList.end();) {
+        if ((It->DocName == pDocName && !pObjectName) ||
+            (It->DocName == pDocName && pObjectName && It->FeatName == pObjectName && !pSubName) ||
+            (It->DocName == pDocName && pObjectName && It->FeatName == pObjectName && pSubName && It->SubName == pSubName))
+        {
+            It = rmvItem(It);
         }
         else {
             ++It;
@@ -724,6 +846,15 @@ void SelectionSingleton::rmvSelection(const char* pDocName, const char* pObjectN
     }
 }
 
+void SelectionSingleton::rebuildIndex()
+{
+    _SelIndex.clear();
+    for (std::list<_SelObj>::iterator It = _SelList.begin(); It != _SelList.end(); ++It) {
+        if (It->pObject)
+            _SelIndex.insert(std::make_pair(SelKey(It->pObject, It->SubName), It));
+    }
+}
+
 void SelectionSingleton::setSelection(const char* pDocName, const std::vector<App::DocumentObject*>& sel)
 {
     App::Document *pcDoc;
@@ -769,6 +900,7 @@ void SelectionSingleton::setSelection(const char* pDocName, const std::vector<Ap
         return;
 
     _SelList = temp;
+    rebuildIndex();
 
     SelectionChanges Chng;
     Chng.Type = SelectionChanges::SetSelection;
@@ -802,6 +934,7 @@ void SelectionSingleton::clearSelection(const char* pDocName)
         }
 
         _SelList = selList;
+        rebuildIndex();
 
         SelectionChanges Chng;
         Chng.Type = SelectionChanges::ClrSelection;
@@ -819,6 +952,7 @@ void SelectionSingleton::clearSelection(const char* pDocName)
 void SelectionSingleton::clearCompleteSelection()
 {
     _SelList.clear();
+    _SelIndex.clear();
 
     SelectionChanges Chng;
     Chng.Type = SelectionChanges::ClrSelection;
@@ -838,6 +972,13 @@ bool SelectionSingleton::isSelected(const char* pDocName, const char* pObjectNam
     const char* tmpDocName = pDocName ? pDocName : "";
     const char* tmpFeaName = pObjectName ? pObjectName : "";
     const char* tmpSubName = pSubName ? pSubName : "";
+
+    // items with an existing object are in the index
+    App::Document* pDoc = App::GetApplication().getDocument(tmpDocName);
+    App::DocumentObject* pObject = pDoc ? pDoc->getObject(tmpFeaName) : 0;
+    if (pObject)
+        return _SelIndex.find(SelKey(pObject, tmpSubName)) != _SelIndex.end();
+
     for (std::list<_SelObj>::const_iterator It = _SelList.begin();It != _SelList.end();++It)
         if (It->DocName == tmpDocName && It->FeatName == tmpFeaName && It->SubName == tmpSubName)
             return true;
@@ -848,19 +989,11 @@ bool SelectionSingleton::isSelected(App::DocumentObject* obj, const char* pSubNa
 {
     if (!obj) return false;
 
-    for(list<_SelObj>::const_iterator It = _SelList.begin();It != _SelList.end();++It) {
-        if (It->pObject == obj) {
-            if (pSubName) {
-                if (It->SubName == pSubName)
-                    return true;
-            }
-            else {
-                return true;
-            }
-        }
-    }
+    if (pSubName)
+        return _SelIndex.find(SelKey(obj, pSubName)) != _SelIndex.end();
 
-    return false;
+    std::map<SelKey, std::list<_SelObj>::iterator>::const_iterator it = _SelIndex.lower_bound(SelKey(obj, std::string()));
+    return it != _SelIndex.end() && it->first.first == obj;
 }
 
 void SelectionSingleton::slotDeletedObject(const App::DocumentObject& Obj)
@@ -891,6 +1024,7 @@ void SelectionSingleton::slotRenamedObject(const App::DocumentObject& Obj)
 SelectionSingleton::SelectionSingleton()
 {
     ActiveGate = 0;
+    _singleMessageObservers = 0;
     App::GetApplication().signalDeletedObject.connect(boost::bind(&Gui::SelectionSingleton::slotDeletedObject, this, _1));
     App::GetApplication().signalRenamedObject.connect(boost::bind(&Gui::SelectionSingleton::slotRenamedObject, this, _1));
     CurrentPreselection.pDocName = 0;
@@ -947,6 +1081,10 @@ PyMethodDef SelectionSingleton::Methods[] = {
     {"addSelection",         (PyCFunction) SelectionSingleton::sAddSelection, 1, 
      "addSelection(object,[string,float,float,float]) -- Add an object to the selection\n"
      "where string is the sub-element name and the three floats represent a 3d point"},
+    {"addSelections",        (PyCFunction) SelectionSingleton::sAddSelections, 1,
+     "addSelections(object,list) -- Add several sub-elements of an object to the selection\n"
+     "where list contains the sub-element names. In contrast to addSelection the observers\n"
+     "are notified only once unless one of them only handles single additions."},
     {"removeSelection",      (PyCFunction) SelectionSingleton::sRemoveSelection, 1,
      "removeSelection(object) -- Remove an object from the selection"},
     {"clearSelection"  ,     (PyCFunction) SelectionSingleton::sClearSelection, 1,
@@ -1009,6 +1147,44 @@ PyObject *SelectionSingleton::sAddSelection(PyObject * /*self*/, PyObject *args,
     Py_Return;
 }
 
+PyObject *SelectionSingleton::sAddSelections(PyObject * /*self*/, PyObject *args, PyObject * /*kwd*/)
+{
+    PyObject *object;
+    PyObject *sequence;
+    if (!PyArg_ParseTuple(args, "O!O", &(App::DocumentObjectPy::Type),&object,&sequence))
+        return NULL;                             // NULL triggers exception 
+
+    App::DocumentObjectPy* docObjPy = static_cast<App::DocumentObjectPy*>(object);
+    App::DocumentObject* docObj = docObjPy->getDocumentObjectPtr();
+    if (!docObj || !docObj->getNameInDocument()) {
+        PyErr_SetString(PyExc_Exception, "Cannot check invalid object");
+        return NULL;
+    }
+
+    std::vector<std::string> subnames;
+    // a string is a sequence too but would be split into single characters
+    if (PySequence_Check(sequence) && !PyString_Check(sequence) && !PyUnicode_Check(sequence)) {
+        Py::Sequence list(sequence);
+        for (Py::Sequence::iterator it = list.begin(); it != list.end(); ++it) {
+            if (!(*it).isString()) {
+                PyErr_SetString(PyExc_TypeError, "list of sub-element names expected");
+                return NULL;
+            }
+            subnames.push_back((std::string)Py::String(*it));
+        }
+    }
+    else {
+        PyErr_SetString(PyExc_TypeError, "list of sub-element names expected");
+        return NULL;
+    }
+
+    Selection().addSelections(docObj->getDocument()->getName(),
+                              docObj->getNameInDocument(),
+                              subnames);
+
+    Py_Return;
+}
+
 PyObject *SelectionSingleton::sRemoveSelection(PyObject * /*self*/, PyObject *args, PyObject * /*kwd*/)
 {
     PyObject *object;
@@ -118,8 +118,12 @@ class GuiExport SelectionObserver
 {
 
 public:
-    /// Constructor
-    SelectionObserver();
+    /** Constructor
+     * If \a resyncOnSetSelection is true the observer updates itself from the
+     * selection on a SetSelection message. Otherwise it gets an AddSelection
+     * message for every element added with SelectionSingleton::addSelections().
+     */
+    SelectionObserver(bool resyncOnSetSelection = false);
     virtual ~SelectionObserver();
     bool blockConnection(bool block);
     bool isConnectionBlocked() const;
@@ -135,6 +139,7 @@ private:
 private:
     typedef boost::signals::connection Connection;
     Connection connectSelection;
+    bool resyncOnSetSelection;
 };
 
 /**
@@ -200,6 +205,13 @@ class GuiExport SelectionSingleton : public Base::Subject<const SelectionChanges
 public:
     /// Add to selection 
     bool addSelection(const char* pDocName, const char* pObjectName=0, const char* pSubName=0, float x=0, float y=0, float z=0);
+    /** Add several sub-elements of an object to the selection at once.
+     * In contrast to addSelection() the observers are notified only once
+     * with a SetSelection message for the document. Many observers only react
+     * on AddSelection, so as long as one of them is attached an AddSelection
+     * message is sent for every added sub-element instead.
+     */
+    bool addSelections(const char* pDocName, const char* pObjectName, const std::vector<std::string>& pSubNames);
     /// Remove from selection (for internal use)
     void rmvSelection(const char* pDocName, const char* pObjectName=0, const char* pSubName=0);
     /// Set the selection for a document
@@ -303,6 +315,7 @@ public:
 
 protected:
     static PyObject *sAddSelection        (PyObject *self,PyObject *args,PyObject *kwd);
+    static PyObject *sAddSelections       (PyObject *self,PyObject *args,PyObject *kwd);
     static PyObject *sRemoveSelection     (PyObject *self,PyObject *args,PyObject *kwd);
     static PyObject *sClearSelection      (PyObject *self,PyObject *args,PyObject *kwd);
     static PyObject *sIsSelected          (PyObject *self,PyObject *args,PyObject *kwd);
@@ -340,6 +353,16 @@ protected:
         float x,y,z;
     };
     std::list<_SelObj> _SelList;
+    /// rebuilds the index after the selection list has been replaced
+    void rebuildIndex();
+    /// removes an item from the selection list and the index and notifies the observers
+    std::list<_SelObj>::iterator rmvItem(std::list<_SelObj>::iterator);
+    // the items of the selection list with an object, looked up by object and sub-element
+    typedef std::pair<App::DocumentObject*, std::string> SelKey;
+    std::map<SelKey, std::list<_SelObj>::iterator> _SelIndex;
+    // the number of attached observers that don't resync on SetSelection
+    int _singleMessageObservers;
+    friend class SelectionObserver;
 
     static SelectionSingleton* _pcSingleton;
 
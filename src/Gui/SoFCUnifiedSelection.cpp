@@ -287,15 +287,50 @@ void SoFCUnifiedSelection::doAction(SoAction *action)
         else if (selaction->SelChange.Type == SelectionChanges::ClrSelection ||
                  selaction->SelChange.Type == SelectionChanges::SetSelection) {
             std::vector<ViewProvider*> vps;
-            if (this->pcDocument)
+            // the selected sub-elements of each object of the document
+            std::map<App::DocumentObject*, std::vector<const char*> > selMap;
+            if (this->pcDocument) {
                 vps = this->pcDocument->getViewProvidersOfType(ViewProviderDocumentObject::getClassTypeId());
+                std::vector<SelectionSingleton::SelObj> sel = Selection().getSelection
+                    (this->pcDocument->getDocument()->getName());
+                for (std::vector<SelectionSingleton::SelObj>::iterator jt = sel.begin(); jt != sel.end(); ++jt)
+                    selMap[jt->pObject].push_back(jt->SubName);
+            }
             for (std::vector<ViewProvider*>::iterator it = vps.begin(); it != vps.end(); ++it) {
                 ViewProviderDocumentObject* vpd = static_cast<ViewProviderDocumentObject*>(*it);
                 if (vpd->useNewSelectionModel()) {
-                    if (Selection().isSelected(vpd->getObject()) && vpd->isSelectable()) {
-                        SoSelectionElementAction action(SoSelectionElementAction::All);
-                        action.setColor(this->colorSelection.getValue());
-                        action.apply(vpd->getRoot());
+                    std::map<App::DocumentObject*, std::vector<const char*> >::iterator jt = selMap.find(vpd->getObject());
+                    if (jt != selMap.end() && vpd->isSelectable()) {
+                        // collect the details of all selected sub-elements, if the whole
+                        // object or an unknown sub-element is selected highlight everything
+                        std::vector<const SoDetail*> details;
+                        bool all = false;
+                        for (std::vector<const char*>::iterator kt = jt->second.begin(); kt != jt->second.end(); ++kt) {
+                            SoDetail* detail = vpd->getDetail(*kt);
+                            if (!detail) {
+                                all = true;
+                                break;
+                            }
+                            details.push_back(detail);
+                        }
+
+                        if (all) {
+                            SoSelectionElementAction action(SoSelectionElementAction::All);
+                            action.setColor(this->colorSelection.getValue());
+                            action.apply(vpd->getRoot());
+                        }
+                        else {
+                            SoSelectionElementAction action(SoSelectionElementAction::None);
+                            action.setColor(this->colorSelection.getValue());
+                            action.apply(vpd->getRoot());
+                            SoSelectionElementAction append(SoSelectionElementAction::Append);
+                            append.setColor(this->colorSelection.getValue());
+                            append.setElements(details);
+                            append.apply(vpd->getRoot());
+                        }
+
+                        for (std::vector<const SoDetail*>::iterator kt = details.begin(); kt != details.end(); ++kt)
+                            delete *kt;
                     }
                     else {
                         SoSelectionElementAction action(SoSelectionElementAction::None);
@@ -603,7 +638,7 @@ void SoSelectionElementAction::initClass()
     SO_ACTION_ADD_METHOD(SoPointSet,callDoAction);
 }
 
-SoSelectionElementAction::SoSelectionElementAction (Type t) : _type(t), _select(FALSE), _det(0)
+SoSelectionElementAction::SoSelectionElementAction (Type t) : _type(t), _select(FALSE)
 {
     SO_ACTION_CONSTRUCTOR(SoSelectionElementAction);
 }
@@ -640,10 +675,22 @@ const SbColor& SoSelectionElementAction::getColor() const
 
 void SoSelectionElementAction::setElement(const SoDetail* det)
 {
-    this->_det = det;
+    this->_det.clear();
+    if (det)
+        this->_det.push_back(det);
 }
 
 const SoDetail* SoSelectionElementAction::getElement() const
+{
+    return this->_det.empty() ? 0 : this->_det.front();
+}
+
+void SoSelectionElementAction::setElements(const std::vector<const SoDetail*>& det)
+{
+    this->_det = det;
+}
+
+const std::vector<const SoDetail*>& SoSelectionElementAction::getElements() const
 {
     return this->_det;
 }
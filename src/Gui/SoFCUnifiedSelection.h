@@ -160,6 +160,9 @@ public:
     const SbColor& getColor() const;
     void setElement(const SoDetail*);
     const SoDetail* getElement() const;
+    /// Set several elements to be handled in a single traversal
+    void setElements(const std::vector<const SoDetail*>&);
+    const std::vector<const SoDetail*>& getElements() const;
 
     static void initClass();
 
@@ -173,7 +176,7 @@ private:
     Type _type;
     SbBool _select;
     SbColor _color;
-    const SoDetail* _det;
+    std::vector<const SoDetail*> _det;
 };
 
 
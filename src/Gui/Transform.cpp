@@ -216,7 +216,8 @@ void TransformStrategy::resetViewTransform(App::DocumentObject* obj)
 
 // ----------------------------------------------------------------------------
 
-DefaultTransformStrategy::DefaultTransformStrategy(QWidget* w) : widget(w)
+DefaultTransformStrategy::DefaultTransformStrategy(QWidget* w)
+  : SelectionObserver(true), widget(w)
 {
     Gui::SelectionChanges mod;
     mod.Type = Gui::SelectionChanges::SetSelection;
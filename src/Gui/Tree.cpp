@@ -61,7 +61,7 @@ const int TreeWidget::ObjectType = 1001;
 
 /* TRANSLATOR Gui::TreeWidget */
 TreeWidget::TreeWidget(QWidget* parent)
-    : QTreeWidget(parent), fromOutside(false)
+    : QTreeWidget(parent), SelectionObserver(true), fromOutside(false)
 {
     this->setDragEnabled(true);
     this->setAcceptDrops(true);
@@ -25,11 +25,17 @@
 #include <gp_Pnt.hxx>
 #include <BRepExtrema_DistShapeShape.hxx>
 #include <BRepBuilderAPI_MakeVertex.hxx>
+#include <BRep_Tool.hxx>
+#include <Poly_Triangulation.hxx>
+#include <Standard_Failure.hxx>
+#include <TopExp.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Face.hxx>
 #include <TopoDS_Vertex.hxx>
+#include <TopTools_IndexedDataMapOfShapeListOfShape.hxx>
 
-#include <QEventLoop>
-#include <QFuture>
-#include <QFutureWatcher>
+#include <QThread>
 #include <QtConcurrentMap>
 
 #include <boost/signals.hpp>
@@ -37,7 +43,6 @@
 
 #include <Base/Console.h>
 #include <Base/Exception.h>
-#include <Base/FutureWatcherProgress.h>
 #include <Base/Parameter.h>
 #include <Base/Sequencer.h>
 #include <Base/Tools.h>
@@ -49,7 +54,7 @@
 #include <Mod/Mesh/App/Core/Iterator.h>
 #include <Mod/Mesh/App/Core/MeshKernel.h>
 #include <Mod/Points/App/PointsFeature.h>
-#include <Mod/Points/App/PointsGrid.h>
+#include <Mod/Points/App/PointsTree.h>
 #include <Mod/Part/App/PartFeature.h>
 
 #include "InspectionFeature.h"
@@ -74,8 +79,10 @@ unsigned long InspectActualMesh::countPoints() const
 
 Base::Vector3f InspectActualMesh::getPoint(unsigned long index)
 {
-    _iter.Set(index);
-    return *_iter;
+    // use a copy of the iterator to be thread-safe
+    MeshCore::MeshPointIterator iter(_iter);
+    iter.Set(index);
+    return *iter;
 }
 
 // ----------------------------------------------------------------
@@ -176,8 +183,14 @@ namespace Inspection {
             assert((rulX < _ulCtGridsX) && (rulY < _ulCtGridsY) && (rulZ < _ulCtGridsZ));
         }
 
-        void AddFacet (const MeshCore::MeshGeomFacet &rclFacet, unsigned long ulFacetIndex)
+        void FindCells (unsigned long ulFacetIndex, std::vector<unsigned long> &raulCells) const
         {
+            const MeshCore::MeshFacet& rFace = _pclMesh->GetFacets()[ulFacetIndex];
+            const MeshCore::MeshPointArray& rPoints = _pclMesh->GetPoints();
+            MeshCore::MeshGeomFacet rclFacet;
+            for (int i=0; i<3; i++)
+                rclFacet._aclPoints[i] = _transform * rPoints[rFace._aulPoints[i]];
+
             unsigned long ulX, ulY, ulZ;
             unsigned long ulX1, ulY1, ulZ1, ulX2, ulY2, ulZ2;
 
@@ -195,19 +208,17 @@ namespace Inspection {
                     for (ulY = ulY1; ulY <= ulY2; ulY++) {
                         for (ulZ = ulZ1; ulZ <= ulZ2; ulZ++) {
                             if (rclFacet.IntersectBoundingBox(GetBoundBox(ulX, ulY, ulZ)))
-                                _aulGrid[ulX][ulY][ulZ].insert(ulFacetIndex);
+                                raulCells.push_back(CellIndex(ulX, ulY, ulZ));
                         }
                     }
                 }
             }
             else
-                _aulGrid[ulX1][ulY1][ulZ1].insert(ulFacetIndex);
+                raulCells.push_back(CellIndex(ulX1, ulY1, ulZ1));
         }
 
         void InitGrid (void)
         {
-            unsigned long i, j;
-
             Base::BoundBox3f clBBMesh = _pclMesh->GetBoundBox().Transformed(_transform);
 
             float fLengthX = clBBMesh.LengthX(); 
@@ -223,26 +234,16 @@ namespace Inspection {
             _fGridLenZ = (1.0f + fLengthZ) / float(_ulCtGridsZ);
             _fMinZ = clBBMesh.MinZ - 0.5f;
 
-            _aulGrid.clear();
-            _aulGrid.resize(_ulCtGridsX);
-            for (i = 0; i < _ulCtGridsX; i++) {
-                _aulGrid[i].resize(_ulCtGridsY);
-                for (j = 0; j < _ulCtGridsY; j++)
-                    _aulGrid[i][j].resize(_ulCtGridsZ);
-            }
+            _aulOffsets.clear();
+            _aulOffsets.resize(_ulCtGridsX * _ulCtGridsY * _ulCtGridsZ + 1, 0);
+            _aulElements.clear();
         }
 
         void RebuildGrid (void)
         {
             _ulCtElements = _pclMesh->CountFacets();
             InitGrid();
- 
-            unsigned long i = 0;
-            MeshCore::MeshFacetIterator clFIter(*_pclMesh);
-            clFIter.Transform(_transform);
-            for (clFIter.Init(); clFIter.More(); clFIter.Next()) {
-                AddFacet(*clFIter, i++);
-            }
+            BuildGrid();
         }
 
     private:
@@ -293,14 +294,16 @@ float InspectNominalMesh::getDistance(const Base::Vector3f& point)
         indices.insert(indices.begin(), inds.begin(), inds.end());
     }
 
+    // use a copy of the iterator to be thread-safe
+    MeshCore::MeshFacetIterator iter(_iter);
     float fMinDist=FLT_MAX;
     bool positive = true;
     for (std::vector<unsigned long>::iterator it = indices.begin(); it != indices.end(); ++it) {
-        _iter.Set(*it);
-        float fDist = _iter->DistanceToPoint(point);
+        iter.Set(*it);
+        float fDist = iter->DistanceToPoint(point);
         if (fabs(fDist) < fabs(fMinDist)) {
             fMinDist = fDist;
-            positive = point.DistanceToPlane(_iter->_aclPoints[0], _iter->GetNormal()) > 0;
+            positive = point.DistanceToPlane(iter->_aclPoints[0], iter->GetNormal()) > 0;
         }
     }
 
@@ -366,14 +369,16 @@ float InspectNominalFastMesh::getDistance(const Base::Vector3f& point)
         _pGrid->GetHull(ulX, ulY, ulZ, ulLevel, indices);
 #endif
 
+    // use a copy of the iterator to be thread-safe
+    MeshCore::MeshFacetIterator iter(_iter);
     float fMinDist=FLT_MAX;
     bool positive = true;
     for (std::set<unsigned long>::iterator it = indices.begin(); it != indices.end(); ++it) {
-        _iter.Set(*it);
-        float fDist = _iter->DistanceToPoint(point);
+        iter.Set(*it);
+        float fDist = iter->DistanceToPoint(point);
         if (fabs(fDist) < fabs(fMinDist)) {
             fMinDist = fDist;
-            positive = point.DistanceToPlane(_iter->_aclPoints[0], _iter->GetNormal()) > 0;
+            positive = point.DistanceToPlane(iter->_aclPoints[0], iter->GetNormal()) > 0;
         }
     }
 
@@ -386,57 +391,169 @@ float InspectNominalFastMesh::getDistance(const Base::Vector3f& point)
 
 InspectNominalPoints::InspectNominalPoints(const Points::PointKernel& Kernel, float offset) : _rKernel(Kernel)
 {
-    int uGridPerAxis = 50; // totally 125.000 grid elements 
-    this->_pGrid = new Points::PointsGrid (Kernel, uGridPerAxis);
+    this->_pTree = new Points::PointsTree(Kernel);
 }
 
 InspectNominalPoints::~InspectNominalPoints()
 {
-    delete this->_pGrid;
+    delete this->_pTree;
 }
 
 float InspectNominalPoints::getDistance(const Base::Vector3f& point)
 {
-    //TODO: Make faster
-    std::set<unsigned long> indices;
-    unsigned long x,y,z;
+    unsigned long index;
+    double fMinDist;
     Base::Vector3d pointd(point.x,point.y,point.z);
-    _pGrid->Position(pointd, x, y, z);
-    _pGrid->GetElements(x,y,z,indices);
-
-    double fMinDist=DBL_MAX;
-    for (std::set<unsigned long>::iterator it = indices.begin(); it != indices.end(); ++it) {
-        Base::Vector3d pt = _rKernel.getPoint(*it);
-        double fDist = Base::Distance(pointd, pt);
-        if (fDist < fMinDist) {
-            fMinDist = fDist;
-        }
-    }
+    if (!_pTree->FindNearest(pointd, index, fMinDist))
+        fMinDist = DBL_MAX;
 
     return (float)fMinDist;
 }
 
 // ----------------------------------------------------------------
 
-InspectNominalShape::InspectNominalShape(const TopoDS_Shape& shape, float radius) : _rShape(shape)
+namespace Inspection {
+// checks whether all edges and vertices of the shape belong to a face
+static bool hasOnlyFaces(const TopoDS_Shape& shape)
+{
+    TopExp_Explorer xp(shape, TopAbs_FACE);
+    if (!xp.More())
+        return false;
+    TopTools_IndexedDataMapOfShapeListOfShape edge2Face;
+    TopExp::MapShapesAndAncestors(shape, TopAbs_EDGE, TopAbs_FACE, edge2Face);
+    for (int i=1; i<=edge2Face.Extent(); i++) {
+        if (edge2Face.FindFromIndex(i).IsEmpty())
+            return false;
+    }
+    TopTools_IndexedDataMapOfShapeListOfShape vertex2Edge;
+    TopExp::MapShapesAndAncestors(shape, TopAbs_VERTEX, TopAbs_EDGE, vertex2Edge);
+    for (int i=1; i<=vertex2Edge.Extent(); i++) {
+        if (vertex2Edge.FindFromIndex(i).IsEmpty())
+            return false;
+    }
+    return true;
+}
+}
+
+InspectNominalShape::InspectNominalShape(const TopoDS_Shape& shape, float radius)
+  : _rShape(shape), _mesh(0), _pGrid(0), _tolerance(0.0f)
 {
-    distss = new BRepExtrema_DistShapeShape();
-    distss->LoadS1(_rShape);
     //distss->SetDeflection(radius);
+
+    // Points far away from the shape are sorted out with the help of a coarse
+    // tessellation before the expensive exact distance computation. This only
+    // works if the whole shape is covered by faces.
+    if (!hasOnlyFaces(_rShape))
+        return;
+
+    ParameterGrp::handle hGrp = App::GetApplication().GetParameterGroupByPath
+        ("User parameter:BaseApp/Preferences/Mod/Part");
+    float deviation = hGrp->GetFloat("MeshDeviation",0.2);
+
+    Part::TopoShape topo(_rShape);
+    Base::BoundBox3d bbox = topo.getBoundBox();
+    Standard_Real deflection = (bbox.LengthX() + bbox.LengthY() + bbox.LengthZ())/300.0 * deviation;
+
+    std::vector<Base::Vector3d> points;
+    std::vector<Data::ComplexGeoData::Facet> facets;
+    topo.getFaces(points, facets, (float)deflection);
+
+    // if a face couldn't be tessellated points near to it would be sorted out
+    for (TopExp_Explorer xp(_rShape, TopAbs_FACE); xp.More(); xp.Next()) {
+        TopLoc_Location loc;
+        if (BRep_Tool::Triangulation(TopoDS::Face(xp.Current()), loc).IsNull())
+            return;
+    }
+    if (facets.empty())
+        return;
+
+    MeshCore::MeshPointArray meshPoints;
+    meshPoints.reserve(points.size());
+    for (std::vector<Base::Vector3d>::iterator it = points.begin(); it != points.end(); ++it)
+        meshPoints.push_back(Base::toVector<float>(*it));
+    MeshCore::MeshFacetArray meshFacets;
+    meshFacets.reserve(facets.size());
+    for (std::vector<Data::ComplexGeoData::Facet>::iterator it = facets.begin(); it != facets.end(); ++it) {
+        MeshCore::MeshFacet face;
+        face._aulPoints[0] = it->I1;
+        face._aulPoints[1] = it->I2;
+        face._aulPoints[2] = it->I3;
+        meshFacets.push_back(face);
+    }
+
+    _mesh = new MeshCore::MeshKernel();
+    _mesh->Adopt(meshPoints, meshFacets, false);
+    _pGrid = new MeshCore::MeshFacetGrid(*_mesh);
+    // the tessellation deviates from the shape by the deflection
+    _tolerance = radius + 2.0f * (float)deflection;
 }
 
 InspectNominalShape::~InspectNominalShape()
 {
-    delete distss;
+    for (std::vector<BRepExtrema_DistShapeShape*>::iterator it = distss.begin(); it != distss.end(); ++it)
+        delete *it;
+    delete _pGrid;
+    delete _mesh;
+}
+
+BRepExtrema_DistShapeShape* InspectNominalShape::acquire()
+{
+    {
+        QMutexLocker locker(&mutex);
+        if (!distss.empty()) {
+            BRepExtrema_DistShapeShape* dist = distss.back();
+            distss.pop_back();
+            return dist;
+        }
+    }
+
+    // there is no free one for this thread
+    BRepExtrema_DistShapeShape* dist = new BRepExtrema_DistShapeShape();
+    dist->LoadS1(_rShape);
+    return dist;
+}
+
+void InspectNominalShape::release(BRepExtrema_DistShapeShape* dist)
+{
+    QMutexLocker locker(&mutex);
+    distss.push_back(dist);
+}
+
+bool InspectNominalShape::isInRange(const Base::Vector3f& point) const
+{
+    if (!_pGrid)
+        return true;
+
+    Base::BoundBox3f box(point.x - _tolerance, point.y - _tolerance, point.z - _tolerance,
+                         point.x + _tolerance, point.y + _tolerance, point.z + _tolerance);
+    if (!(box && _mesh->GetBoundBox()))
+        return false;
+    std::vector<unsigned long> indices;
+    _pGrid->Inside(box, indices);
+    for (std::vector<unsigned long>::iterator it = indices.begin(); it != indices.end(); ++it) {
+        if (_mesh->GetFacet(*it).DistanceToPoint(point) <= _tolerance)
+            return true;
+    }
+
+    return false;
 }
 
 float InspectNominalShape::getDistance(const Base::Vector3f& point)
 {
-    BRepBuilderAPI_MakeVertex mkVert(gp_Pnt(point.x,point.y,point.z));
-    distss->LoadS2(mkVert.Vertex());
     float fMinDist=FLT_MAX;
-    if (distss->Perform() && distss->NbSolution() > 0)
-        fMinDist = (float)distss->Value();
+    if (!isInRange(point))
+        return fMinDist;
+
+    BRepBuilderAPI_MakeVertex mkVert(gp_Pnt(point.x,point.y,point.z));
+    BRepExtrema_DistShapeShape* dist = acquire();
+    try {
+        dist->LoadS2(mkVert.Vertex());
+        if (dist->Perform() && dist->NbSolution() > 0)
+            fMinDist = (float)dist->Value();
+    }
+    catch (Standard_Failure) {
+    }
+    release(dist);
     return fMinDist;
 }
 
@@ -467,15 +584,14 @@ int PropertyDistanceList::getSize(void) const
 void PropertyDistanceList::setValue(float lValue)
 {
     aboutToSetValue();
-    _lValueList.resize(1);
-    _lValueList[0]=lValue;
+    _lValueList.set(std::vector<float>(1, lValue));
     hasSetValue();
 }
 
 void PropertyDistanceList::setValues(const std::vector<float>& values)
 {
     aboutToSetValue();
-    _lValueList = values;
+    _lValueList.set(values);
     hasSetValue();
 }
 
@@ -582,7 +698,7 @@ void PropertyDistanceList::Paste(const App::Property &from)
 
 unsigned int PropertyDistanceList::getMemSize (void) const
 {
-    return static_cast<unsigned int>(_lValueList.size() * sizeof(float));
+    return _lValueList.getMemSize();
 }
 
 // ----------------------------------------------------------------
@@ -592,11 +708,20 @@ struct DistanceInspection
 {
 
     DistanceInspection(float radius, InspectActualGeometry*  a,
-                       std::vector<InspectNominalGeometry*> n)
-                    : radius(radius), actual(a), nominal(n)
+                       std::vector<InspectNominalGeometry*> n,
+                       std::vector<float>& v)
+                    : radius(radius), actual(a), nominal(n), vals(v)
+    {
+    }
+    void mapped(const std::pair<unsigned long, unsigned long>& range)
     {
+        // skip the remaining ranges if the user cancelled
+        if (Base::Sequencer().wasCanceled())
+            return;
+        for (unsigned long index = range.first; index < range.second; index++)
+            vals[index] = distance(index);
     }
-    float mapped(unsigned long index)
+    float distance(unsigned long index)
     {
         Base::Vector3f pnt = actual->getPoint(index);
 
@@ -618,6 +743,7 @@ struct DistanceInspection
     float radius;
     InspectActualGeometry*  actual;
     std::vector<InspectNominalGeometry*> nominal;
+    std::vector<float>& vals;
 };
 
 PROPERTY_SOURCE(Inspection::Feature, App::DocumentObject)
@@ -693,52 +819,47 @@ App::DocumentObjectExecReturn* Feature::execute(void)
             inspectNominal.push_back(nominal);
     }
 
-#if 0 // test with some huge data sets
-    Standard::SetReentrant(Standard_True);
-    std::vector<unsigned long> index(actual->countPoints());
-    std::generate(index.begin(), index.end(), Base::iotaGen<unsigned long>(0));
-    DistanceInspection check(this->SearchRadius.getValue(), actual, inspectNominal);
-    QFuture<float> future = QtConcurrent::mapped
-        (index, boost::bind(&DistanceInspection::mapped, &check, _1));
-    //future.waitForFinished(); // blocks the GUI
-    Base::FutureWatcherProgress progress("Inspecting...", actual->countPoints());
-    QFutureWatcher<float> watcher;
-    QObject::connect(&watcher, SIGNAL(progressValueChanged(int)),
-                     &progress, SLOT(progressValueChanged(int)));
-    watcher.setFuture(future);
-
-    // keep it responsive during computation
-    QEventLoop loop;
-    QObject::connect(&watcher, SIGNAL(finished()), &loop, SLOT(quit()));
-    loop.exec();
-
-    std::vector<float> vals;
-    vals.insert(vals.end(), future.begin(), future.end());
-#else
     unsigned long count = actual->countPoints();
     std::stringstream str;
     str << "Inspecting " << this->Label.getValue() << "...";
-    Base::SequencerLauncher seq(str.str().c_str(), count);
 
     std::vector<float> vals(count);
-    for (unsigned long index = 0; index < count; index++) {
-        Base::Vector3f pnt = actual->getPoint(index);
-
-        float fMinDist=FLT_MAX;
-        for (std::vector<InspectNominalGeometry*>::iterator it = inspectNominal.begin(); it != inspectNominal.end(); ++it) {
-            float fDist = (*it)->getDistance(pnt);
-            if (fabs(fDist) < fabs(fMinDist))
-                fMinDist = fDist;
+    DistanceInspection check(this->SearchRadius.getValue(), actual, inspectNominal, vals);
+    try {
+        if (count >= 1000 && QThread::idealThreadCount() > 1) {
+            // check the points in ranges to keep the overhead low
+            unsigned long step = std::max<unsigned long>(count / 1000, 100);
+            std::vector<std::pair<unsigned long, unsigned long> > ranges;
+            for (unsigned long i = 0; i < count; i += step)
+                ranges.push_back(std::make_pair(i, std::min<unsigned long>(i + step, count)));
+
+            // The ranges are checked in groups without an event loop because this runs
+            // during a recompute. The progress and a cancellation are handled between
+            // the groups.
+            std::size_t group = 2 * QThread::idealThreadCount();
+            Base::SequencerLauncher seq(str.str().c_str(), ranges.size());
+            for (std::size_t i = 0; i < ranges.size(); i += group) {
+                std::vector<std::pair<unsigned long, unsigned long> >::iterator first = ranges.begin() + i;
+                std::vector<std::pair<unsigned long, unsigned long> >::iterator last = ranges.begin() + std::min(i + group, ranges.size());
+                QtConcurrent::blockingMap(first, last, boost::bind(&DistanceInspection::mapped, &check, _1));
+                for (; first != last; ++first)
+                    seq.next(true); // allow to cancel
+            }
+        }
+        else {
+            Base::SequencerLauncher seq(str.str().c_str(), count);
+            for (unsigned long index = 0; index < count; index++) {
+                vals[index] = check.distance(index);
+                seq.next(true); // allow to cancel
+            }
         }
-
-        if (fMinDist > this->SearchRadius.getValue())
-            fMinDist = FLT_MAX;
-        else if (-fMinDist > this->SearchRadius.getValue())
-            fMinDist = -FLT_MAX;
-        vals[index] = fMinDist;
-        seq.next();
     }
-#endif
+    catch (...) {
+        delete actual;
+        for (std::vector<InspectNominalGeometry*>::iterator it = inspectNominal.begin(); it != inspectNominal.end(); ++it)
+            delete *it;
+        throw;
+    }
 
     Distances.setValues(vals);
 
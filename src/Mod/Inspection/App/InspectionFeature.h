@@ -24,6 +24,8 @@
 #ifndef INSPECTION_FEATURE_H
 #define INSPECTION_FEATURE_H
 
+#include <QMutex>
+
 #include <App/DocumentObject.h>
 #include <App/PropertyLinks.h>
 #include <App/DocumentObjectGroup.h>
@@ -37,16 +39,19 @@ class BRepExtrema_DistShapeShape;
 namespace MeshCore {
 class MeshKernel;
 class MeshGrid;
+class MeshFacetGrid;
 }
 
 namespace Mesh   { class MeshObject; }
-namespace Points { class PointsGrid; }
+namespace Points { class PointsTree; }
 namespace Part   { class TopoShape;  }
 
 namespace Inspection
 {
 
-/** Delivers the number of points to be checked and returns the appropriate point to an index. */
+/** Delivers the number of points to be checked and returns the appropriate point to an index.
+ * getPoint() may be called from several threads at the same time.
+ */
 class InspectionExport InspectActualGeometry
 {
 public:
@@ -93,7 +98,9 @@ private:
     std::vector<Base::Vector3d> points;
 };
 
-/** Calculates the shortest distance of the underlying geometry to a given point. */
+/** Calculates the shortest distance of the underlying geometry to a given point.
+ * getDistance() may be called from several threads at the same time.
+ */
 class InspectionExport InspectNominalGeometry
 {
 public:
@@ -138,7 +145,7 @@ public:
 
 private:
     const Points::PointKernel& _rKernel;
-    Points::PointsGrid* _pGrid;
+    Points::PointsTree* _pTree;
 };
 
 class InspectionExport InspectNominalShape : public InspectNominalGeometry
@@ -149,8 +156,19 @@ public:
     virtual float getDistance(const Base::Vector3f&);
 
 private:
-    BRepExtrema_DistShapeShape* distss;
+    BRepExtrema_DistShapeShape* acquire();
+    void release(BRepExtrema_DistShapeShape*);
+    bool isInRange(const Base::Vector3f&) const;
+
+private:
+    // a distance computation for each thread
+    std::vector<BRepExtrema_DistShapeShape*> distss;
+    QMutex mutex;
     const TopoDS_Shape& _rShape;
+    // the tessellation to skip points outside the search radius
+    MeshCore::MeshKernel* _mesh;
+    MeshCore::MeshFacetGrid* _pGrid;
+    float _tolerance;
 };
 
 class InspectionExport PropertyDistanceList: public App::PropertyLists
@@ -181,10 +199,10 @@ public:
     /// index operator
     float operator[] (const int idx) const {return _lValueList.operator[] (idx);} 
     
-    void set1Value (const int idx, float value){_lValueList.operator[] (idx) = value;}
+    void set1Value (const int idx, float value){_lValueList.edit()[idx] = value;}
     void setValues (const std::vector<float>& values);
     
-    const std::vector<float> &getValues(void) const{return _lValueList;}
+    const std::vector<float> &getValues(void) const{return _lValueList.get();}
     
     virtual PyObject *getPyObject(void);
     virtual void setPyObject(PyObject *);
@@ -200,7 +218,7 @@ public:
     virtual unsigned int getMemSize (void) const;
 
 private:
-    std::vector<float> _lValueList;
+    App::PropertyListValues<float> _lValueList;
 };
 
 // ----------------------------------------------------------------
@@ -27,6 +27,10 @@
 # include <algorithm>
 #endif
 
+#include <QThread>
+#include <QtConcurrentMap>
+#include <boost/bind.hpp>
+
 #include "Algorithm.h"
 #include "Approximation.h"
 #include "Elements.h"
@@ -637,8 +641,8 @@ bool MeshAlgorithm::FillupHole(const std::vector<unsigned long>& boundary,
     unsigned long refPoint0 = *(boundary.begin());
     unsigned long refPoint1 = *(boundary.begin()+1);
     if (pP2FStructure) {
-        const std::set<unsigned long>& ring1 = (*pP2FStructure)[refPoint0];
-        const std::set<unsigned long>& ring2 = (*pP2FStructure)[refPoint1];
+        MeshIndexRange ring1 = (*pP2FStructure)[refPoint0];
+        MeshIndexRange ring2 = (*pP2FStructure)[refPoint1];
         std::vector<unsigned long> f_int;
         std::set_intersection(ring1.begin(), ring1.end(), ring2.begin(), ring2.end(),
             std::back_insert_iterator<std::vector<unsigned long> >(f_int));
@@ -1419,10 +1423,16 @@ bool MeshAlgorithm::CutWithPlane (const Base::Vector3f &clBase, const Base::Vect
   std::sort(aulFacets.begin(), aulFacets.end());
   aulFacets.erase(std::unique(aulFacets.begin(), aulFacets.end()), aulFacets.end());  
 
+  return CutFacetsWithPlane(clBase, clNormal, aulFacets, rclResult, fMinEps, bConnectPolygons);
+}
+
+bool MeshAlgorithm::CutFacetsWithPlane (const Base::Vector3f &clBase, const Base::Vector3f &clNormal, const std::vector<unsigned long> &aulFacets,
+                                        std::list<std::vector<Base::Vector3f> > &rclResult, float fMinEps, bool bConnectPolygons) const
+{
   // alle Facets mit Ebene schneiden
   std::list<std::pair<Base::Vector3f, Base::Vector3f> > clTempPoly;  // Feld mit Schnittlinien (unsortiert, nicht verkettet)
 
-  for (std::vector<unsigned long>::iterator pF = aulFacets.begin(); pF != aulFacets.end(); pF++)
+  for (std::vector<unsigned long>::const_iterator pF = aulFacets.begin(); pF != aulFacets.end(); pF++)
   {
     Base::Vector3f  clE1, clE2;
     const MeshGeomFacet clF(_rclMesh.GetFacet(*pF));
@@ -1451,6 +1461,113 @@ bool MeshAlgorithm::CutWithPlane (const Base::Vector3f &clBase, const Base::Vect
   return ConnectLines(clTempPoly, rclResult, fMinEps);
 }
 
+namespace MeshCore {
+/**
+ * Helper structure to cut the candidate facets of one plane of a stack.
+ */
+struct MeshPlaneSection
+{
+  const MeshAlgorithm* algo;
+  Base::Vector3f base, normal;
+  std::vector<unsigned long> facets;
+  std::list<std::vector<Base::Vector3f> >* result;
+  float eps;
+  bool connect;
+
+  void Cut()
+  {
+    algo->CutFacetsWithPlane(base, normal, facets, *result, eps, connect);
+    std::vector<unsigned long>().swap(facets);
+  }
+};
+}
+
+bool MeshAlgorithm::CutWithPlanes (const std::vector<std::pair<Base::Vector3f, Base::Vector3f> > &rclPlanes,
+                                   std::vector<std::list<std::vector<Base::Vector3f> > > &rclResults,
+                                   float fMinEps, bool bConnectPolygons) const
+{
+  if (rclPlanes.empty()) {
+    rclResults.clear();
+    return true;
+  }
+
+  // the common direction of the planes
+  Base::Vector3f clDir = rclPlanes.front().second;
+  clDir.Normalize();
+  for (std::vector<std::pair<Base::Vector3f, Base::Vector3f> >::const_iterator it = rclPlanes.begin(); it != rclPlanes.end(); ++it) {
+    Base::Vector3f clNormal = it->second;
+    clNormal.Normalize();
+    if ((clNormal % clDir).Length() > 1.0e-4f)
+      return false;
+  }
+
+  // sort the planes by their distance along the direction
+  unsigned long ulCtPlanes = rclPlanes.size();
+  std::vector<std::pair<float, unsigned long> > aclDist(ulCtPlanes);
+  for (unsigned long i = 0; i < ulCtPlanes; i++)
+    aclDist[i] = std::make_pair(clDir * rclPlanes[i].first, i);
+  std::sort(aclDist.begin(), aclDist.end());
+  std::vector<float> afDist(ulCtPlanes);
+  for (unsigned long i = 0; i < ulCtPlanes; i++)
+    afDist[i] = aclDist[i].first;
+
+  rclResults.clear();
+  rclResults.resize(ulCtPlanes);
+  std::vector<MeshPlaneSection> aclSections(ulCtPlanes);
+  for (unsigned long i = 0; i < ulCtPlanes; i++) {
+    MeshPlaneSection& rSection = aclSections[i];
+    rSection.algo = this;
+    rSection.base = rclPlanes[aclDist[i].second].first;
+    rSection.normal = rclPlanes[aclDist[i].second].second;
+    rSection.result = &rclResults[aclDist[i].second];
+    rSection.eps = fMinEps;
+    rSection.connect = bConnectPolygons;
+  }
+
+  // Assign each facet to all planes within its extent along the direction. The
+  // extent is enlarged a bit to not miss facets that only touch a plane. In the
+  // first pass the facets of each plane are counted, in the second pass they are
+  // added in ascending order as done by CutWithPlane().
+  float fTol = std::max<float>(fMinEps, FLOAT_EPS);
+  const MeshPointArray& rclPoints = _rclMesh.GetPoints();
+  const MeshFacetArray& rclFacets = _rclMesh.GetFacets();
+  unsigned long ulCtFacets = rclFacets.size();
+  std::vector<unsigned long> aulCount(ulCtPlanes, 0);
+  for (int pass = 0; pass < 2; pass++) {
+    for (unsigned long i = 0; i < ulCtFacets; i++) {
+      const MeshFacet& rclFacet = rclFacets[i];
+      float d0 = clDir * rclPoints[rclFacet._aulPoints[0]];
+      float d1 = clDir * rclPoints[rclFacet._aulPoints[1]];
+      float d2 = clDir * rclPoints[rclFacet._aulPoints[2]];
+      float fMin = std::min<float>(d0, std::min<float>(d1, d2)) - fTol;
+      float fMax = std::max<float>(d0, std::max<float>(d1, d2)) + fTol;
+      unsigned long ulFirst = std::lower_bound(afDist.begin(), afDist.end(), fMin) - afDist.begin();
+      unsigned long ulLast = std::upper_bound(afDist.begin(), afDist.end(), fMax) - afDist.begin();
+      for (unsigned long j = ulFirst; j < ulLast; j++) {
+        if (pass == 0)
+          aulCount[j]++;
+        else
+          aclSections[j].facets.push_back(i);
+      }
+    }
+
+    if (pass == 0) {
+      for (unsigned long j = 0; j < ulCtPlanes; j++)
+        aclSections[j].facets.reserve(aulCount[j]);
+    }
+  }
+
+  if (ulCtPlanes > 1 && ulCtFacets >= MESH_PARALLEL_ELEMENTS && QThread::idealThreadCount() > 1) {
+    QtConcurrent::blockingMap(aclSections, boost::bind(&MeshPlaneSection::Cut, _1));
+  }
+  else {
+    for (std::vector<MeshPlaneSection>::iterator it = aclSections.begin(); it != aclSections.end(); ++it)
+      it->Cut();
+  }
+
+  return true;
+}
+
 bool MeshAlgorithm::ConnectLines (std::list<std::pair<Base::Vector3f, Base::Vector3f> > &rclLines,
                                   std::list<std::vector<Base::Vector3f> > &rclPolylines, float fMinEps) const
 {
@@ -1694,28 +1811,168 @@ float MeshAlgorithm::CalculateMinimumGridLength(float fLength, const Base::Bound
 
 // ----------------------------------------------------
 
-void MeshRefPointToFacets::Rebuild (void)
+namespace MeshCore {
+/**
+ * Helper class to fill the rows of the compressed neighbourhood structures.
+ * The functor computes the sorted indices of one row. In a first pass the size
+ * of all rows is determined, then the offsets are computed and in a second pass
+ * the rows are written. For large meshes both passes run in parallel.
+ */
+template <class RowFunc>
+class MeshRowBuilder
+{
+public:
+    typedef std::pair<unsigned long, unsigned long> Range;
+
+    MeshRowBuilder(const RowFunc& func, std::vector<unsigned long>& offsets, std::vector<unsigned long>& indices)
+      : _func(func), _offsets(offsets), _indices(indices)
+    {
+    }
+    void Build(unsigned long ulRows)
+    {
+        std::vector<Range> ranges;
+        unsigned long ulCtRanges = 1;
+        if (ulRows >= MESH_PARALLEL_ELEMENTS)
+            ulCtRanges = 4 * std::max<unsigned long>(QThread::idealThreadCount(), 1);
+        unsigned long ulStep = ulRows / ulCtRanges + 1;
+        for (unsigned long i = 0; i < ulRows; i += ulStep)
+            ranges.push_back(Range(i, std::min<unsigned long>(i + ulStep, ulRows)));
+
+        _offsets.clear();
+        _offsets.resize(ulRows + 1, 0);
+        Run(ranges, &MeshRowBuilder::Count);
+        for (unsigned long i = 0; i < ulRows; i++)
+            _offsets[i + 1] += _offsets[i];
+
+        _indices.clear();
+        _indices.resize(_offsets.back());
+        Run(ranges, &MeshRowBuilder::Fill);
+    }
+
+private:
+    void Run(std::vector<Range>& ranges, void (MeshRowBuilder::*pass)(const Range&))
+    {
+        if (ranges.size() > 1)
+            QtConcurrent::blockingMap(ranges, boost::bind(pass, this, _1));
+        else if (ranges.size() == 1)
+            (this->*pass)(ranges.front());
+    }
+    void Count(const Range& range)
+    {
+        std::vector<unsigned long> row;
+        for (unsigned long i = range.first; i < range.second; i++) {
+            row.clear();
+            _func(i, row);
+            _offsets[i + 1] = row.size();
+        }
+    }
+    void Fill(const Range& range)
+    {
+        std::vector<unsigned long> row;
+        for (unsigned long i = range.first; i < range.second; i++) {
+            row.clear();
+            _func(i, row);
+            std::copy(row.begin(), row.end(), _indices.begin() + _offsets[i]);
+        }
+    }
+
+private:
+    const RowFunc& _func;
+    std::vector<unsigned long>& _offsets;
+    std::vector<unsigned long>& _indices;
+};
+
+/// Collects the facets sharing a point with a facet.
+struct FacetNeighbourRow
 {
-    _map.clear();
+    FacetNeighbourRow(const MeshFacetArray& rFacets, const MeshRefPointToFacets& rVertexFace)
+      : facets(rFacets), vertexFace(rVertexFace)
+    {
+    }
+    void operator()(unsigned long index, std::vector<unsigned long>& row) const
+    {
+        for (int i = 0; i < 3; i++) {
+            MeshIndexRange faces = vertexFace[facets[index]._aulPoints[i]];
+            row.insert(row.end(), faces.begin(), faces.end());
+        }
+        std::sort(row.begin(), row.end());
+        row.erase(std::unique(row.begin(), row.end()), row.end());
+    }
 
+    const MeshFacetArray& facets;
+    const MeshRefPointToFacets& vertexFace;
+};
+
+/// Collects the points connected with a point by an edge.
+struct PointNeighbourRow
+{
+    PointNeighbourRow(const MeshFacetArray& rFacets, const MeshRefPointToFacets& rVertexFace)
+      : facets(rFacets), vertexFace(rVertexFace)
+    {
+    }
+    void operator()(unsigned long index, std::vector<unsigned long>& row) const
+    {
+        MeshIndexRange faces = vertexFace[index];
+        for (MeshIndexRange::const_iterator it = faces.begin(); it != faces.end(); ++it) {
+            const MeshFacet& face = facets[*it];
+            for (int i = 0; i < 3; i++) {
+                if (face._aulPoints[i] == index) {
+                    row.push_back(face._aulPoints[(i+1)%3]);
+                    row.push_back(face._aulPoints[(i+2)%3]);
+                }
+            }
+        }
+        std::sort(row.begin(), row.end());
+        row.erase(std::unique(row.begin(), row.end()), row.end());
+    }
+
+    const MeshFacetArray& facets;
+    const MeshRefPointToFacets& vertexFace;
+};
+}
+
+void MeshRefPointToFacets::Rebuild (void)
+{
     const MeshPointArray& rPoints = _rclMesh.GetPoints();
     const MeshFacetArray& rFacets = _rclMesh.GetFacets();
-    _map.resize(rPoints.size());
 
+    // count the facets of each point, a point used twice by a facet counts once
+    _offsets.clear();
+    _offsets.resize(rPoints.size() + 1, 0);
     MeshFacetArray::_TConstIterator pFBegin = rFacets.begin();
-    for (MeshFacetArray::_TConstIterator pFIter = rFacets.begin(); pFIter != rFacets.end(); ++pFIter) {
-        _map[pFIter->_aulPoints[0]].insert(pFIter - pFBegin);
-        _map[pFIter->_aulPoints[1]].insert(pFIter - pFBegin);
-        _map[pFIter->_aulPoints[2]].insert(pFIter - pFBegin);
+    MeshFacetArray::_TConstIterator pFIter;
+    for (pFIter = rFacets.begin(); pFIter != rFacets.end(); ++pFIter) {
+        const unsigned long* p = pFIter->_aulPoints;
+        _offsets[p[0] + 1]++;
+        if (p[1] != p[0])
+            _offsets[p[1] + 1]++;
+        if (p[2] != p[0] && p[2] != p[1])
+            _offsets[p[2] + 1]++;
+    }
+    for (std::size_t i = 0; i < rPoints.size(); i++)
+        _offsets[i + 1] += _offsets[i];
+
+    // as the facets are processed in order the indices of each point are sorted
+    _indices.clear();
+    _indices.resize(_offsets.back());
+    std::vector<unsigned long> pos(_offsets.begin(), _offsets.end() - 1);
+    for (pFIter = rFacets.begin(); pFIter != rFacets.end(); ++pFIter) {
+        const unsigned long* p = pFIter->_aulPoints;
+        unsigned long index = pFIter - pFBegin;
+        _indices[pos[p[0]]++] = index;
+        if (p[1] != p[0])
+            _indices[pos[p[1]]++] = index;
+        if (p[2] != p[0] && p[2] != p[1])
+            _indices[pos[p[2]]++] = index;
     }
 }
 
 Base::Vector3f MeshRefPointToFacets::GetNormal(unsigned long pos) const
 {
-    const std::set<unsigned long>& n = _map[pos];
+    MeshIndexRange n = (*this)[pos];
     Base::Vector3f normal;
     MeshGeomFacet f;
-    for (std::set<unsigned long>::const_iterator it = n.begin(); it != n.end(); ++it) {
+    for (MeshIndexRange::const_iterator it = n.begin(); it != n.end(); ++it) {
         f = _rclMesh.GetFacet(*it);
         normal += f.Area() * f.GetNormal();
     }
@@ -1733,8 +1990,8 @@ std::set<unsigned long> MeshRefPointToFacets::NeighbourPoints(const std::vector<
     for (int i=0; i < level; i++) {
         std::set<unsigned long> cur;
         for (std::set<unsigned long>::iterator it = lp.begin(); it != lp.end(); ++it) {
-            const std::set<unsigned long>& ft = (*this)[*it];
-            for (std::set<unsigned long>::const_iterator jt = ft.begin(); jt != ft.end(); ++jt) {
+            MeshIndexRange ft = (*this)[*it];
+            for (MeshIndexRange::const_iterator jt = ft.begin(); jt != ft.end(); ++jt) {
                 for (int j = 0; j < 3; j++) {
                     unsigned long index = f_it[*jt]._aulPoints[j];
                     if (cp.find(index) == cp.end() && nb.find(index) == nb.end()) {
@@ -1774,9 +2031,9 @@ void MeshRefPointToFacets::SearchNeighbours(const MeshFacetArray& rFacets, unsig
     visited.insert(index);
     collect.Append(_rclMesh, index);
     for (int i = 0; i < 3; i++) {
-        const std::set<unsigned long> &f = (*this)[face._aulPoints[i]];
+        MeshIndexRange f = (*this)[face._aulPoints[i]];
 
-        for (std::set<unsigned long>::const_iterator j = f.begin(); j != f.end(); ++j) {
+        for (MeshIndexRange::const_iterator j = f.begin(); j != f.end(); ++j) {
             SearchNeighbours(rFacets, *j, rclCenter, fMaxDist2, visited, collect);
         }
     }
@@ -1788,70 +2045,41 @@ MeshRefPointToFacets::GetFacet (unsigned long index) const
     return _rclMesh.GetFacets().begin() + index;
 }
 
-const std::set<unsigned long>&
+MeshIndexRange
 MeshRefPointToFacets::operator[] (unsigned long pos) const
 {
-    return _map[pos];
-}
-
-void MeshRefPointToFacets::AddNeighbour(unsigned long pos, unsigned long facet)
-{
-    _map[pos].insert(facet);
-}
-
-void MeshRefPointToFacets::RemoveNeighbour(unsigned long pos, unsigned long facet)
-{
-    _map[pos].erase(facet);
+    const unsigned long* base = _indices.empty() ? 0 : &(_indices[0]);
+    return MeshIndexRange(base + _offsets[pos], base + _offsets[pos + 1]);
 }
 
 //----------------------------------------------------------------------------
 
 void MeshRefFacetToFacets::Rebuild (void)
 {
-    _map.clear();
-
     const MeshFacetArray& rFacets = _rclMesh.GetFacets();
-    _map.resize(rFacets.size());
-
     MeshRefPointToFacets  vertexFace(_rclMesh);
-    MeshFacetArray::_TConstIterator pFBegin = rFacets.begin();
-    for (MeshFacetArray::_TConstIterator pFIter = pFBegin; pFIter != rFacets.end(); ++pFIter) {
-        for (int i = 0; i < 3; i++) {
-            const std::set<unsigned long>& faces = vertexFace[pFIter->_aulPoints[i]];
-            for (std::set<unsigned long>::const_iterator it = faces.begin(); it != faces.end(); ++it)
-                _map[pFIter - pFBegin].insert(*it);
-        }
-    }
+    FacetNeighbourRow row(rFacets, vertexFace);
+    MeshRowBuilder<FacetNeighbourRow> builder(row, _offsets, _indices);
+    builder.Build(rFacets.size());
 }
 
-const std::set<unsigned long>&
+MeshIndexRange
 MeshRefFacetToFacets::operator[] (unsigned long pos) const
 {
-    return _map[pos];
+    const unsigned long* base = _indices.empty() ? 0 : &(_indices[0]);
+    return MeshIndexRange(base + _offsets[pos], base + _offsets[pos + 1]);
 }
 
 //----------------------------------------------------------------------------
 
 void MeshRefPointToPoints::Rebuild (void)
 {
-    _map.clear();
-
     const MeshPointArray& rPoints = _rclMesh.GetPoints();
-    _map.resize(rPoints.size());
-
     const MeshFacetArray& rFacets = _rclMesh.GetFacets();
-    for (MeshFacetArray::_TConstIterator pFIter = rFacets.begin(); pFIter != rFacets.end(); ++pFIter) {
-        unsigned long ulP0 = pFIter->_aulPoints[0];
-        unsigned long ulP1 = pFIter->_aulPoints[1];
-        unsigned long ulP2 = pFIter->_aulPoints[2];
-
-        _map[ulP0].insert(ulP1);
-        _map[ulP0].insert(ulP2);
-        _map[ulP1].insert(ulP0);
-        _map[ulP1].insert(ulP2);
-        _map[ulP2].insert(ulP0);
-        _map[ulP2].insert(ulP1);
-    }
+    MeshRefPointToFacets  vertexFace(_rclMesh);
+    PointNeighbourRow row(rFacets, vertexFace);
+    MeshRowBuilder<PointNeighbourRow> builder(row, _offsets, _indices);
+    builder.Build(rPoints.size());
 }
 
 Base::Vector3f MeshRefPointToPoints::GetNormal(unsigned long pos) const
@@ -1860,8 +2088,8 @@ Base::Vector3f MeshRefPointToPoints::GetNormal(unsigned long pos) const
     MeshCore::PlaneFit pf;
     pf.AddPoint(rPoints[pos]);
     MeshCore::MeshPoint center = rPoints[pos];
-    const std::set<unsigned long>& cv = _map[pos];
-    for (std::set<unsigned long>::const_iterator cv_it = cv.begin(); cv_it !=cv.end(); ++cv_it) {
+    MeshIndexRange cv = (*this)[pos];
+    for (MeshIndexRange::const_iterator cv_it = cv.begin(); cv_it !=cv.end(); ++cv_it) {
         pf.AddPoint(rPoints[*cv_it]);
         center += rPoints[*cv_it];
     }
@@ -1877,28 +2105,19 @@ float MeshRefPointToPoints::GetAverageEdgeLength(unsigned long index) const
 {
     const MeshPointArray& rPoints = _rclMesh.GetPoints();
     float len=0.0f;
-    const std::set<unsigned long>& n = (*this)[index];
+    MeshIndexRange n = (*this)[index];
     const Base::Vector3f& p = rPoints[index];
-    for (std::set<unsigned long>::const_iterator it = n.begin(); it != n.end(); ++it) {
+    for (MeshIndexRange::const_iterator it = n.begin(); it != n.end(); ++it) {
         len += Base::Distance(p, rPoints[*it]);
     }
     return (len/n.size());
 }
 
-const std::set<unsigned long>&
+MeshIndexRange
 MeshRefPointToPoints::operator[] (unsigned long pos) const
 {
-    return _map[pos];
-}
-
-void MeshRefPointToPoints::AddNeighbour(unsigned long pos, unsigned long facet)
-{
-    _map[pos].insert(facet);
-}
-
-void MeshRefPointToPoints::RemoveNeighbour(unsigned long pos, unsigned long facet)
-{
-    _map[pos].erase(facet);
+    const unsigned long* base = _indices.empty() ? 0 : &(_indices[0]);
+    return MeshIndexRange(base + _offsets[pos], base + _offsets[pos + 1]);
 }
 
 //----------------------------------------------------------------------------
@@ -24,6 +24,7 @@
 #ifndef MESHALGORITHM_H
 #define MESHALGORITHM_H
 
+#include <algorithm>
 #include <set>
 #include <vector>
 #include <map>
@@ -279,6 +280,19 @@ public:
   /** Cuts the mesh with a plane. The result is a list of polylines. */
   bool CutWithPlane (const Base::Vector3f &clBase, const Base::Vector3f &clNormal, const MeshFacetGrid &rclGrid,
                      std::list<std::vector<Base::Vector3f> > &rclResult, float fMinEps = 1.0e-2f, bool bConnectPolygons = false) const;
+  /**
+   * Cuts the mesh with a stack of parallel planes, each given by its base point and normal. The result
+   * contains the polylines of each plane in the given order. Instead of searching the facets for each
+   * plane the facets are assigned in one pass to all planes within their extent along the normal.
+   * Afterwards the planes are cut in parallel.
+   * If the planes are not parallel false is returned and nothing is done.
+   */
+  bool CutWithPlanes (const std::vector<std::pair<Base::Vector3f, Base::Vector3f> > &rclPlanes,
+                      std::vector<std::list<std::vector<Base::Vector3f> > > &rclResults,
+                      float fMinEps = 1.0e-2f, bool bConnectPolygons = false) const;
+  /** Cuts the given facets with a plane. The result is a list of polylines. */
+  bool CutFacetsWithPlane (const Base::Vector3f &clBase, const Base::Vector3f &clNormal, const std::vector<unsigned long> &raulFacets,
+                           std::list<std::vector<Base::Vector3f> > &rclResult, float fMinEps = 1.0e-2f, bool bConnectPolygons = false) const;
   /** 
    * Gets all facets that cut the plane (N,d) and that lie between the two points left and right. 
    * The plane is defined by it normalized normal and the signed distance to the origin.
@@ -351,9 +365,48 @@ private:
     std::vector<unsigned long>& indices;
 };
 
+/**
+ * The MeshIndexRange class gives read-only access to the sorted indices a point or facet
+ * refers to in one of the neighbourhood structures below. The range is only valid as long
+ * as the structure it comes from is neither rebuilt nor destroyed.
+ */
+class MeshExport MeshIndexRange
+{
+public:
+    typedef const unsigned long* const_iterator;
+    typedef std::size_t size_type;
+
+    /// Construction
+    MeshIndexRange (const_iterator first, const_iterator last) : _first(first), _last(last)
+    { }
+
+    const_iterator begin (void) const
+    { return _first; }
+    const_iterator end (void) const
+    { return _last; }
+    size_type size (void) const
+    { return _last - _first; }
+    bool empty (void) const
+    { return _first == _last; }
+    /// Returns the position of \a index or end() if the index is not in the range.
+    const_iterator find (unsigned long index) const
+    {
+        const_iterator it = std::lower_bound(_first, _last, index);
+        return (it != _last && *it == index) ? it : _last;
+    }
+    /// Returns 1 if \a index is in the range, otherwise 0.
+    size_type count (unsigned long index) const
+    { return find(index) != _last ? 1 : 0; }
+
+private:
+    const_iterator _first, _last;
+};
+
 /**
  * The MeshRefPointToFacets builds up a structure to have access to all facets indexing
  * a point.
+ * The facet indices of all points are kept in one array, sorted per point, and the start
+ * of each point is stored in an offset array.
  * \note If the underlying mesh kernel gets changed this structure becomes invalid and must
  * be rebuilt.
  */
@@ -369,13 +422,11 @@ public:
 
     /// Rebuilds up data structure
     void Rebuild (void);
-    const std::set<unsigned long>& operator[] (unsigned long) const;
+    MeshIndexRange operator[] (unsigned long) const;
     MeshFacetArray::_TConstIterator GetFacet (unsigned long) const;
     std::set<unsigned long> NeighbourPoints(const std::vector<unsigned long>& , int level) const;
     void Neighbours (unsigned long ulFacetInd, float fMaxDist, MeshCollector& collect) const;
     Base::Vector3f GetNormal(unsigned long) const;
-    void AddNeighbour(unsigned long, unsigned long);
-    void RemoveNeighbour(unsigned long, unsigned long);
 
 protected:
     void SearchNeighbours(const MeshFacetArray& rFacets, unsigned long index, const Base::Vector3f &rclCenter, 
@@ -383,7 +434,8 @@ protected:
 
 protected:
     const MeshKernel  &_rclMesh; /**< The mesh kernel. */
-    std::vector<std::set<unsigned long> > _map;
+    std::vector<unsigned long> _offsets; /**< Start of the facets of each point, one more entry than points. */
+    std::vector<unsigned long> _indices; /**< Facet indices of all points. */
 };
 
 /**
@@ -406,11 +458,12 @@ public:
 
     /// Returns a set of facets sharing one or more points with the facet with
     /// index \a ulFacetIndex.
-    const std::set<unsigned long>& operator[] (unsigned long) const;
+    MeshIndexRange operator[] (unsigned long) const;
 
 protected:
     const MeshKernel  &_rclMesh; /**< The mesh kernel. */
-    std::vector<std::set<unsigned long> > _map;
+    std::vector<unsigned long> _offsets; /**< Start of the neighbours of each facet. */
+    std::vector<unsigned long> _indices; /**< Neighbour facets of all facets. */
 };
 
 /**
@@ -431,15 +484,14 @@ public:
 
     /// Rebuilds up data structure
     void Rebuild (void);
-    const std::set<unsigned long>& operator[] (unsigned long) const;
+    MeshIndexRange operator[] (unsigned long) const;
     Base::Vector3f GetNormal(unsigned long) const;
     float GetAverageEdgeLength(unsigned long) const;
-    void AddNeighbour(unsigned long, unsigned long);
-    void RemoveNeighbour(unsigned long, unsigned long);
 
 protected:
     const MeshKernel  &_rclMesh; /**< The mesh kernel. */
-    std::vector<std::set<unsigned long> > _map;
+    std::vector<unsigned long> _offsets; /**< Start of the neighbours of each point. */
+    std::vector<unsigned long> _indices; /**< Neighbour points of all points. */
 };
 
 /**
@@ -25,8 +25,14 @@
 
 #ifndef _PreComp_
 # include <algorithm>
+# include <cmath>
 #endif
 
+#include <QThread>
+#include <QtConcurrentMap>
+#include <boost/bind.hpp>
+#include <boost/functional/hash.hpp>
+
 #include <Base/Sequencer.h>
 #include <Base/Exception.h>
 
@@ -249,3 +255,174 @@ void MeshBuilder::Finish (bool freeMemory)
 
     _meshKernel.RecalcBoundBox();
 }
+
+// ----------------------------------------------------------------------------
+
+struct MeshFastBuilder::Group
+{
+    std::vector<unsigned long> vertices;
+};
+
+namespace MeshCore {
+// returns the cell of the grid a coordinate lies in
+static inline double MeshGridCell(float v, float tolerance)
+{
+    double cell = tolerance > 0.0f ? std::floor(double(v) / double(tolerance)) : double(v);
+    if (cell != cell) // NaN
+        return HUGE_VAL;
+    return cell + 0.0; // no distinction between -0 and +0
+}
+}
+
+MeshFastBuilder::MeshFastBuilder (MeshKernel& kernel)
+  : _meshKernel(kernel), _fTolerance(MeshDefinitions::_fMinPointDistanceD1)
+{
+}
+
+MeshFastBuilder::~MeshFastBuilder (void)
+{
+}
+
+void MeshFastBuilder::Initialize (unsigned long ctFacets)
+{
+    _meshKernel.Clear();
+    _vertices.resize(3 * ctFacets);
+}
+
+void MeshFastBuilder::SetFacet (unsigned long index, const Base::Vector3f* facetPoints)
+{
+    Base::Vector3f* pts = &_vertices[3 * index];
+    pts[0] = facetPoints[0];
+    pts[1] = facetPoints[1];
+    pts[2] = facetPoints[2];
+
+    // adjust circulation direction
+    if ((((pts[1] - pts[0]) % (pts[2] - pts[0])) * facetPoints[3]) < 0.0f)
+        std::swap(pts[1], pts[2]);
+}
+
+void MeshFastBuilder::HashRange (std::pair<unsigned long, unsigned long>& range)
+{
+    for (unsigned long i = range.first; i < range.second; i++) {
+        std::size_t seed = 0;
+        boost::hash_combine(seed, MeshGridCell(_vertices[i].x, _fTolerance));
+        boost::hash_combine(seed, MeshGridCell(_vertices[i].y, _fTolerance));
+        boost::hash_combine(seed, MeshGridCell(_vertices[i].z, _fTolerance));
+        _hashes[i] = static_cast<unsigned int>(seed);
+    }
+}
+
+bool MeshFastBuilder::IsLess (unsigned long i, unsigned long j) const
+{
+    if (_hashes[i] != _hashes[j])
+        return _hashes[i] < _hashes[j];
+    double ci, cj;
+    ci = MeshGridCell(_vertices[i].x, _fTolerance);
+    cj = MeshGridCell(_vertices[j].x, _fTolerance);
+    if (ci != cj)
+        return ci < cj;
+    ci = MeshGridCell(_vertices[i].y, _fTolerance);
+    cj = MeshGridCell(_vertices[j].y, _fTolerance);
+    if (ci != cj)
+        return ci < cj;
+    ci = MeshGridCell(_vertices[i].z, _fTolerance);
+    cj = MeshGridCell(_vertices[j].z, _fTolerance);
+    if (ci != cj)
+        return ci < cj;
+    return i < j;
+}
+
+bool MeshFastBuilder::IsSameCell (unsigned long i, unsigned long j) const
+{
+    return _hashes[i] == _hashes[j] &&
+           MeshGridCell(_vertices[i].x, _fTolerance) == MeshGridCell(_vertices[j].x, _fTolerance) &&
+           MeshGridCell(_vertices[i].y, _fTolerance) == MeshGridCell(_vertices[j].y, _fTolerance) &&
+           MeshGridCell(_vertices[i].z, _fTolerance) == MeshGridCell(_vertices[j].z, _fTolerance);
+}
+
+void MeshFastBuilder::WeldGroup (Group& group)
+{
+    // sort by cell, the first point of a cell is the one with the lowest index
+    std::vector<unsigned long>& v = group.vertices;
+    std::sort(v.begin(), v.end(), boost::bind(&MeshFastBuilder::IsLess, this, _1, _2));
+    std::size_t first = 0;
+    for (std::size_t i = 0; i < v.size(); i++) {
+        if (!IsSameCell(v[first], v[i]))
+            first = i;
+        _welded[v[i]] = v[first];
+    }
+    std::vector<unsigned long>().swap(v);
+}
+
+void MeshFastBuilder::Finish ()
+{
+    Base::SequencerLauncher seq("create mesh structure...", 4);
+    unsigned long ctVertices = _vertices.size();
+
+    // split the points into ordered ranges and hash them
+    unsigned long ctGroups = 1;
+    if (ctVertices >= MESH_PARALLEL_ELEMENTS)
+        ctGroups = 4 * std::max<unsigned long>(QThread::idealThreadCount(), 1);
+    unsigned long step = ctVertices / ctGroups + 1;
+    std::vector<std::pair<unsigned long, unsigned long> > ranges;
+    for (unsigned long i = 0; i < ctVertices; i += step)
+        ranges.push_back(std::make_pair(i, std::min<unsigned long>(i + step, ctVertices)));
+    _hashes.resize(ctVertices);
+    QtConcurrent::blockingMap(ranges, boost::bind(&MeshFastBuilder::HashRange, this, _1));
+    seq.next(true);
+
+    // points of the same cell have the same hash and thus end up in the same group
+    std::vector<Group> groups(ctGroups);
+    {
+        std::vector<unsigned long> counts(ctGroups, 0);
+        for (unsigned long i = 0; i < ctVertices; i++)
+            counts[_hashes[i] % ctGroups]++;
+        for (unsigned long i = 0; i < ctGroups; i++)
+            groups[i].vertices.reserve(counts[i]);
+        for (unsigned long i = 0; i < ctVertices; i++)
+            groups[_hashes[i] % ctGroups].vertices.push_back(i);
+    }
+
+    _welded.resize(ctVertices);
+    QtConcurrent::blockingMap(groups, boost::bind(&MeshFastBuilder::WeldGroup, this, _1));
+    std::vector<unsigned int>().swap(_hashes);
+    seq.next(true);
+
+    // number the points in the order of their first occurrence, as the welded point
+    // of a point has never a higher index its number is already known
+    MeshPointArray points;
+    for (unsigned long i = 0; i < ctVertices; i++) {
+        if (_welded[i] == i) {
+            _welded[i] = points.size();
+            points.push_back(_vertices[i]);
+        }
+        else {
+            _welded[i] = _welded[_welded[i]];
+        }
+    }
+    std::vector<Base::Vector3f>().swap(_vertices);
+    seq.next(true);
+
+    // set up the facets and skip the degenerated ones
+    MeshFacetArray facets;
+    facets.reserve(ctVertices / 3);
+    std::vector<bool> used(points.size(), false);
+    for (unsigned long i = 0; i < ctVertices; i += 3) {
+        MeshFacet mf;
+        mf._aulPoints[0] = _welded[i];
+        mf._aulPoints[1] = _welded[i+1];
+        mf._aulPoints[2] = _welded[i+2];
+        if ((mf._aulPoints[0] == mf._aulPoints[1]) || (mf._aulPoints[0] == mf._aulPoints[2]) || (mf._aulPoints[1] == mf._aulPoints[2]))
+            continue;
+        used[mf._aulPoints[0]] = used[mf._aulPoints[1]] = used[mf._aulPoints[2]] = true;
+        facets.push_back(mf);
+    }
+    std::vector<unsigned long>().swap(_welded);
+    seq.next(true);
+
+    // Merge() removes the points that are only referenced by degenerated facets
+    if (std::find(used.begin(), used.end(), false) != used.end())
+        _meshKernel.Merge(points, facets);
+    else
+        _meshKernel.Adopt(points, facets, true);
+}
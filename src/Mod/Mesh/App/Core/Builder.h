@@ -164,6 +164,55 @@ private:
     float _fSaveTolerance;
 };
 
+/**
+ * Class for creating the mesh structure from a large number of unconnected facets,
+ * e.g. of a binary STL file. In contrast to MeshBuilder the points are not inserted
+ * into a set. Instead, all points are collected first and are welded at the end by
+ * hashing them into the cells of a grid whose size is the point tolerance. The cells
+ * are split into groups that are processed by the global thread pool. Two points are
+ * welded if they lie in the same cell, thus no points are welded that MeshBuilder would
+ * keep apart.
+ * The facets can be set concurrently from several threads.
+ * \code
+ * MeshFastBuilder builder(someMeshReference);
+ * builder.Initialize(numberOfFacets);
+ * ...
+ * for (unsigned long i = 0; i < numberOfFacets; i++)
+ *   builder.SetFacet(i, ...);
+ * ...
+ * builder.Finish();
+ * \endcode
+ */
+class MeshExport MeshFastBuilder
+{
+public:
+    MeshFastBuilder(MeshKernel &rclM);
+    ~MeshFastBuilder(void);
+
+    /** Initializes the class for \a ctFacets facets. The mesh kernel gets cleared. */
+    void Initialize (unsigned long ctFacets);
+    /** Sets the facet with index \a index. The first three elements of \a facetPoints
+     * are the corner points, the fourth is the normal that is used to adjust the
+     * orientation of the facet.
+     */
+    void SetFacet (unsigned long index, const Base::Vector3f* facetPoints);
+    /** Welds the points and sets up the mesh structure. Degenerated facets are removed. */
+    void Finish ();
+
+private:
+    struct Group;
+    void HashRange (std::pair<unsigned long, unsigned long>&);
+    void WeldGroup (Group&);
+    bool IsLess (unsigned long, unsigned long) const;
+    bool IsSameCell (unsigned long, unsigned long) const;
+
+    MeshKernel& _meshKernel;
+    float _fTolerance;
+    std::vector<Base::Vector3f> _vertices;
+    std::vector<unsigned int> _hashes;
+    std::vector<unsigned long> _welded;
+};
+
 } // namespace MeshCore
 
 #endif 
@@ -0,0 +1,653 @@
+/***************************************************************************
+ *   Copyright (c) 2014                                                    *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+#ifndef _PreComp_
+# include <algorithm>
+# include <cmath>
+# include <map>
+# include <vector>
+#endif
+
+#include <QThread>
+#include <QtConcurrentMap>
+#include <boost/bind.hpp>
+
+#include "Decimation.h"
+#include "MeshKernel.h"
+#include "Elements.h"
+#include "Definitions.h"
+
+using namespace MeshCore;
+
+namespace MeshCore {
+
+/**
+ * Symmetric 4x4 matrix of the quadric error metric. Only the upper triangle is stored.
+ */
+class MeshQuadric
+{
+public:
+    MeshQuadric()
+    {
+        std::fill(a, a + 10, 0.0);
+    }
+    void AddPlane(double nx, double ny, double nz, double d, double w)
+    {
+        a[0] += w*nx*nx; a[1] += w*nx*ny; a[2] += w*nx*nz; a[3] += w*nx*d;
+        a[4] += w*ny*ny; a[5] += w*ny*nz; a[6] += w*ny*d;
+        a[7] += w*nz*nz; a[8] += w*nz*d;
+        a[9] += w*d*d;
+    }
+    MeshQuadric& operator += (const MeshQuadric& q)
+    {
+        for (int i = 0; i < 10; i++)
+            a[i] += q.a[i];
+        return *this;
+    }
+    double Error(const Base::Vector3f& p) const
+    {
+        double x = p.x, y = p.y, z = p.z;
+        double e = a[0]*x*x + 2.0*a[1]*x*y + 2.0*a[2]*x*z + 2.0*a[3]*x
+                 + a[4]*y*y + 2.0*a[5]*y*z + 2.0*a[6]*y
+                 + a[7]*z*z + 2.0*a[8]*z
+                 + a[9];
+        return std::max<double>(e, 0.0);
+    }
+    /// Computes the point with the minimum error, returns false if it's not unique
+    bool Optimum(Base::Vector3f& p) const
+    {
+        double c00 = a[4]*a[7] - a[5]*a[5];
+        double c01 = a[2]*a[5] - a[1]*a[7];
+        double c02 = a[1]*a[5] - a[2]*a[4];
+        double det = a[0]*c00 + a[1]*c01 + a[2]*c02;
+        double tr = a[0] + a[4] + a[7];
+        if (std::fabs(det) <= 1.0e-6 * tr * tr * tr)
+            return false;
+        double c11 = a[0]*a[7] - a[2]*a[2];
+        double c12 = a[1]*a[2] - a[0]*a[5];
+        double c22 = a[0]*a[4] - a[1]*a[1];
+        p.x = (float)(-(c00*a[3] + c01*a[6] + c02*a[8]) / det);
+        p.y = (float)(-(c01*a[3] + c11*a[6] + c12*a[8]) / det);
+        p.z = (float)(-(c02*a[3] + c12*a[6] + c22*a[8]) / det);
+        return true;
+    }
+
+private:
+    double a[10];
+};
+
+/**
+ * The edge collapse engine. It works on plain arrays so that it can be used for the
+ * whole mesh as well as for a part of it. The facets of a point are kept in singly
+ * linked lists of facet corners. Removed facets are marked and skipped lazily.
+ */
+class MeshQuadricSimplifier
+{
+public:
+    /// the points, after Run() the removed points must be skipped
+    std::vector<Base::Vector3f> points;
+    /// three point indices per facet, removed facets are set to ULONG_MAX
+    std::vector<unsigned long> corners;
+    /// bit i is set if edge i of a facet is a border edge
+    std::vector<unsigned char> borders;
+    /// points that must neither be moved nor removed
+    std::vector<bool> locked;
+    /// the removed points
+    std::vector<bool> removed;
+    /// the quadrics of the points, if empty Run() computes them from the facets
+    std::vector<MeshQuadric> quadrics;
+
+    MeshQuadricSimplifier() : ulCtFacets(0)
+    {
+    }
+    void Run(unsigned long ulTarget, float fTolerance, bool bPreserveBorder)
+    {
+        Setup(bPreserveBorder);
+        double fMaxCost = (double)fTolerance * (double)fTolerance;
+        Base::Vector3f p;
+        while (ulCtFacets > ulTarget && !queue.empty()) {
+            std::pop_heap(queue.begin(), queue.end());
+            Collapse c = queue.back();
+            queue.pop_back();
+            if (removed[c.u] || removed[c.v] || c.stamp != version[c.u] + version[c.v])
+                continue; // outdated
+            if (fTolerance > 0.0f && c.cost > fMaxCost)
+                break;
+            unsigned long s = c.u, r = c.v;
+            if (locked[r])
+                std::swap(s, r);
+            double cost;
+            if (!Evaluate(s, r, p, cost) || !CanCollapse(s, r, p))
+                continue;
+            DoCollapse(s, r, p);
+        }
+
+        // release the memory not needed any more
+        std::vector<Collapse>().swap(queue);
+        std::vector<unsigned long>().swap(first);
+        std::vector<unsigned long>().swap(next);
+        std::vector<unsigned int>().swap(version);
+    }
+    unsigned long CountFacets() const
+    {
+        return ulCtFacets;
+    }
+
+private:
+    struct Collapse
+    {
+        double cost;
+        unsigned int stamp; // the sum of the versions of both points
+        unsigned long u, v;
+        bool operator < (const Collapse& c) const
+        {
+            // the cheapest collapse comes first
+            return cost > c.cost;
+        }
+    };
+
+    bool IsValid(unsigned long f) const
+    {
+        return corners[3*f] != ULONG_MAX;
+    }
+    bool HasPoint(unsigned long f, unsigned long p) const
+    {
+        return corners[3*f] == p || corners[3*f+1] == p || corners[3*f+2] == p;
+    }
+    void Setup(bool bPreserveBorder)
+    {
+        unsigned long ulCtPoints = points.size();
+        unsigned long ulCtCorners = corners.size();
+        ulCtFacets = ulCtCorners / 3;
+        locked.resize(ulCtPoints, false);
+        removed.assign(ulCtPoints, false);
+        border.assign(ulCtPoints, false);
+        version.assign(ulCtPoints, 0);
+        bool bQuadrics = (quadrics.size() != ulCtPoints);
+        if (bQuadrics)
+            quadrics.assign(ulCtPoints, MeshQuadric());
+        first.assign(ulCtPoints, ULONG_MAX);
+        next.assign(ulCtCorners, ULONG_MAX);
+
+        for (unsigned long c = ulCtCorners; c > 0; c--) {
+            unsigned long p = corners[c-1];
+            next[c-1] = first[p];
+            first[p] = c-1;
+        }
+
+        for (unsigned long f = 0; f < ulCtFacets; f++) {
+            const Base::Vector3f& p0 = points[corners[3*f]];
+            Base::Vector3f n;
+            float len = 0.0f;
+            if (bQuadrics) {
+                const Base::Vector3f& p1 = points[corners[3*f+1]];
+                const Base::Vector3f& p2 = points[corners[3*f+2]];
+                n = (p1 - p0) % (p2 - p0);
+                len = n.Length();
+            }
+            if (len > 0.0f) {
+                n.Scale(1.0f/len, 1.0f/len, 1.0f/len);
+                MeshQuadric q;
+                q.AddPlane(n.x, n.y, n.z, -(n * p0), 1.0);
+                for (int i = 0; i < 3; i++)
+                    quadrics[corners[3*f+i]] += q;
+            }
+
+            for (int i = 0; i < 3; i++) {
+                if ((borders[f] & (1 << i)) == 0)
+                    continue;
+                unsigned long a = corners[3*f+i];
+                unsigned long b = corners[3*f+(i+1)%3];
+                border[a] = border[b] = true;
+                if (bPreserveBorder) {
+                    locked[a] = locked[b] = true;
+                }
+                else if (len > 0.0f) {
+                    // keep the border in place by a heavily weighted plane
+                    // perpendicular to the facet
+                    Base::Vector3f m = (points[b] - points[a]) % n;
+                    float mlen = m.Length();
+                    if (mlen > 0.0f) {
+                        m.Scale(1.0f/mlen, 1.0f/mlen, 1.0f/mlen);
+                        MeshQuadric q;
+                        q.AddPlane(m.x, m.y, m.z, -(m * points[a]), 1000.0);
+                        quadrics[a] += q;
+                        quadrics[b] += q;
+                    }
+                }
+            }
+        }
+
+        // for a consistently oriented mesh each inner edge is added once
+        for (unsigned long f = 0; f < ulCtFacets; f++) {
+            for (int i = 0; i < 3; i++) {
+                unsigned long a = corners[3*f+i];
+                unsigned long b = corners[3*f+(i+1)%3];
+                if (a < b || (borders[f] & (1 << i)) != 0)
+                    Push(a, b);
+            }
+        }
+    }
+    bool Evaluate(unsigned long u, unsigned long v, Base::Vector3f& p, double& cost) const
+    {
+        if (locked[u] && locked[v])
+            return false;
+        MeshQuadric q = quadrics[u];
+        q += quadrics[v];
+        if (locked[u]) {
+            p = points[u];
+        }
+        else if (locked[v]) {
+            p = points[v];
+        }
+        else if (!q.Optimum(p)) {
+            // take the best of the end points and the mid point
+            const Base::Vector3f& pu = points[u];
+            const Base::Vector3f& pv = points[v];
+            Base::Vector3f pm = 0.5f * (pu + pv);
+            double eu = q.Error(pu), ev = q.Error(pv), em = q.Error(pm);
+            if (em <= eu && em <= ev)
+                p = pm;
+            else if (eu <= ev)
+                p = pu;
+            else
+                p = pv;
+        }
+
+        cost = q.Error(p);
+        return true;
+    }
+    void Push(unsigned long u, unsigned long v)
+    {
+        Collapse c;
+        Base::Vector3f p;
+        if (!Evaluate(u, v, p, c.cost))
+            return;
+        c.stamp = version[u] + version[v];
+        c.u = u;
+        c.v = v;
+        queue.push_back(c);
+        std::push_heap(queue.begin(), queue.end());
+    }
+    void CollectNeighbours(unsigned long p, std::vector<unsigned long>& neighbours) const
+    {
+        neighbours.clear();
+        for (unsigned long c = first[p]; c != ULONG_MAX; c = next[c]) {
+            unsigned long f = c / 3;
+            if (!IsValid(f))
+                continue;
+            for (int i = 0; i < 3; i++) {
+                if (corners[3*f+i] != p)
+                    neighbours.push_back(corners[3*f+i]);
+            }
+        }
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+    }
+    /// checks that no facet around \a r flips or degenerates if it's moved to \a p
+    bool CheckFlip(unsigned long r, unsigned long o, const Base::Vector3f& p) const
+    {
+        const Base::Vector3f& pr = points[r];
+        for (unsigned long c = first[r]; c != ULONG_MAX; c = next[c]) {
+            unsigned long f = c / 3;
+            if (!IsValid(f) || HasPoint(f, o))
+                continue;
+            unsigned long k = c % 3;
+            const Base::Vector3f& pa = points[corners[3*f+(k+1)%3]];
+            const Base::Vector3f& pb = points[corners[3*f+(k+2)%3]];
+            Base::Vector3f n1 = (pa - pr) % (pb - pr);
+            Base::Vector3f n2 = (pa - p) % (pb - p);
+            float l1 = n1.Length(), l2 = n2.Length();
+            if (l2 <= FLOAT_EPS * l1)
+                return false;
+            if (n1 * n2 < 0.2f * l1 * l2)
+                return false;
+        }
+        return true;
+    }
+    bool CanCollapse(unsigned long s, unsigned long r, const Base::Vector3f& p)
+    {
+        // the facets at the edge
+        unsigned long ulShared = 0;
+        for (unsigned long c = first[r]; c != ULONG_MAX; c = next[c]) {
+            unsigned long f = c / 3;
+            if (IsValid(f) && HasPoint(f, s))
+                ulShared++;
+        }
+        if (ulShared == 0 || ulShared > 2)
+            return false;
+        // an inner edge between two border points would pinch the mesh
+        if (ulShared == 2 && border[s] && border[r])
+            return false;
+
+        // link condition: the only common neighbours are the opposite points of the edge
+        CollectNeighbours(s, neighbours1);
+        CollectNeighbours(r, neighbours2);
+        common.clear();
+        std::set_intersection(neighbours1.begin(), neighbours1.end(),
+                              neighbours2.begin(), neighbours2.end(),
+                              std::back_inserter(common));
+        if (common.size() != ulShared)
+            return false;
+
+        return CheckFlip(s, r, p) && CheckFlip(r, s, p);
+    }
+    void DoCollapse(unsigned long s, unsigned long r, const Base::Vector3f& p)
+    {
+        points[s] = p;
+        quadrics[s] += quadrics[r];
+        border[s] = border[s] || border[r];
+
+        // move the facets of r to s or remove them if they contain the edge
+        for (unsigned long c = first[r]; c != ULONG_MAX;) {
+            unsigned long nc = next[c];
+            unsigned long f = c / 3;
+            if (IsValid(f)) {
+                if (HasPoint(f, s)) {
+                    corners[3*f] = corners[3*f+1] = corners[3*f+2] = ULONG_MAX;
+                    ulCtFacets--;
+                }
+                else {
+                    corners[c] = s;
+                    next[c] = first[s];
+                    first[s] = c;
+                }
+            }
+            c = nc;
+        }
+        first[r] = ULONG_MAX;
+        removed[r] = true;
+        version[r]++;
+        version[s]++;
+
+        // drop the removed facets from the list of s
+        unsigned long* link = &first[s];
+        while (*link != ULONG_MAX) {
+            if (IsValid(*link / 3))
+                link = &next[*link];
+            else
+                *link = next[*link];
+        }
+
+        CollectNeighbours(s, neighbours1);
+        for (std::vector<unsigned long>::iterator it = neighbours1.begin(); it != neighbours1.end(); ++it)
+            Push(s, *it);
+    }
+
+private:
+    unsigned long ulCtFacets;
+    std::vector<bool> border;
+    std::vector<unsigned int> version;
+    std::vector<unsigned long> first;
+    std::vector<unsigned long> next;
+    std::vector<Collapse> queue; // a heap with the cheapest collapse at the front
+    std::vector<unsigned long> neighbours1, neighbours2, common;
+};
+
+/**
+ * A slab of the mesh for the parallel mode.
+ */
+struct MeshDecimationPart
+{
+    MeshQuadricSimplifier simplifier;
+    std::vector<unsigned long> globalIndex;
+    unsigned long ulTarget;
+    float fTolerance;
+    bool bPreserveBorder;
+
+    void Run()
+    {
+        simplifier.Run(ulTarget, fTolerance, bPreserveBorder);
+    }
+};
+
+}
+
+// ----------------------------------------------------------------------------
+
+MeshDecimation::MeshDecimation(MeshKernel& rclM)
+  : _rclMesh(rclM), _fTolerance(0.0f), _bPreserveBorder(true), _bParallel(false)
+{
+}
+
+MeshDecimation::~MeshDecimation()
+{
+}
+
+void MeshDecimation::SetTolerance(float fTol)
+{
+    _fTolerance = fTol;
+}
+
+void MeshDecimation::SetPreserveBorder(bool on)
+{
+    _bPreserveBorder = on;
+}
+
+void MeshDecimation::SetParallel(bool on)
+{
+    _bParallel = on;
+}
+
+void MeshDecimation::Simplify(unsigned long ulTargetFacets)
+{
+    if (_rclMesh.CountFacets() <= ulTargetFacets)
+        return;
+
+    // in the parallel mode the decimated slabs are merged into the final pass
+    MeshQuadricSimplifier simplifier;
+    bool bParallel = _bParallel && _rclMesh.CountFacets() >= MESH_PARALLEL_ELEMENTS &&
+                     QThread::idealThreadCount() > 1;
+    if (!bParallel || !SimplifyParallel(ulTargetFacets, simplifier)) {
+        const MeshPointArray& rPoints = _rclMesh.GetPoints();
+        const MeshFacetArray& rFacets = _rclMesh.GetFacets();
+        simplifier.points.assign(rPoints.begin(), rPoints.end());
+        simplifier.corners.resize(3 * rFacets.size());
+        simplifier.borders.resize(rFacets.size());
+        unsigned long f = 0;
+        for (MeshFacetArray::_TConstIterator it = rFacets.begin(); it != rFacets.end(); ++it, ++f) {
+            unsigned char flags = 0;
+            for (int i = 0; i < 3; i++) {
+                simplifier.corners[3*f+i] = it->_aulPoints[i];
+                if (it->_aulNeighbours[i] == ULONG_MAX)
+                    flags |= 1 << i;
+            }
+            simplifier.borders[f] = flags;
+        }
+    }
+
+    // the kernel isn't needed during the decimation
+    _rclMesh.Clear();
+    simplifier.Run(ulTargetFacets, _fTolerance, _bPreserveBorder);
+    std::vector<MeshQuadric>().swap(simplifier.quadrics);
+
+    // remove the unused points
+    std::vector<unsigned long> index(simplifier.points.size(), ULONG_MAX);
+    MeshPointArray aPoints;
+    MeshFacetArray aFacets;
+    aFacets.reserve(simplifier.CountFacets());
+    unsigned long ulCtCorners = simplifier.corners.size();
+    for (unsigned long c = 0; c < ulCtCorners; c += 3) {
+        if (simplifier.corners[c] == ULONG_MAX)
+            continue;
+        MeshFacet facet;
+        for (int i = 0; i < 3; i++) {
+            unsigned long p = simplifier.corners[c+i];
+            if (index[p] == ULONG_MAX) {
+                index[p] = aPoints.size();
+                aPoints.push_back(simplifier.points[p]);
+            }
+            facet._aulPoints[i] = index[p];
+        }
+        aFacets.push_back(facet);
+    }
+
+    _rclMesh.Adopt(aPoints, aFacets, true);
+}
+
+bool MeshDecimation::SimplifyParallel(unsigned long ulTargetFacets, MeshQuadricSimplifier& rResult)
+{
+    const MeshPointArray& rPoints = _rclMesh.GetPoints();
+    const MeshFacetArray& rFacets = _rclMesh.GetFacets();
+    unsigned long ulCtPoints = rPoints.size();
+    unsigned long ulCtFacets = rFacets.size();
+
+    // split the mesh into slabs along the longest side of its bounding box
+    Base::BoundBox3f clBox = _rclMesh.GetBoundBox();
+    int axis = 0;
+    float fLength = clBox.LengthX();
+    if (clBox.LengthY() > fLength) {
+        axis = 1;
+        fLength = clBox.LengthY();
+    }
+    if (clBox.LengthZ() > fLength) {
+        axis = 2;
+        fLength = clBox.LengthZ();
+    }
+    float fMin = axis == 0 ? clBox.MinX : (axis == 1 ? clBox.MinY : clBox.MinZ);
+    unsigned long ulCtParts = (unsigned long)QThread::idealThreadCount();
+    if (fLength <= 0.0f)
+        return false;
+
+    // a point shared by several slabs is locked
+    const unsigned long ulShared = ULONG_MAX - 1;
+    std::vector<unsigned long> facetPart(ulCtFacets);
+    std::vector<unsigned long> pointPart(ulCtPoints, ULONG_MAX);
+    unsigned long f = 0;
+    for (MeshFacetArray::_TConstIterator it = rFacets.begin(); it != rFacets.end(); ++it, ++f) {
+        float c = (rPoints[it->_aulPoints[0]][axis] +
+                   rPoints[it->_aulPoints[1]][axis] +
+                   rPoints[it->_aulPoints[2]][axis]) / 3.0f;
+        unsigned long part = (unsigned long)((c - fMin) / fLength * ulCtParts);
+        part = std::min<unsigned long>(part, ulCtParts - 1);
+        facetPart[f] = part;
+        for (int i = 0; i < 3; i++) {
+            unsigned long& rPart = pointPart[it->_aulPoints[i]];
+            if (rPart == ULONG_MAX)
+                rPart = part;
+            else if (rPart != part)
+                rPart = ulShared;
+        }
+    }
+
+    // Lock the shared points and their neighbours. Thus, for a collapse in a
+    // slab all facets around the removed point and its neighbours are in the
+    // same slab and the topology checks give the same result as for the whole mesh.
+    std::vector<bool> lockPoint(ulCtPoints, false);
+    for (MeshFacetArray::_TConstIterator it = rFacets.begin(); it != rFacets.end(); ++it) {
+        if (pointPart[it->_aulPoints[0]] == ulShared ||
+            pointPart[it->_aulPoints[1]] == ulShared ||
+            pointPart[it->_aulPoints[2]] == ulShared) {
+            for (int i = 0; i < 3; i++)
+                lockPoint[it->_aulPoints[i]] = true;
+        }
+    }
+
+    // build the slabs, a point which is not shared has the same local index
+    // in all facets, the local indices of shared points are kept per slab
+    std::vector<MeshDecimationPart> parts(ulCtParts);
+    std::vector<std::map<unsigned long, unsigned long> > sharedIndex(ulCtParts);
+    std::vector<unsigned long> localIndex(ulCtPoints, ULONG_MAX);
+    f = 0;
+    for (MeshFacetArray::_TConstIterator it = rFacets.begin(); it != rFacets.end(); ++it, ++f) {
+        MeshDecimationPart& rPart = parts[facetPart[f]];
+        MeshQuadricSimplifier& rSimplifier = rPart.simplifier;
+        unsigned char flags = 0;
+        for (int i = 0; i < 3; i++) {
+            unsigned long p = it->_aulPoints[i];
+            unsigned long l = localIndex[p];
+            if (pointPart[p] == ulShared) {
+                std::map<unsigned long, unsigned long>::iterator jt = sharedIndex[facetPart[f]].find(p);
+                l = (jt != sharedIndex[facetPart[f]].end() ? jt->second : ULONG_MAX);
+            }
+            if (l == ULONG_MAX) {
+                l = rSimplifier.points.size();
+                rSimplifier.points.push_back(rPoints[p]);
+                rSimplifier.locked.push_back(lockPoint[p]);
+                rPart.globalIndex.push_back(p);
+                if (pointPart[p] == ulShared)
+                    sharedIndex[facetPart[f]][p] = l;
+                else
+                    localIndex[p] = l;
+            }
+            rSimplifier.corners.push_back(l);
+            if (it->_aulNeighbours[i] == ULONG_MAX)
+                flags |= 1 << i;
+        }
+        rSimplifier.borders.push_back(flags);
+    }
+    sharedIndex.clear();
+    std::vector<unsigned long>().swap(localIndex);
+    std::vector<unsigned long>().swap(facetPart);
+    std::vector<unsigned long>().swap(pointPart);
+    std::vector<bool>().swap(lockPoint);
+
+    // each slab is reduced in proportion to its size, the final pass removes the rest
+    for (std::vector<MeshDecimationPart>::iterator it = parts.begin(); it != parts.end(); ++it) {
+        it->ulTarget = (unsigned long)((double)(it->simplifier.corners.size() / 3) *
+                                       (double)ulTargetFacets / (double)ulCtFacets);
+        it->fTolerance = _fTolerance;
+        it->bPreserveBorder = _bPreserveBorder;
+    }
+
+    // the slabs have their own copies of the points
+    _rclMesh.Clear();
+    QtConcurrent::blockingMap(parts, boost::bind(&MeshDecimationPart::Run, _1));
+
+    // Merge the slabs into the final pass. The shared points haven't been moved and
+    // their quadrics are summed up so that the final pass measures the errors against
+    // the planes of the original facets. The unused points are dropped.
+    std::vector<unsigned long> index(ulCtPoints, ULONG_MAX);
+    for (std::vector<MeshDecimationPart>::iterator it = parts.begin(); it != parts.end(); ++it) {
+        MeshQuadricSimplifier& rSimplifier = it->simplifier;
+        unsigned long ulCtLocal = rSimplifier.points.size();
+        for (unsigned long l = 0; l < ulCtLocal; l++) {
+            if (rSimplifier.removed[l])
+                continue;
+            unsigned long& g = index[it->globalIndex[l]];
+            if (g == ULONG_MAX) {
+                g = rResult.points.size();
+                rResult.points.push_back(rSimplifier.points[l]);
+                rResult.quadrics.push_back(rSimplifier.quadrics[l]);
+            }
+            else {
+                rResult.quadrics[g] += rSimplifier.quadrics[l];
+            }
+        }
+        unsigned long ulCtCorners = rSimplifier.corners.size();
+        for (unsigned long c = 0; c < ulCtCorners; c += 3) {
+            if (rSimplifier.corners[c] == ULONG_MAX)
+                continue;
+            for (int i = 0; i < 3; i++)
+                rResult.corners.push_back(index[it->globalIndex[rSimplifier.corners[c+i]]]);
+            rResult.borders.push_back(rSimplifier.borders[c/3]);
+        }
+        // release the memory of the slab
+        rSimplifier = MeshQuadricSimplifier();
+        std::vector<unsigned long>().swap(it->globalIndex);
+    }
+    parts.clear();
+
+    return true;
+}
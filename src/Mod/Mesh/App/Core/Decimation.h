@@ -0,0 +1,72 @@
+/***************************************************************************
+ *   Copyright (c) 2014                                                    *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef MESH_DECIMATION_H
+#define MESH_DECIMATION_H
+
+namespace MeshCore
+{
+class MeshKernel;
+class MeshQuadricSimplifier;
+
+/**
+ * The MeshDecimation class reduces the number of facets of a mesh by edge collapses.
+ * The edges are collapsed in the order of their costs which are measured with the
+ * quadric error metric of Garland and Heckbert, i.e. the sum of the squared distances
+ * of the new point to the planes of the original facets around it. Collapses that
+ * would flip a facet or make the mesh non-manifold are rejected.
+ *
+ * In the parallel mode a large mesh is split into slabs that are decimated
+ * concurrently whereby the points shared by several slabs are kept. Afterwards the
+ * whole mesh is decimated to the target size with the quadrics accumulated in the slabs.
+ */
+class MeshExport MeshDecimation
+{
+public:
+    MeshDecimation(MeshKernel&);
+    ~MeshDecimation();
+
+    /** Sets the maximum error of a collapse, i.e. the square root of its quadric
+     * error. If 0 (the default) the mesh is decimated until the target size is reached.
+     */
+    void SetTolerance(float);
+    /// If true the points at the border are neither moved nor removed (default).
+    void SetPreserveBorder(bool);
+    /// Enables the parallel mode for large meshes. By default it is disabled.
+    void SetParallel(bool);
+    /// Decimates the mesh until it has at most \a ulTargetFacets facets or the tolerance is exceeded.
+    void Simplify(unsigned long ulTargetFacets);
+
+private:
+    bool SimplifyParallel(unsigned long ulTargetFacets, MeshQuadricSimplifier&);
+
+private:
+    MeshKernel& _rclMesh;
+    float _fTolerance;
+    bool _bPreserveBorder;
+    bool _bParallel;
+};
+
+} // namespace MeshCore
+
+#endif // MESH_DECIMATION_H
@@ -30,6 +30,7 @@
 #define MESH_MIN_EDGE_ANGLE        float(RAD(2.0))
 #define MESH_REMOVE_MIN_LEN        true
 #define MESH_REMOVE_G3_EDGES       true
+#define MESH_PARALLEL_ELEMENTS     100000  // Minimum number of elements to process a mesh in parallel
 
 /*
  * general constant definitions
@@ -43,6 +43,86 @@
 
 using namespace MeshCore;
 
+namespace MeshCore {
+
+/*
+ * Collects the indices of the defect elements in ranges. The results of the
+ * ranges are joined in their order, hence the indices are sorted.
+ */
+class MeshDefectCollector : public MeshEvaluationJob
+{
+public:
+    MeshDefectCollector(unsigned long ulCount)
+      : _ulCount(ulCount), _ranges(Split(ulCount)), _indices(_ranges.size())
+    {
+    }
+
+    void Run(unsigned long ulPart)
+    {
+        const std::pair<unsigned long, unsigned long>& range = _ranges[ulPart];
+        for (unsigned long i = range.first; i < range.second; i++)
+            Check(i, _indices[ulPart]);
+    }
+
+    std::vector<unsigned long> Collect(const char* pszText)
+    {
+        Execute(pszText, _ranges.size(), _ulCount);
+        std::vector<unsigned long> aInds;
+        for (std::size_t i = 0; i < _indices.size(); i++)
+            aInds.insert(aInds.end(), _indices[i].begin(), _indices[i].end());
+        return aInds;
+    }
+
+protected:
+    /// adds the indices of the defects found for the element \a ulIndex
+    virtual void Check(unsigned long ulIndex, std::vector<unsigned long>& aInds) const = 0;
+
+private:
+    unsigned long _ulCount;
+    std::vector<std::pair<unsigned long, unsigned long> > _ranges;
+    std::vector<std::vector<unsigned long> > _indices;
+};
+
+class MeshDegeneratedCollector : public MeshDefectCollector
+{
+public:
+    MeshDegeneratedCollector(const MeshKernel& rMesh)
+      : MeshDefectCollector(rMesh.CountFacets()), _rMesh(rMesh)
+    {
+    }
+
+protected:
+    void Check(unsigned long ulIndex, std::vector<unsigned long>& aInds) const
+    {
+        if (_rMesh.GetFacet(ulIndex).IsDegenerated())
+            aInds.push_back(ulIndex);
+    }
+
+private:
+    const MeshKernel& _rMesh;
+};
+
+class MeshDeformedCollector : public MeshDefectCollector
+{
+public:
+    MeshDeformedCollector(const MeshKernel& rMesh)
+      : MeshDefectCollector(rMesh.CountFacets()), _rMesh(rMesh)
+    {
+    }
+
+protected:
+    void Check(unsigned long ulIndex, std::vector<unsigned long>& aInds) const
+    {
+        if (_rMesh.GetFacet(ulIndex).IsDeformed())
+            aInds.push_back(ulIndex);
+    }
+
+private:
+    const MeshKernel& _rMesh;
+};
+
+}
+
 bool MeshEvalInvalids::Evaluate()
 {
   const MeshFacetArray& rFaces = _rclMesh.GetFacets();
@@ -478,15 +558,8 @@ unsigned long MeshEvalDegeneratedFacets::CountEdgeTooSmall (float fMinEdgeLength
 
 std::vector<unsigned long> MeshEvalDegeneratedFacets::GetIndices() const
 {
-  std::vector<unsigned long> aInds;
-  MeshFacetIterator it(_rclMesh);
-  for ( it.Init(); it.More(); it.Next() )
-  {
-    if ( it->IsDegenerated() )
-      aInds.push_back(it.Position());
-  }
-
-  return aInds;
+  MeshDegeneratedCollector collector(_rclMesh);
+  return collector.Collect("Checking for degenerated facets...");
 }
 
 bool MeshFixDegeneratedFacets::Fixup()
@@ -578,8 +651,8 @@ unsigned long MeshFixDegeneratedFacets::RemoveEdgeTooSmall (float fMinEdgeLength
 
             // Redirect all point-indices to the new neighbour point of all facets referencing the
             // deleted point
-            const std::set<unsigned long>& faces = clPt2Facets[pI->second];
-            for (std::set<unsigned long>::const_iterator pF = faces.begin(); pF != faces.end(); ++pF) {
+            MeshIndexRange faces = clPt2Facets[pI->second];
+            for (MeshIndexRange::const_iterator pF = faces.begin(); pF != faces.end(); ++pF) {
                 const MeshFacet &rclF = f_beg[*pF];
 
                 for (int i = 0; i < 3; i++) {
@@ -622,15 +695,8 @@ bool MeshEvalDeformedFacets::Evaluate()
 
 std::vector<unsigned long> MeshEvalDeformedFacets::GetIndices() const
 {
-  std::vector<unsigned long> aInds;
-  MeshFacetIterator it(_rclMesh);
-  for ( it.Init(); it.More(); it.Next() )
-  {
-    if ( it->IsDeformed() )
-      aInds.push_back(it.Position());
-  }
-
-  return aInds;
+  MeshDeformedCollector collector(_rclMesh);
+  return collector.Collect("Checking for deformed facets...");
 }
 
 bool MeshFixDeformedFacets::Fixup()
@@ -701,27 +767,34 @@ bool MeshFixDeformedFacets::Fixup()
 
 // ----------------------------------------------------------------------
 
-bool MeshEvalDentsOnSurface::Evaluate()
+namespace MeshCore {
+
+class MeshDentsCollector : public MeshDefectCollector
 {
-    this->indices.clear();
-    MeshRefPointToFacets  clPt2Facets(_rclMesh);
-    const MeshPointArray& rPntAry = _rclMesh.GetPoints();
-    MeshFacetArray::_TConstIterator f_beg = _rclMesh.GetFacets().begin();
-
-    MeshGeomFacet rTriangle;
-    Base::Vector3f tmp;
-    unsigned long ctPoints = _rclMesh.CountPoints();
-    for (unsigned long index=0; index < ctPoints; index++) {
+public:
+    MeshDentsCollector(const MeshKernel& rMesh)
+      : MeshDefectCollector(rMesh.CountPoints()), _rMesh(rMesh), _clPt2Facets(rMesh)
+    {
+    }
+
+protected:
+    void Check(unsigned long index, std::vector<unsigned long>& aInds) const
+    {
+        const MeshPointArray& rPntAry = _rMesh.GetPoints();
+        MeshFacetArray::_TConstIterator f_beg = _rMesh.GetFacets().begin();
+
+        MeshGeomFacet rTriangle;
+        Base::Vector3f tmp;
         std::vector<unsigned long> point;
         point.push_back(index);
 
         // get the local neighbourhood of the point
-        std::set<unsigned long> nb = clPt2Facets.NeighbourPoints(point,1);
-        const std::set<unsigned long>& faces = clPt2Facets[index];
+        std::set<unsigned long> nb = _clPt2Facets.NeighbourPoints(point,1);
+        MeshIndexRange faces = _clPt2Facets[index];
 
         for (std::set<unsigned long>::iterator pt = nb.begin(); pt != nb.end(); ++pt) {
             const MeshPoint& mp = rPntAry[*pt];
-            for (std::set<unsigned long>::const_iterator
+            for (MeshIndexRange::const_iterator
                 ft = faces.begin(); ft != faces.end(); ++ft) {
                     // the point must not be part of the facet we test
                     if (f_beg[*ft]._aulPoints[0] == *pt)
@@ -731,16 +804,28 @@ bool MeshEvalDentsOnSurface::Evaluate()
                     if (f_beg[*ft]._aulPoints[2] == *pt)
                         continue;
                     // is the point projectable onto the facet?
-                    rTriangle = _rclMesh.GetFacet(f_beg[*ft]);
+                    rTriangle = _rMesh.GetFacet(f_beg[*ft]);
                     if (rTriangle.IntersectWithLine(mp,rTriangle.GetNormal(),tmp)) {
-                        const std::set<unsigned long>& f = clPt2Facets[*pt];
-                        this->indices.insert(this->indices.end(), f.begin(), f.end());
+                        MeshIndexRange f = _clPt2Facets[*pt];
+                        aInds.insert(aInds.end(), f.begin(), f.end());
                         break;
                     }
             }
         }
     }
 
+private:
+    const MeshKernel& _rMesh;
+    MeshRefPointToFacets _clPt2Facets;
+};
+
+}
+
+bool MeshEvalDentsOnSurface::Evaluate()
+{
+    MeshDentsCollector collector(_rclMesh);
+    this->indices = collector.Collect("Checking for dents...");
+
     // remove duplicates
     std::sort(this->indices.begin(), this->indices.end());
     this->indices.erase(std::unique(this->indices.begin(),
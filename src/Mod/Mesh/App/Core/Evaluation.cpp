@@ -28,6 +28,11 @@
 # include <vector>
 #endif
 
+#include <QAtomicInt>
+#include <QThread>
+#include <QtConcurrentMap>
+#include <boost/bind.hpp>
+
 #include <Mod/Mesh/App/WildMagic4/Wm4Matrix3.h>
 #include <Mod/Mesh/App/WildMagic4/Wm4Vector3.h>
 
@@ -42,9 +47,57 @@
 #include <Base/Matrix.h>
 
 #include <Base/Sequencer.h>
+#include <Base/Tools.h>
 
 using namespace MeshCore;
 
+void MeshEvaluationJob::Execute (const char* pszText, unsigned long ulParts, unsigned long ulElements, bool bCanAbort)
+{
+    if (ulParts > 1 && ulElements >= MESH_PARALLEL_ELEMENTS && QThread::idealThreadCount() > 1) {
+        std::vector<unsigned long> parts(ulParts);
+        std::generate(parts.begin(), parts.end(), Base::iotaGen<unsigned long>(0));
+        if (!pszText) {
+            QtConcurrent::blockingMap(parts, boost::bind(&MeshEvaluationJob::Run, this, _1));
+            return;
+        }
+
+        // The parts are processed in groups so that the progress is reported and
+        // a cancellation is checked in the calling thread between the groups.
+        std::size_t group = std::max<std::size_t>(2 * QThread::idealThreadCount(), ulParts / 100);
+        Base::SequencerLauncher seq(pszText, ulParts);
+        for (std::size_t i = 0; i < parts.size(); i += group) {
+            std::vector<unsigned long>::iterator first = parts.begin() + i;
+            std::vector<unsigned long>::iterator last = parts.begin() + std::min(i + group, parts.size());
+            QtConcurrent::blockingMap(first, last, boost::bind(&MeshEvaluationJob::Run, this, _1));
+            for (; first != last; ++first)
+                seq.next(bCanAbort);
+        }
+    }
+    else if (!pszText) {
+        for (unsigned long i = 0; i < ulParts; i++)
+            Run(i);
+    }
+    else {
+        Base::SequencerLauncher seq(pszText, ulParts);
+        for (unsigned long i = 0; i < ulParts; i++) {
+            Run(i);
+            seq.next(bCanAbort);
+        }
+    }
+}
+
+std::vector<std::pair<unsigned long, unsigned long> > MeshEvaluationJob::Split (unsigned long ulCount)
+{
+    // enough ranges to balance the load of the threads and to get a smooth progress
+    unsigned long ulParts = std::min<unsigned long>(std::max<unsigned long>(ulCount / 1000, 1), 100);
+    unsigned long ulStep = (ulCount + ulParts - 1) / ulParts;
+
+    std::vector<std::pair<unsigned long, unsigned long> > ranges;
+    for (unsigned long i = 0; i < ulCount; i += ulStep)
+        ranges.push_back(std::make_pair(i, std::min<unsigned long>(i + ulStep, ulCount)));
+    return ranges;
+}
+
 
 MeshOrientationVisitor::MeshOrientationVisitor() : _nonuniformOrientation(false)
 {
@@ -321,10 +374,62 @@ struct Edge_Less  : public std::binary_function<const Edge_Index&,
             return true;
         else if (x.p1 > y.p1)
             return false;
-        return false;
+        // make the order of the facets of an edge well-defined
+        return x.f < y.f;
     }
 };
 
+/*
+ * Builds up the sorted array of the edges of all facets. Each range of facets
+ * is sorted on its own and the ranges are merged afterwards.
+ */
+class MeshEdgeArrayJob : public MeshEvaluationJob
+{
+public:
+    MeshEdgeArrayJob(const MeshFacetArray& rFacets, std::vector<Edge_Index>& rEdges)
+      : _rFacets(rFacets), _rEdges(rEdges), _ranges(Split(rFacets.size()))
+    {
+        _rEdges.resize(3*rFacets.size());
+    }
+
+    void Run(unsigned long ulPart)
+    {
+        const std::pair<unsigned long, unsigned long>& range = _ranges[ulPart];
+        for (unsigned long f = range.first; f < range.second; f++) {
+            const MeshFacet& rFace = _rFacets[f];
+            for (int i = 0; i < 3; i++) {
+                Edge_Index& item = _rEdges[3*f+i];
+                item.p0 = std::min<unsigned long>(rFace._aulPoints[i], rFace._aulPoints[(i+1)%3]);
+                item.p1 = std::max<unsigned long>(rFace._aulPoints[i], rFace._aulPoints[(i+1)%3]);
+                item.f  = f;
+            }
+        }
+
+        std::sort(_rEdges.begin() + 3*range.first, _rEdges.begin() + 3*range.second, Edge_Less());
+    }
+
+    void Build(const char* pszText)
+    {
+        Execute(pszText, _ranges.size(), _rFacets.size());
+
+        // merge neighboured ranges until the whole array is sorted
+        std::vector<Edge_Index>::iterator begin = _rEdges.begin();
+        for (std::size_t width = 1; width < _ranges.size(); width *= 2) {
+            for (std::size_t i = 0; i + width < _ranges.size(); i += 2*width) {
+                std::size_t last = std::min<std::size_t>(i + 2*width, _ranges.size()) - 1;
+                std::inplace_merge(begin + 3*_ranges[i].first,
+                                   begin + 3*_ranges[i+width].first,
+                                   begin + 3*_ranges[last].second, Edge_Less());
+            }
+        }
+    }
+
+private:
+    const MeshFacetArray& _rFacets;
+    std::vector<Edge_Index>& _rEdges;
+    std::vector<std::pair<unsigned long, unsigned long> > _ranges;
+};
+
 }
 
 bool MeshEvalTopology::Evaluate ()
@@ -333,25 +438,10 @@ bool MeshEvalTopology::Evaluate ()
     // than a map.
     const MeshFacetArray& rclFAry = _rclMesh.GetFacets();
     std::vector<Edge_Index> edges;
-    edges.reserve(3*rclFAry.size());
-
-    // build up an array of edges
-    MeshFacetArray::_TConstIterator pI;
-    Base::SequencerLauncher seq("Checking topology...", rclFAry.size());
-    for (pI = rclFAry.begin(); pI != rclFAry.end(); pI++) {
-        for (int i = 0; i < 3; i++) {
-            Edge_Index item;
-            item.p0 = std::min<unsigned long>(pI->_aulPoints[i], pI->_aulPoints[(i+1)%3]);
-            item.p1 = std::max<unsigned long>(pI->_aulPoints[i], pI->_aulPoints[(i+1)%3]);
-            item.f  = pI - rclFAry.begin();
-            edges.push_back(item);
-        }
 
-        seq.next();
-    }
-
-    // sort the edges
-    std::sort(edges.begin(), edges.end(), Edge_Less());
+    // build up a sorted array of edges
+    MeshEdgeArrayJob job(rclFAry, edges);
+    job.Build("Checking topology...");
 
     // search for non-manifold edges
     unsigned long p0 = ULONG_MAX, p1 = ULONG_MAX;
@@ -471,8 +561,8 @@ bool MeshEvalPointManifolds::Evaluate ()
     unsigned long ctPoints = _rclMesh.CountPoints();
     for (unsigned long index=0; index < ctPoints; index++) {
         // get the local neighbourhood of the point
-        const std::set<unsigned long>& nf = vf_it[index];
-        const std::set<unsigned long>& np = vv_it[index];
+        MeshCore::MeshIndexRange nf = vf_it[index];
+        MeshCore::MeshIndexRange np = vv_it[index];
 
         std::set<unsigned long>::size_type sp, sf;
         sp = np.size();
@@ -588,47 +678,72 @@ bool MeshFixSingleFacet::Fixup ()
 
 // ----------------------------------------------------------------
 
-bool MeshEvalSelfIntersection::Evaluate ()
+namespace MeshCore {
+
+/*
+ * Checks the facets of each grid cell for intersections. Facets that share a
+ * common vertex are not checked because they could but usually do not intersect
+ * each other and the check would detect false-positives, otherwise.
+ */
+class MeshSelfIntersectionJob : public MeshEvaluationJob
 {
-    // Contains bounding boxes for every facet 
-    std::vector<Base::BoundBox3f> boxes;
+public:
+    MeshSelfIntersectionJob(const MeshKernel& rMesh, bool bFirstOnly)
+      : _rMesh(rMesh), _bFirstOnly(bFirstOnly)
+    {
+        // Splits the mesh using grid for speeding up the calculation
+        MeshFacetGrid cMeshFacetGrid(_rMesh);
+        MeshGridIterator clGridIter(cMeshFacetGrid);
+        for (clGridIter.Init(); clGridIter.More(); clGridIter.Next()) {
+            // a single facet cannot intersect
+            if (clGridIter.GetCtElements() < 2)
+                continue;
+            _cells.push_back(std::vector<unsigned long>());
+            clGridIter.GetElements(_cells.back());
+        }
 
-    // Splits the mesh using grid for speeding up the calculation
-    MeshFacetGrid cMeshFacetGrid(_rclMesh);
-    const MeshFacetArray& rFaces = _rclMesh.GetFacets();
-    MeshGridIterator clGridIter(cMeshFacetGrid);
-    unsigned long ulGridX, ulGridY, ulGridZ;
-    cMeshFacetGrid.GetCtGrids(ulGridX, ulGridY, ulGridZ);
+        // Contains bounding boxes for every facet
+        unsigned long ulCtFacets = _rMesh.CountFacets();
+        _boxes.reserve(ulCtFacets);
+        for (unsigned long i = 0; i < ulCtFacets; i++)
+            _boxes.push_back(_rMesh.GetFacet(i).GetBoundBox());
 
-    MeshFacetIterator cMFI(_rclMesh);
-    for (cMFI.Begin(); cMFI.More(); cMFI.Next()) {
-        boxes.push_back((*cMFI).GetBoundBox());
+        _intersections.resize(_cells.size());
     }
 
-    // Calculates the intersections
-    Base::SequencerLauncher seq("Checking for self-intersections...", ulGridX*ulGridY*ulGridZ);
-    for (clGridIter.Init(); clGridIter.More(); clGridIter.Next()) {
-        //Get the facet indices, belonging to the current grid unit
-        std::vector<unsigned long> aulGridElements;
-        clGridIter.GetElements(aulGridElements);
+    unsigned long CountCells() const
+    {
+        return _cells.size();
+    }
+
+    bool HasIntersections() const
+    {
+        return static_cast<int>(_found) != 0;
+    }
 
-        seq.next();
-        if (aulGridElements.size()==0)
-            continue;
+    void GetIntersections(std::vector<std::pair<unsigned long, unsigned long> >& intersection) const
+    {
+        // merge in the order of the cells
+        for (std::size_t i = 0; i < _intersections.size(); i++)
+            intersection.insert(intersection.end(), _intersections[i].begin(), _intersections[i].end());
+    }
+
+    void Run(unsigned long ulPart)
+    {
+        const std::vector<unsigned long>& aulGridElements = _cells[ulPart];
+        std::vector<std::pair<unsigned long, unsigned long> >& intersection = _intersections[ulPart];
+        const MeshFacetArray& rFaces = _rMesh.GetFacets();
 
         MeshGeomFacet facet1, facet2;
         Base::Vector3f pt1, pt2;
-        for (std::vector<unsigned long>::iterator it = aulGridElements.begin(); it != aulGridElements.end(); ++it) {
-            const Base::BoundBox3f& box1 = boxes[*it];
-            cMFI.Set(*it);
-            facet1 = *cMFI;
+        for (std::vector<unsigned long>::const_iterator it = aulGridElements.begin(); it != aulGridElements.end(); ++it) {
+            // abort after the first detected self-intersection
+            if (_bFirstOnly && HasIntersections())
+                return;
+            const Base::BoundBox3f& box1 = _boxes[*it];
+            facet1 = _rMesh.GetFacet(*it);
             const MeshFacet& rface1 = rFaces[*it];
-            for (std::vector<unsigned long>::iterator jt = it; jt != aulGridElements.end(); ++jt) {
-                if (jt == it) // the identical facet
-                    continue;
-                // If the facets share a common vertex we do not check for self-intersections because they 
-                // could but usually do not intersect each other and the algorithm below would detect false-positives,
-                // otherwise
+            for (std::vector<unsigned long>::const_iterator jt = it + 1; jt != aulGridElements.end(); ++jt) {
                 const MeshFacet& rface2 = rFaces[*jt];
                 if (rface1._aulPoints[0] == rface2._aulPoints[0] || 
                     rface1._aulPoints[0] == rface2._aulPoints[1] ||
@@ -643,21 +758,39 @@ bool MeshEvalSelfIntersection::Evaluate ()
                     rface1._aulPoints[2] == rface2._aulPoints[2])
                     continue; // ignore facets sharing a common vertex
 
-                const Base::BoundBox3f& box2 = boxes[*jt];
+                const Base::BoundBox3f& box2 = _boxes[*jt];
                 if (box1 && box2) {
-                    cMFI.Set(*jt);
-                    facet2 = *cMFI;
+                    facet2 = _rMesh.GetFacet(*jt);
                     int ret = facet1.IntersectWithFacet(facet2, pt1, pt2);
                     if (ret == 2) {
-                        // abort after the first detected self-intersection
-                        return false;
+                        intersection.push_back(std::make_pair
+                            <unsigned long, unsigned long>(*it,*jt));
+                        if (_bFirstOnly) {
+                            _found.fetchAndStoreRelaxed(1);
+                            return;
+                        }
                     }
                 }
             }
         }
     }
 
-    return true;
+private:
+    const MeshKernel& _rMesh;
+    bool _bFirstOnly;
+    QAtomicInt _found;
+    std::vector<Base::BoundBox3f> _boxes;
+    std::vector<std::vector<unsigned long> > _cells;
+    std::vector<std::vector<std::pair<unsigned long, unsigned long> > > _intersections;
+};
+
+}
+
+bool MeshEvalSelfIntersection::Evaluate ()
+{
+    MeshSelfIntersectionJob job(_rclMesh, true);
+    job.Execute("Checking for self-intersections...", job.CountCells(), _rclMesh.CountFacets());
+    return !job.HasIntersections();
 }
 
 void MeshEvalSelfIntersection::GetIntersections(const std::vector<std::pair<unsigned long, unsigned long> >& indices,
@@ -684,77 +817,13 @@ void MeshEvalSelfIntersection::GetIntersections(const std::vector<std::pair<unsi
     }
 }
 
-void MeshEvalSelfIntersection::GetIntersections(std::vector<std::pair<unsigned long, unsigned long> >& intersection) const
+void MeshEvalSelfIntersection::GetIntersections(std::vector<std::pair<unsigned long, unsigned long> >& intersection) const
 {
-    // Contains bounding boxes for every facet 
-    std::vector<Base::BoundBox3f> boxes;
-    //intersection.clear();
-
-    // Splits the mesh using grid for speeding up the calculation
-    MeshFacetGrid cMeshFacetGrid(_rclMesh);
-    const MeshFacetArray& rFaces = _rclMesh.GetFacets();
-    MeshGridIterator clGridIter(cMeshFacetGrid);
-    unsigned long ulGridX, ulGridY, ulGridZ;
-    cMeshFacetGrid.GetCtGrids(ulGridX, ulGridY, ulGridZ);
-
-    MeshFacetIterator cMFI(_rclMesh);
-    for(cMFI.Begin(); cMFI.More(); cMFI.Next()) {
-        boxes.push_back((*cMFI).GetBoundBox());
-    }
-
-    // Calculates the intersections
-    Base::SequencerLauncher seq("Checking for self-intersections...", ulGridX*ulGridY*ulGridZ);
-    for (clGridIter.Init(); clGridIter.More(); clGridIter.Next()) {
-        //Get the facet indices, belonging to the current grid unit
-        std::vector<unsigned long> aulGridElements;
-        clGridIter.GetElements(aulGridElements);
-
-        seq.next(true);
-        if (aulGridElements.size()==0)
-            continue;
-
-        MeshGeomFacet facet1, facet2;
-        Base::Vector3f pt1, pt2;
-        for (std::vector<unsigned long>::iterator it = aulGridElements.begin(); it != aulGridElements.end(); ++it) {
-            const Base::BoundBox3f& box1 = boxes[*it];
-            cMFI.Set(*it);
-            facet1 = *cMFI;
-            const MeshFacet& rface1 = rFaces[*it];
-            for (std::vector<unsigned long>::iterator jt = it; jt != aulGridElements.end(); ++jt) {
-                if (jt == it) // the identical facet
-                    continue;
-                // If the facets share a common vertex we do not check for self-intersections because they 
-                // could but usually do not intersect each other and the algorithm below would detect false-positives,
-                // otherwise
-                const MeshFacet& rface2 = rFaces[*jt];
-                if (rface1._aulPoints[0] == rface2._aulPoints[0] || 
-                    rface1._aulPoints[0] == rface2._aulPoints[1] ||
-                    rface1._aulPoints[0] == rface2._aulPoints[2])
-                    continue; // ignore facets sharing a common vertex
-                if (rface1._aulPoints[1] == rface2._aulPoints[0] || 
-                    rface1._aulPoints[1] == rface2._aulPoints[1] ||
-                    rface1._aulPoints[1] == rface2._aulPoints[2])
-                    continue; // ignore facets sharing a common vertex
-                if (rface1._aulPoints[2] == rface2._aulPoints[0] || 
-                    rface1._aulPoints[2] == rface2._aulPoints[1] ||
-                    rface1._aulPoints[2] == rface2._aulPoints[2])
-                    continue; // ignore facets sharing a common vertex
-
-                const Base::BoundBox3f& box2 = boxes[*jt];
-                if (box1 && box2) {
-                    cMFI.Set(*jt);
-                    facet2 = *cMFI;
-                    int ret = facet1.IntersectWithFacet(facet2, pt1, pt2);
-                    if (ret == 2) {
-                        intersection.push_back(std::make_pair
-                            <unsigned long, unsigned long>(*it,*jt));
-                    }
-                }
-            }
-        }
-    }
+    MeshSelfIntersectionJob job(_rclMesh, false);
+    job.Execute("Checking for self-intersections...", job.CountCells(), _rclMesh.CountFacets(), true);
+    job.GetIntersections(intersection);
 }
-
+
 bool MeshFixSelfIntersection::Fixup()
 {
     std::vector<unsigned long> indices;
@@ -803,25 +872,10 @@ bool MeshEvalNeighbourhood::Evaluate ()
     // than a map.
     const MeshFacetArray& rclFAry = _rclMesh.GetFacets();
     std::vector<Edge_Index> edges;
-    edges.reserve(3*rclFAry.size());
-
-    // build up an array of edges
-    MeshFacetArray::_TConstIterator pI;
-    Base::SequencerLauncher seq("Checking indices...", rclFAry.size());
-    for (pI = rclFAry.begin(); pI != rclFAry.end(); pI++) {
-        for (int i = 0; i < 3; i++) {
-            Edge_Index item;
-            item.p0 = std::min<unsigned long>(pI->_aulPoints[i], pI->_aulPoints[(i+1)%3]);
-            item.p1 = std::max<unsigned long>(pI->_aulPoints[i], pI->_aulPoints[(i+1)%3]);
-            item.f  = pI - rclFAry.begin();
-            edges.push_back(item);
-        }
-
-        seq.next();
-    }
 
-    // sort the edges
-    std::sort(edges.begin(), edges.end(), Edge_Less());
+    // build up a sorted array of edges
+    MeshEdgeArrayJob job(rclFAry, edges);
+    job.Build("Checking indices...");
 
     unsigned long p0 = ULONG_MAX, p1 = ULONG_MAX;
     unsigned long f0 = ULONG_MAX, f1 = ULONG_MAX;
@@ -869,25 +923,10 @@ std::vector<unsigned long> MeshEvalNeighbourhood::GetIndices() const
     std::vector<unsigned long> inds;
     const MeshFacetArray& rclFAry = _rclMesh.GetFacets();
     std::vector<Edge_Index> edges;
-    edges.reserve(3*rclFAry.size());
 
-    // build up an array of edges
-    MeshFacetArray::_TConstIterator pI;
-    Base::SequencerLauncher seq("Checking indices...", rclFAry.size());
-    for (pI = rclFAry.begin(); pI != rclFAry.end(); pI++) {
-        for (int i = 0; i < 3; i++) {
-            Edge_Index item;
-            item.p0 = std::min<unsigned long>(pI->_aulPoints[i], pI->_aulPoints[(i+1)%3]);
-            item.p1 = std::max<unsigned long>(pI->_aulPoints[i], pI->_aulPoints[(i+1)%3]);
-            item.f  = pI - rclFAry.begin();
-            edges.push_back(item);
-        }
-
-        seq.next();
-    }
-
-    // sort the edges
-    std::sort(edges.begin(), edges.end(), Edge_Less());
+    // build up a sorted array of edges
+    MeshEdgeArrayJob job(rclFAry, edges);
+    job.Build("Checking indices...");
 
     unsigned long p0 = ULONG_MAX, p1 = ULONG_MAX;
     unsigned long f0 = ULONG_MAX, f1 = ULONG_MAX;
@@ -945,23 +984,30 @@ bool MeshFixNeighbourhood::Fixup()
 void MeshKernel::RebuildNeighbours (unsigned long index)
 {
     std::vector<Edge_Index> edges;
-    edges.reserve(3 * (this->_aclFacetArray.size() - index));
-
-    // build up an array of edges
-    MeshFacetArray::_TConstIterator pI;
-    MeshFacetArray::_TConstIterator pB = this->_aclFacetArray.begin();
-    for (pI = pB + index; pI != this->_aclFacetArray.end(); pI++) {
-        for (int i = 0; i < 3; i++) {
-            Edge_Index item;
-            item.p0 = std::min<unsigned long>(pI->_aulPoints[i], pI->_aulPoints[(i+1)%3]);
-            item.p1 = std::max<unsigned long>(pI->_aulPoints[i], pI->_aulPoints[(i+1)%3]);
-            item.f  = pI - pB;
-            edges.push_back(item);
-        }
+    if (index == 0) {
+        // build up a sorted array of all edges
+        MeshEdgeArrayJob job(this->_aclFacetArray, edges);
+        job.Build(0);
     }
+    else {
+        edges.reserve(3 * (this->_aclFacetArray.size() - index));
+
+        // build up an array of edges
+        MeshFacetArray::_TConstIterator pI;
+        MeshFacetArray::_TConstIterator pB = this->_aclFacetArray.begin();
+        for (pI = pB + index; pI != this->_aclFacetArray.end(); pI++) {
+            for (int i = 0; i < 3; i++) {
+                Edge_Index item;
+                item.p0 = std::min<unsigned long>(pI->_aulPoints[i], pI->_aulPoints[(i+1)%3]);
+                item.p1 = std::max<unsigned long>(pI->_aulPoints[i], pI->_aulPoints[(i+1)%3]);
+                item.f  = pI - pB;
+                edges.push_back(item);
+            }
+        }
 
-    // sort the edges
-    std::sort(edges.begin(), edges.end(), Edge_Less());
+        // sort the edges
+        std::sort(edges.begin(), edges.end(), Edge_Less());
+    }
 
     unsigned long p0 = ULONG_MAX, p1 = ULONG_MAX;
     unsigned long f0 = ULONG_MAX, f1 = ULONG_MAX;
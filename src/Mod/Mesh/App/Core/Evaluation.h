@@ -85,6 +85,37 @@ protected:
 
 // ----------------------------------------------------
 
+/**
+ * The MeshEvaluationJob class is the base of evaluations that can be split into
+ * independent parts, e.g. ranges of facets or cells of a grid. Run() must only
+ * write into data that belongs to the passed part so that the parts can be
+ * processed concurrently. The caller merges the results of the parts in their
+ * order which makes the result independent of the number of threads.
+ */
+class MeshExport MeshEvaluationJob
+{
+public:
+  MeshEvaluationJob () {}
+  virtual ~MeshEvaluationJob () {}
+
+  /** Processes the part with the given index. */
+  virtual void Run (unsigned long ulPart) = 0;
+  /**
+   * Processes all parts in the range [0, ulParts). If the job works on at least
+   * MESH_PARALLEL_ELEMENTS elements the parts are distributed over the global
+   * thread pool, otherwise they are processed in the calling thread. The progress
+   * is reported through the sequencer unless \a pszText is null. If \a bCanAbort is
+   * true the user can cancel the job which throws a Base::AbortException.
+   */
+  void Execute (const char* pszText, unsigned long ulParts, unsigned long ulElements, bool bCanAbort=false);
+  /**
+   * Splits the elements [0, ulCount) into consecutive ranges of similar size.
+   */
+  static std::vector<std::pair<unsigned long, unsigned long> > Split (unsigned long ulCount);
+};
+
+// ----------------------------------------------------
+
 /**
  * This class searches for nonuniform orientation of neighboured facets.
  * @author Werner Mayer
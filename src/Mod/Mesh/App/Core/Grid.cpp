@@ -27,6 +27,10 @@
 # include <algorithm>
 #endif
 
+#include <QThread>
+#include <QtConcurrentMap>
+#include <boost/bind.hpp>
+
 #include "Grid.h"
 #include "Iterator.h"
 
@@ -62,7 +66,8 @@ void MeshGrid::Attach (const MeshKernel &rclM)
 
 void MeshGrid::Clear (void)
 {
-  _aulGrid.clear();
+  _aulOffsets.clear();
+  _aulElements.clear();
   _pclMesh = NULL;  
 }
 
@@ -93,8 +98,6 @@ void MeshGrid::InitGrid (void)
 {
   assert(_pclMesh != NULL);
 
-  unsigned long i, j;
-
   // Grid Laengen berechnen wenn nicht initialisiert
   //
   if ((_ulCtGridsX == 0) || (_ulCtGridsX == 0) || (_ulCtGridsX == 0))
@@ -128,13 +131,85 @@ void MeshGrid::InitGrid (void)
   }
 
   // Daten-Struktur anlegen
-  _aulGrid.clear();
-  _aulGrid.resize(_ulCtGridsX);
-  for (i = 0; i < _ulCtGridsX; i++)
+  _aulOffsets.clear();
+  _aulOffsets.resize(_ulCtGridsX * _ulCtGridsY * _ulCtGridsZ + 1, 0);
+  _aulElements.clear();
+}
+
+namespace MeshCore {
+/** The grids of a range of elements. */
+struct MeshGrid::CellRange
+{
+  unsigned long ulBegin, ulEnd;
+  std::vector<unsigned long> aulCells;    /**< Grid indices. */
+  std::vector<unsigned long> aulElements; /**< Element index to each grid index. */
+};
+}
+
+void MeshGrid::FindCells (unsigned long, std::vector<unsigned long> &) const
+{
+}
+
+void MeshGrid::CollectCells (CellRange &rclRange) const
+{
+  std::vector<unsigned long> aulCells;
+  for (unsigned long i = rclRange.ulBegin; i < rclRange.ulEnd; i++)
   {
-    _aulGrid[i].resize(_ulCtGridsY);
-    for (j = 0; j < _ulCtGridsY; j++)
-      _aulGrid[i][j].resize(_ulCtGridsZ);
+    aulCells.clear();
+    FindCells(i, aulCells);
+    rclRange.aulCells.insert(rclRange.aulCells.end(), aulCells.begin(), aulCells.end());
+    rclRange.aulElements.insert(rclRange.aulElements.end(), aulCells.size(), i);
+  }
+}
+
+void MeshGrid::BuildGrid (void)
+{
+  unsigned long ulCtGrids = _ulCtGridsX * _ulCtGridsY * _ulCtGridsZ;
+  unsigned long ulCtElements = HasElements();
+
+  // split the elements into ordered ranges and determine their grids
+  unsigned long ulCtRanges = 1;
+  if (ulCtElements >= MESH_PARALLEL_ELEMENTS)
+    ulCtRanges = 4 * std::max<unsigned long>(QThread::idealThreadCount(), 1);
+  unsigned long ulStep = ulCtElements / ulCtRanges + 1;
+
+  std::vector<CellRange> aclRanges;
+  for (unsigned long i = 0; i < ulCtElements; i += ulStep)
+  {
+    CellRange clRange;
+    clRange.ulBegin = i;
+    clRange.ulEnd = std::min<unsigned long>(i + ulStep, ulCtElements);
+    aclRanges.push_back(clRange);
+  }
+
+  if (aclRanges.size() > 1)
+    QtConcurrent::blockingMap(aclRanges, boost::bind(&MeshGrid::CollectCells, this, _1));
+  else if (aclRanges.size() == 1)
+    CollectCells(aclRanges.front());
+
+  // count the elements per grid and compute the offsets
+  _aulOffsets.clear();
+  _aulOffsets.resize(ulCtGrids + 1, 0);
+  std::vector<CellRange>::iterator it;
+  std::vector<unsigned long>::iterator jt;
+  for (it = aclRanges.begin(); it != aclRanges.end(); ++it)
+  {
+    for (jt = it->aulCells.begin(); jt != it->aulCells.end(); ++jt)
+      _aulOffsets[*jt + 1]++;
+  }
+  for (unsigned long i = 0; i < ulCtGrids; i++)
+    _aulOffsets[i + 1] += _aulOffsets[i];
+
+  // fill in the elements, as the ranges are ordered the elements of each grid are sorted
+  _aulElements.resize(_aulOffsets.back());
+  std::vector<unsigned long> aulPos(_aulOffsets.begin(), _aulOffsets.end() - 1);
+  for (it = aclRanges.begin(); it != aclRanges.end(); ++it)
+  {
+    for (std::size_t k = 0; k < it->aulCells.size(); k++)
+      _aulElements[aulPos[it->aulCells[k]]++] = it->aulElements[k];
+    // free the memory as soon as possible
+    std::vector<unsigned long>().swap(it->aulCells);
+    std::vector<unsigned long>().swap(it->aulElements);
   }
 }
 
@@ -155,7 +230,7 @@ unsigned long MeshGrid::Inside (const Base::BoundBox3f &rclBB, std::vector<unsig
     {
       for (k = ulMinZ; k <= ulMaxZ; k++)
       {
-        raulElements.insert(raulElements.end(), _aulGrid[i][j][k].begin(), _aulGrid[i][j][k].end());
+        raulElements.insert(raulElements.end(), CellBegin(i, j, k), CellEnd(i, j, k));
       }
     }
   }  
@@ -190,7 +265,7 @@ unsigned long MeshGrid::Inside (const Base::BoundBox3f &rclBB, std::vector<unsig
       for (k = ulMinZ; k <= ulMaxZ; k++)
       {
         if (Base::DistanceP2(GetBoundBox(i, j, k).CalcCenter(), rclOrg) < fMinDistP2)
-          raulElements.insert(raulElements.end(), _aulGrid[i][j][k].begin(), _aulGrid[i][j][k].end());
+          raulElements.insert(raulElements.end(), CellBegin(i, j, k), CellEnd(i, j, k));
       }
     }
   }  
@@ -221,7 +296,7 @@ unsigned long MeshGrid::Inside (const Base::BoundBox3f &rclBB, std::set<unsigned
     {
       for (k = ulMinZ; k <= ulMaxZ; k++)
       {
-        raulElements.insert(_aulGrid[i][j][k].begin(), _aulGrid[i][j][k].end());
+        raulElements.insert(CellBegin(i, j, k), CellEnd(i, j, k));
       }
     }
   }  
@@ -451,7 +526,7 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
           for (unsigned long i = 0; i < _ulCtGridsY; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[nX][i][j].begin(), _aulGrid[nX][i][j].end());
+              raclInd.insert(CellBegin(nX, i, j), CellEnd(nX, i, j));
           }
           nX++;
         }
@@ -465,9 +540,9 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
           for (unsigned long i = 0; i < _ulCtGridsY; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[nX][i][j].begin(), _aulGrid[nX][i][j].end());
+              raclInd.insert(CellBegin(nX, i, j), CellEnd(nX, i, j));
           }
-          nX++;
+          nX--;
         }
         break;
       }
@@ -479,7 +554,7 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[i][nY][j].begin(), _aulGrid[i][nY][j].end());
+              raclInd.insert(CellBegin(i, nY, j), CellEnd(i, nY, j));
           }
           nY++;
         }
@@ -493,7 +568,7 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[i][nY][j].begin(), _aulGrid[i][nY][j].end());
+              raclInd.insert(CellBegin(i, nY, j), CellEnd(i, nY, j));
           }
           nY--;
         }
@@ -507,7 +582,7 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsY; j++)
-              raclInd.insert(_aulGrid[i][j][nZ].begin(), _aulGrid[i][j][nZ].end());
+              raclInd.insert(CellBegin(i, j, nZ), CellEnd(i, j, nZ));
           }
           nZ++;
         }
@@ -521,7 +596,7 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsY; j++)
-              raclInd.insert(_aulGrid[i][j][nZ].begin(), _aulGrid[i][j][nZ].end());
+              raclInd.insert(CellBegin(i, j, nZ), CellEnd(i, j, nZ));
           }
           nZ--;
         }
@@ -587,11 +662,12 @@ void MeshGrid::GetHull (unsigned long ulX, unsigned long ulY, unsigned long ulZ,
 unsigned long MeshGrid::GetElements (unsigned long ulX, unsigned long ulY, unsigned long ulZ,  
                                      std::set<unsigned long> &raclInd) const
 {
-  const std::set<unsigned long> &rclSet = _aulGrid[ulX][ulY][ulZ];
-  if (rclSet.size() > 0)
+  unsigned long ulIndex = CellIndex(ulX, ulY, ulZ);
+  unsigned long ulCount = _aulOffsets[ulIndex + 1] - _aulOffsets[ulIndex];
+  if (ulCount > 0)
   {
-    raclInd.insert(rclSet.begin(), rclSet.end());
-    return rclSet.size();
+    raclInd.insert(_aulElements.begin() + _aulOffsets[ulIndex], _aulElements.begin() + _aulOffsets[ulIndex + 1]);
+    return ulCount;
   }
 
   return 0;
@@ -603,9 +679,7 @@ unsigned long MeshGrid::GetElements(const Base::Vector3f &rclPoint, std::vector<
   if (!CheckPosition(rclPoint, ulX, ulY, ulZ))
     return 0;
 
-  aulFacets.resize(_aulGrid[ulX][ulY][ulZ].size());
-
-  std::copy(_aulGrid[ulX][ulY][ulZ].begin(), _aulGrid[ulX][ulY][ulZ].end(), aulFacets.begin());
+  aulFacets.assign(CellBegin(ulX, ulY, ulZ), CellEnd(ulX, ulY, ulZ));
   return aulFacets.size();
 }
 
@@ -710,15 +784,7 @@ void MeshFacetGrid::RebuildGrid (void)
   InitGrid();
  
   // Daten-Struktur fuellen
-  MeshFacetIterator clFIter(*_pclMesh);
-
-  unsigned long i = 0;
-  for (clFIter.Init(); clFIter.More(); clFIter.Next())
-  {
-//    AddFacet(*clFIter, i++, 2.0f);
-    AddFacet(*clFIter, i++);
-  }
-
+  BuildGrid();
 }
 
 unsigned long MeshFacetGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt) const
@@ -919,8 +985,8 @@ void MeshFacetGrid::SearchNearestFacetInGrid(unsigned long ulX, unsigned long ul
                                              const Base::Vector3f &rclPt, float &rfMinDist,
                                              unsigned long &rulFacetInd) const
 {
-  const std::set<unsigned long> &rclSet = _aulGrid[ulX][ulY][ulZ];
-  for (std::set<unsigned long>::const_iterator pI = rclSet.begin(); pI != rclSet.end(); pI++)
+  std::vector<unsigned long>::const_iterator pE = CellEnd(ulX, ulY, ulZ);
+  for (std::vector<unsigned long>::const_iterator pI = CellBegin(ulX, ulY, ulZ); pI != pE; pI++)
   {
     float fDist = _pclMesh->GetFacet(*pI).DistanceToPoint(rclPt);
     if (fDist < rfMinDist)
@@ -965,12 +1031,13 @@ MeshPointGrid::MeshPointGrid (const MeshKernel &rclM, float fGridLen)
           std::max<unsigned long>((unsigned long)(clBBMesh.LengthZ() / fGridLen), 1));
 }
 
-void MeshPointGrid::AddPoint (const MeshPoint &rclPt, unsigned long ulPtIndex, float fEpsilon)
+void MeshPointGrid::FindCells (unsigned long ulIndex, std::vector<unsigned long> &raulCells) const
 {
   unsigned long ulX, ulY, ulZ;
+  const MeshPoint &rclPt = _pclMesh->GetPoints()[ulIndex];
   Pos(Base::Vector3f(rclPt.x, rclPt.y, rclPt.z), ulX, ulY, ulZ);
   if ( (ulX < _ulCtGridsX) && (ulY < _ulCtGridsY) && (ulZ < _ulCtGridsZ) )
-    _aulGrid[ulX][ulY][ulZ].insert(ulPtIndex);
+    raulCells.push_back(CellIndex(ulX, ulY, ulZ));
 }
 
 void MeshPointGrid::Validate (const MeshKernel &rclMesh)
@@ -1021,14 +1088,7 @@ void MeshPointGrid::RebuildGrid (void)
   InitGrid();
  
   // Daten-Struktur fuellen
-
-  MeshPointIterator cPIter(*_pclMesh);
-
-  unsigned long i = 0;
-  for (cPIter.Init(); cPIter.More(); cPIter.Next())
-  {
-    AddPoint(*cPIter, i++);
-  }
+  BuildGrid();
 }
 
 void MeshPointGrid::Pos (const Base::Vector3f &rclPoint, unsigned long &rulX, unsigned long &rulY, unsigned long &rulZ) const
@@ -1090,7 +1150,7 @@ bool MeshGridIterator::InitOnRay (const Base::Vector3f &rclPt, const Base::Vecto
   if ((_rclGrid.GetBoundBox().IsInBox(rclPt)) == true)
   {  // Voxel bestimmen, indem der Startpunkt liegt
     _rclGrid.Position(rclPt, _ulX, _ulY, _ulZ);
-    raulElements.insert(raulElements.end(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].begin(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].end());
+    raulElements.insert(raulElements.end(), _rclGrid.CellBegin(_ulX, _ulY, _ulZ), _rclGrid.CellEnd(_ulX, _ulY, _ulZ));
     _bValidRay = true;
   }
   else
@@ -1103,7 +1163,7 @@ bool MeshGridIterator::InitOnRay (const Base::Vector3f &rclPt, const Base::Vecto
       else
         _rclGrid.Position(cP1, _ulX, _ulY, _ulZ);
 
-      raulElements.insert(raulElements.end(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].begin(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].end());
+      raulElements.insert(raulElements.end(), _rclGrid.CellBegin(_ulX, _ulY, _ulZ), _rclGrid.CellEnd(_ulX, _ulY, _ulZ));
       _bValidRay = true;
     }
   }
@@ -1154,7 +1214,7 @@ bool MeshGridIterator::NextOnRay (std::vector<unsigned long> &raulElements)
   if ((_bValidRay == true) && (_rclGrid.CheckPos(_ulX, _ulY, _ulZ) == true))
   {
     GridElement pos(_ulX, _ulY, _ulZ); _cSearchPositions.insert(pos);
-    raulElements.insert(raulElements.end(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].begin(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].end()); 
+    raulElements.insert(raulElements.end(), _rclGrid.CellBegin(_ulX, _ulY, _ulZ), _rclGrid.CellEnd(_ulX, _ulY, _ulZ)); 
   }
   else
     _bValidRay = false;  // Strahl ausgetreten
@@ -125,7 +125,7 @@ public:
   bool GetPositionToIndex(unsigned long id, unsigned long& ulX, unsigned long& ulY, unsigned long& ulZ) const;
   /** Returns the number of elements in a given grid. */
   unsigned long GetCtElements(unsigned long ulX, unsigned long ulY, unsigned long ulZ) const
-  { return _aulGrid[ulX][ulY][ulZ].size(); }
+  { unsigned long ulIndex = CellIndex(ulX, ulY, ulZ); return _aulOffsets[ulIndex+1] - _aulOffsets[ulIndex]; }
   /** Validates the grid structure and rebuilds it if needed. Must be implemented in sub-classes. */
   virtual void Validate (const MeshKernel &rclM) = 0;
   /** Verifies the grid structure and returns false if inconsistencies are found. */
@@ -155,9 +155,32 @@ protected:
   virtual void RebuildGrid (void) = 0;
   /** Returns the number of stored elements. Must be implemented in sub-classes. */
   virtual unsigned long HasElements (void) const = 0;
+  /** Appends the indices of all grids the element with index \a ulIndex belongs to. Each grid must be added
+   * only once. This method is used by BuildGrid() and may be called from several threads at the same time.
+   */
+  virtual void FindCells (unsigned long ulIndex, std::vector<unsigned long> &raulCells) const;
+  /** Fills the grid structure with all elements. At first the grids of all elements are determined, for large
+   * meshes this is done in parallel. Then the elements per grid are counted and finally the element indices
+   * are written into one contiguous array. The elements of each grid are sorted by their index.
+   */
+  void BuildGrid (void);
+  /** Returns the index of the grid in the flat data structure. The position is not checked. */
+  inline unsigned long CellIndex (unsigned long ulX, unsigned long ulY, unsigned long ulZ) const
+  { return (ulZ * _ulCtGridsY + ulY) * _ulCtGridsX + ulX; }
+  /** Returns an iterator to the first element index of the given grid. */
+  inline std::vector<unsigned long>::const_iterator CellBegin (unsigned long ulX, unsigned long ulY, unsigned long ulZ) const
+  { return _aulElements.begin() + _aulOffsets[CellIndex(ulX, ulY, ulZ)]; }
+  /** Returns an iterator past the last element index of the given grid. */
+  inline std::vector<unsigned long>::const_iterator CellEnd (unsigned long ulX, unsigned long ulY, unsigned long ulZ) const
+  { return _aulElements.begin() + _aulOffsets[CellIndex(ulX, ulY, ulZ) + 1]; }
+
+private:
+  struct CellRange;
+  void CollectCells (CellRange &rclRange) const;
 
 protected:
-  std::vector<std::vector<std::vector<std::set<unsigned long> > > >  _aulGrid;   /**< Grid data structure. */
+  std::vector<unsigned long> _aulOffsets;  /**< Start of the elements of each grid in _aulElements, has one additional entry at the end. */
+  std::vector<unsigned long> _aulElements; /**< Element indices of all grids. */
   const MeshKernel* _pclMesh;     /**< The mesh kernel. */
   unsigned long     _ulCtElements;/**< Number of grid elements for validation issues. */
   unsigned long     _ulCtGridsX;  /**< Number of grid elements in z. */
@@ -224,10 +247,12 @@ protected:
   inline void Pos (const Base::Vector3f &rclPoint, unsigned long &rulX, unsigned long &rulY, unsigned long &rulZ) const;
   /** Returns the grid numbers to the given point \a rclPoint. */
   inline void PosWithCheck (const Base::Vector3f &rclPoint, unsigned long &rulX, unsigned long &rulY, unsigned long &rulZ) const;
-  /** Adds a new facet element to the grid structure. \a rclFacet is the geometric facet and \a ulFacetIndex 
-   * the corresponding index in the mesh kernel. The facet is added to each grid element that intersects 
+  /** Determines the grids of the facet \a rclFacet. The facet belongs to each grid element that intersects
    * the facet. */
-  inline void AddFacet (const MeshGeomFacet &rclFacet, unsigned long ulFacetIndex, float fEpsilon = 0.0f);
+  inline void FindCells (const MeshGeomFacet &rclFacet, std::vector<unsigned long> &raulCells) const;
+  /** Determines the grids of the facet with index \a ulIndex. */
+  virtual void FindCells (unsigned long ulIndex, std::vector<unsigned long> &raulCells) const
+  { FindCells(_pclMesh->GetFacet(ulIndex), raulCells); }
   /** Returns the number of stored elements. */
   unsigned long HasElements (void) const
   { return _pclMesh->CountFacets(); }
@@ -268,9 +293,8 @@ public:
   virtual bool Verify() const;
 
 protected:
-  /** Adds a new point element to the grid structure. \a rclPt is the geometric point and \a ulPtIndex 
-   * the corresponding index in the mesh kernel. */
-  void AddPoint (const MeshPoint &rclPt, unsigned long ulPtIndex, float fEpsilon = 0.0f);
+  /** Determines the grid of the point with index \a ulIndex. Points outside the grid are ignored. */
+  virtual void FindCells (unsigned long ulIndex, std::vector<unsigned long> &raulCells) const;
   /** Returns the grid numbers to the given point \a rclPoint. */
   void Pos(const Base::Vector3f &rclPoint, unsigned long &rulX, unsigned long &rulY, unsigned long &rulZ) const;
   /** Returns the number of stored elements. */
@@ -295,7 +319,7 @@ public:
   /** Returns indices of the elements in the current grid. */
   void GetElements (std::vector<unsigned long> &raulElements) const
   {
-    raulElements.insert(raulElements.end(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].begin(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].end());
+    raulElements.insert(raulElements.end(), _rclGrid.CellBegin(_ulX, _ulY, _ulZ), _rclGrid.CellEnd(_ulX, _ulY, _ulZ));
   }
   /** Returns the number of elements in the current grid. */
   unsigned long GetCtElements() const
@@ -434,38 +458,8 @@ inline void MeshFacetGrid::PosWithCheck (const Base::Vector3f &rclPoint, unsigne
   assert((rulX < _ulCtGridsX) && (rulY < _ulCtGridsY) && (rulZ < _ulCtGridsZ));
 }
 
-inline void MeshFacetGrid::AddFacet (const MeshGeomFacet &rclFacet, unsigned long ulFacetIndex, float fEpsilon)
+inline void MeshFacetGrid::FindCells (const MeshGeomFacet &rclFacet, std::vector<unsigned long> &raulCells) const
 {
-#if 0
-  unsigned long  i, ulX, ulY, ulZ, ulX1, ulY1, ulZ1, ulX2, ulY2, ulZ2;
-  
-  ulX1 = ulY1 = ulZ1 = ULONG_MAX;
-  ulX2 = ulY2 = ulZ2 = 0;
-
-  for (i = 0; i < 3; i++)
-  {
-    Pos(rclFacet._aclPoints[i], ulX, ulY, ulZ);
-    _aulGrid[ulX][ulY][ulZ].insert(ulFacetIndex);
-    ulX1 = RSmin<unsigned long>(ulX1, ulX); ulY1 = RSmin<unsigned long>(ulY1, ulY); ulZ1 = RSmin<unsigned long>(ulZ1, ulZ);
-    ulX2 = RSmax<unsigned long>(ulX2, ulX); ulY2 = RSmax<unsigned long>(ulY2, ulY); ulZ2 = RSmax<unsigned long>(ulZ2, ulZ);
-  }
-  
-  // falls Facet ueber mehrere BB reicht
-  if ((ulX1 < ulX2) || (ulY1 < ulY2) || (ulZ1 < ulZ2))
-  {
-    for (ulX = ulX1; ulX <= ulX2; ulX++)
-    {
-      for (ulY = ulY1; ulY <= ulY2; ulY++)
-      {
-        for (ulZ = ulZ1; ulZ <= ulZ2; ulZ++)
-        {
-          if (CMeshFacetFunc::BBoxContainFacet(GetBoundBox(ulX, ulY, ulZ), rclFacet) == TRUE)
-            _aulGrid[ulX][ulY][ulZ].insert(ulFacetIndex);
-        }
-      }
-    }
-  }
-#else
   unsigned long ulX, ulY, ulZ;
 
   unsigned long ulX1, ulY1, ulZ1, ulX2, ulY2, ulZ2;
@@ -476,22 +470,8 @@ inline void MeshFacetGrid::AddFacet (const MeshGeomFacet &rclFacet, unsigned lon
   clBB &= rclFacet._aclPoints[1];
   clBB &= rclFacet._aclPoints[2];
 
-  //float fDiagonalLength = clBB.CalcDiagonalLength();
-
-  //clBB.Enlarge(fEpsilon*fDiagonalLength);
-
   Pos(Base::Vector3f(clBB.MinX,clBB.MinY,clBB.MinZ), ulX1, ulY1, ulZ1);
   Pos(Base::Vector3f(clBB.MaxX,clBB.MaxY,clBB.MaxZ), ulX2, ulY2, ulZ2);
-  
-  /*
-  if (ulX1 > 0) ulX1--;
-  if (ulY1 > 0) ulY1--;
-  if (ulZ1 > 0) ulZ1--;
-  
-  if (ulX2 < (_ulCtGridsX-1)) ulX2++;
-  if (ulY2 < (_ulCtGridsY-1)) ulY2++;
-  if (ulZ2 < (_ulCtGridsZ-1)) ulZ2++;
-  */
 
   // falls Facet ueber mehrere BB reicht
   if ((ulX1 < ulX2) || (ulY1 < ulY2) || (ulZ1 < ulZ2))
@@ -503,15 +483,13 @@ inline void MeshFacetGrid::AddFacet (const MeshGeomFacet &rclFacet, unsigned lon
         for (ulZ = ulZ1; ulZ <= ulZ2; ulZ++)
         {
           if ( rclFacet.IntersectBoundingBox( GetBoundBox(ulX, ulY, ulZ) ) )
-            _aulGrid[ulX][ulY][ulZ].insert(ulFacetIndex);
+            raulCells.push_back(CellIndex(ulX, ulY, ulZ));
         }
       }
     }
   }
   else
-    _aulGrid[ulX1][ulY1][ulZ1].insert(ulFacetIndex);
-
-#endif
+    raulCells.push_back(CellIndex(ulX1, ulY1, ulZ1));
 }
 
 } // namespace MeshCore
@@ -36,15 +36,21 @@
 #include <Base/FileInfo.h>
 #include <Base/Sequencer.h>
 #include <Base/Stream.h>
+#include <Base/Swap.h>
 #include <Base/Placement.h>
 #include <zipios++/gzipoutputstream.h>
 
 #include <cmath>
 #include <sstream>
 #include <iomanip>
+#include <boost/bind.hpp>
 #include <boost/regex.hpp>
 #include <boost/algorithm/string.hpp>
 
+#include <QFile>
+#include <QThread>
+#include <QtConcurrentMap>
+
 
 using namespace MeshCore;
 
@@ -95,6 +101,26 @@ std::string& ltrim(std::string& str)
     return str;
 }
 
+// checks the upper-case data after the header of an STL file for keywords of the ASCII format
+static bool hasAsciiSTLKeyword(const char* szBuf)
+{
+    return (strstr(szBuf, "SOLID") != NULL)  || (strstr(szBuf, "FACET") != NULL)    || (strstr(szBuf, "NORMAL") != NULL) ||
+           (strstr(szBuf, "VERTEX") != NULL) || (strstr(szBuf, "ENDFACET") != NULL) || (strstr(szBuf, "ENDLOOP") != NULL);
+}
+
+// decodes the facets of the given range of the data block of a binary STL file
+static void decodeBinarySTL(const char* pData, unsigned long ulOffset, MeshCore::MeshFastBuilder* builder,
+                            const std::pair<unsigned long, unsigned long>& range)
+{
+    Base::Vector3f clVects[4];
+    for (unsigned long i = range.first; i < range.second; i++) {
+        // read normal, points and overread 2 bytes attribute
+        memcpy(clVects, pData + 50 * i, sizeof(clVects));
+        std::swap(clVects[0], clVects[3]);
+        builder->SetFacet(ulOffset + i, clVects);
+    }
+}
+
 int numDigits(int number)
 {
     number = std::abs(number);
@@ -298,6 +324,170 @@ Convert_Camera_Model(Vector *pos, Vector *at, Vector *up, Vector *res_axis,
 	Quaternion_To_Axis_Angle(&rot_quat, res_axis, res_angle);
 }
 
+namespace MeshCore {
+// the scalar types of the PLY format
+enum PlyType {
+    PLY_NONE, PLY_INT8, PLY_UINT8, PLY_INT16, PLY_UINT16,
+    PLY_INT32, PLY_UINT32, PLY_FLOAT32, PLY_FLOAT64
+};
+
+struct PlyProperty {
+    std::string name;
+    PlyType type;
+    PlyType count; // the type of the length of a list, PLY_NONE for scalars
+};
+
+static PlyType plyType(const std::string& type)
+{
+    if (type == "char" || type == "int8")
+        return PLY_INT8;
+    if (type == "uchar" || type == "uint8")
+        return PLY_UINT8;
+    if (type == "short" || type == "int16")
+        return PLY_INT16;
+    if (type == "ushort" || type == "uint16")
+        return PLY_UINT16;
+    if (type == "int" || type == "int32")
+        return PLY_INT32;
+    if (type == "uint" || type == "uint32")
+        return PLY_UINT32;
+    if (type == "float" || type == "float32")
+        return PLY_FLOAT32;
+    if (type == "double" || type == "float64")
+        return PLY_FLOAT64;
+    return PLY_NONE;
+}
+
+static std::size_t plySize(PlyType type)
+{
+    switch (type) {
+    case PLY_INT8:
+    case PLY_UINT8:
+        return 1;
+    case PLY_INT16:
+    case PLY_UINT16:
+        return 2;
+    case PLY_INT32:
+    case PLY_UINT32:
+    case PLY_FLOAT32:
+        return 4;
+    case PLY_FLOAT64:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+template <class T>
+static inline double plyRead(const char* data, bool swap)
+{
+    T value;
+    memcpy(&value, data, sizeof(T));
+    if (swap)
+        Base::SwapEndian<T>(value);
+    return static_cast<double>(value);
+}
+
+static inline double plyValue(const char* data, PlyType type, bool swap)
+{
+    switch (type) {
+    case PLY_INT8:
+        return plyRead<int8_t>(data, swap);
+    case PLY_UINT8:
+        return plyRead<uint8_t>(data, swap);
+    case PLY_INT16:
+        return plyRead<int16_t>(data, swap);
+    case PLY_UINT16:
+        return plyRead<uint16_t>(data, swap);
+    case PLY_INT32:
+        return plyRead<int32_t>(data, swap);
+    case PLY_UINT32:
+        return plyRead<uint32_t>(data, swap);
+    case PLY_FLOAT32:
+        return plyRead<float>(data, swap);
+    case PLY_FLOAT64:
+        return plyRead<double>(data, swap);
+    default:
+        return 0.0;
+    }
+}
+
+// decodes the records of the vertex element of a binary PLY file
+struct PlyVertexDecoder
+{
+    enum { X, Y, Z, Red, Green, Blue };
+    const char* data;
+    std::size_t size;
+    std::size_t offset[6];
+    PlyType type[6];
+    bool swap;
+    MeshPointArray* points;
+    std::vector<App::Color>* colors;
+
+    void decode(const std::pair<unsigned long, unsigned long>& range) const
+    {
+        for (unsigned long i = range.first; i < range.second; i++) {
+            const char* record = data + i * size;
+            MeshPoint& pt = (*points)[i];
+            pt.x = (float)plyValue(record + offset[X], type[X], swap);
+            pt.y = (float)plyValue(record + offset[Y], type[Y], swap);
+            pt.z = (float)plyValue(record + offset[Z], type[Z], swap);
+            if (colors) {
+                float rgb[3];
+                for (int j=0; j<3; j++) {
+                    rgb[j] = (float)plyValue(record + offset[Red+j], type[Red+j], swap);
+                    // integer colors are in the range [0,255]
+                    if (type[Red+j] != PLY_FLOAT32 && type[Red+j] != PLY_FLOAT64)
+                        rgb[j] /= 255.0f;
+                }
+                (*colors)[i] = App::Color(rgb[0], rgb[1], rgb[2]);
+            }
+        }
+    }
+};
+
+// decodes the records of the face element of a binary PLY file if all faces are triangles
+struct PlyFaceDecoder
+{
+    struct Range {
+        unsigned long first, second;
+        bool triangles; // all faces of the range are triangles
+        bool valid; // all point indices are valid
+    };
+    const char* data;
+    std::size_t size;
+    std::size_t offset;
+    PlyType count, index;
+    unsigned long points;
+    bool swap;
+    MeshFacetArray* facets;
+
+    void decode(Range& range) const
+    {
+        std::size_t isize = plySize(index);
+        for (unsigned long i = range.first; i < range.second; i++) {
+            const char* record = data + i * size + offset;
+            if (plyValue(record, count, swap) != 3.0) {
+                range.triangles = false;
+                return;
+            }
+            record += plySize(count);
+            MeshFacet& face = (*facets)[i];
+            for (int j=0; j<3; j++) {
+                double value = plyValue(record + j * isize, index, swap);
+                if (value < 0.0 || value >= double(points)) {
+                    range.valid = false;
+                    face._aulPoints[j] = ULONG_MAX;
+                }
+                else {
+                    face._aulPoints[j] = (unsigned long)value;
+                }
+            }
+        }
+    }
+};
+}
+
 // --------------------------------------------------------------
 
 bool MeshInput::LoadAny(const char* FileName)
@@ -319,7 +509,15 @@ bool MeshInput::LoadAny(const char* FileName)
         // read file
         bool ok = false;
         if (fi.hasExtension("stl") || fi.hasExtension("ast")) {
-            ok = LoadSTL(str);
+            // a binary STL file is mapped into memory and decoded directly
+            QFile file(QString::fromUtf8(FileName));
+            const char* data = 0;
+            if (file.open(QIODevice::ReadOnly) && file.size() > 0)
+                data = reinterpret_cast<const char*>(file.map(0, file.size()));
+            if (data && IsBinarySTL(data, file.size()))
+                ok = LoadBinarySTL(data, file.size());
+            else
+                ok = LoadSTL(str);
         }
         else if (fi.hasExtension("iv")) {
             ok = LoadInventor( str );
@@ -376,8 +574,7 @@ bool MeshInput::LoadSTL (std::istream &rstrIn)
     upper(szBuf);
 
     try {
-        if ((strstr(szBuf, "SOLID") == NULL)  && (strstr(szBuf, "FACET") == NULL)    && (strstr(szBuf, "NORMAL") == NULL) &&
-            (strstr(szBuf, "VERTEX") == NULL) && (strstr(szBuf, "ENDFACET") == NULL) && (strstr(szBuf, "ENDLOOP") == NULL)) {
+        if (!hasAsciiSTLKeyword(szBuf)) {
             // probably binary STL
             buf->pubseekoff(0, std::ios::beg, std::ios::in);
             return LoadBinarySTL(rstrIn);
@@ -667,7 +864,7 @@ bool MeshInput::LoadPLY (std::istream &inp)
         return false; // wrong header
 
     std::string line, element;
-    bool xyz_float=false,xyz_double=false;
+    std::vector<PlyProperty> v_props, f_props;
     MeshIO::Binding rgb_value = MeshIO::OVERALL;
     while (std::getline(inp, line)) {
         std::istringstream str(line);
@@ -735,16 +932,22 @@ bool MeshInput::LoadPLY (std::istream &inp)
         else if (kw == "property") {
             std::string type, name;
             char space;
+            PlyProperty prop;
+            prop.count = PLY_NONE;
+            str >> space >> std::ws >> type >> space >> std::ws;
+            if (type == "list") {
+                std::string count;
+                str >> count >> space >> std::ws >> type >> space >> std::ws;
+                prop.count = plyType(count);
+                if (prop.count == PLY_NONE)
+                    type.clear(); // unknown type
+            }
+            str >> name >> std::ws;
+            prop.name = name;
+            prop.type = plyType(type);
             if (element == "vertex") {
-                str >> space >> std::ws
-                    >> type >> space >> std::ws >> name >> std::ws;
-                if (name == "x") {
-                    if (type == "float" || type == "float32")
-                        xyz_float = true;
-                    else if (type == "double" || type == "float64")
-                        xyz_double = true;
-                }
-                else if (name == "red") {
+                v_props.push_back(prop);
+                if (name == "red") {
                     rgb_value = MeshIO::PER_VERTEX;
                     if (_material) {
                         _material->binding = MeshIO::PER_VERTEX;
@@ -753,6 +956,7 @@ bool MeshInput::LoadPLY (std::istream &inp)
                 }
             }
             else if (element == "face") {
+                f_props.push_back(prop);
             }
         }
         else if (kw == "end_header") {
@@ -820,52 +1024,156 @@ bool MeshInput::LoadPLY (std::istream &inp)
     }
     // binary
     else {
-        Base::InputStream is(inp);
-        if (format == binary_little_endian)
-            is.setByteOrder(Base::Stream::LittleEndian);
-        else
-            is.setByteOrder(Base::Stream::BigEndian);
-        int r,g,b;
-        if (xyz_float) {
-            Base::Vector3f pt;
-            for (std::size_t i = 0; i < v_count; i++) {
-                is >> pt.x >> pt.y >> pt.z;
-                meshPoints.push_back(pt);
-                if (rgb_value == MeshIO::PER_VERTEX) {
-                    is >> r >> g >> b;
-                    if (_material) {
-                        float fr = (float)r/255.0f;
-                        float fg = (float)g/255.0f;
-                        float fb = (float)b/255.0f;
-                        _material->diffuseColor.push_back(App::Color(fr, fg, fb));
-                    }
+        // read in the remaining data at once
+        std::vector<char> data;
+        std::streamoff ulCurr = buf->pubseekoff(0, std::ios::cur, std::ios::in);
+        std::streamoff ulEnd = buf->pubseekoff(0, std::ios::end, std::ios::in);
+        buf->pubseekoff(ulCurr, std::ios::beg, std::ios::in);
+        if (ulCurr >= 0 && ulEnd > ulCurr) {
+            data.resize(ulEnd - ulCurr);
+            if (!inp.read(&data[0], data.size()))
+                return false;
+        }
+        else {
+            char block[4096];
+            while (inp.read(block, sizeof(block)) || inp.gcount() > 0)
+                data.insert(data.end(), block, block + inp.gcount());
+        }
+
+        // swap if the byte order of the file differs from the host
+        bool bigEndian = (Base::SwapOrder() == HIGH_ENDIAN);
+        bool swap = ((format == binary_big_endian) != bigEndian);
+        unsigned long ulCtRanges = 1;
+        if (v_count + f_count >= MESH_PARALLEL_ELEMENTS)
+            ulCtRanges = 4 * std::max<unsigned long>(QThread::idealThreadCount(), 1);
+
+        // the layout of the vertex records
+        PlyVertexDecoder vertex;
+        const char* names[6] = {"x", "y", "z", "red", "green", "blue"};
+        for (int j=0; j<6; j++)
+            vertex.type[j] = PLY_NONE;
+        vertex.size = 0;
+        for (std::vector<PlyProperty>::iterator it = v_props.begin(); it != v_props.end(); ++it) {
+            if (it->count != PLY_NONE || plySize(it->type) == 0)
+                return false; // lists of vertices are not supported
+            for (int j=0; j<6; j++) {
+                if (it->name == names[j]) {
+                    vertex.offset[j] = vertex.size;
+                    vertex.type[j] = it->type;
                 }
             }
+            vertex.size += plySize(it->type);
+        }
+        if (vertex.type[0] == PLY_NONE || vertex.type[1] == PLY_NONE || vertex.type[2] == PLY_NONE)
+            return false;
+        if (data.size() < v_count * vertex.size)
+            return false;
+
+        vertex.data = data.empty() ? 0 : &data[0];
+        vertex.swap = swap;
+        vertex.colors = 0;
+        if (_material && rgb_value == MeshIO::PER_VERTEX &&
+            vertex.type[3] != PLY_NONE && vertex.type[4] != PLY_NONE && vertex.type[5] != PLY_NONE) {
+            _material->diffuseColor.resize(v_count);
+            vertex.colors = &_material->diffuseColor;
+        }
+        meshPoints.resize(v_count);
+        vertex.points = &meshPoints;
+
+        std::vector<std::pair<unsigned long, unsigned long> > v_ranges;
+        unsigned long ulStep = v_count / ulCtRanges + 1;
+        for (unsigned long i = 0; i < v_count; i += ulStep)
+            v_ranges.push_back(std::make_pair(i, std::min<unsigned long>(i + ulStep, v_count)));
+        QtConcurrent::blockingMap(v_ranges, boost::bind(&PlyVertexDecoder::decode, &vertex, _1));
+
+        // the layout of the face records, in case all faces are triangles they have a fixed size
+        const char* f_data = vertex.data + v_count * vertex.size;
+        const char* f_end = vertex.data + data.size();
+        PlyFaceDecoder face;
+        face.size = 0;
+        face.offset = 0;
+        face.count = PLY_NONE;
+        for (std::vector<PlyProperty>::iterator it = f_props.begin(); it != f_props.end(); ++it) {
+            if (it->count != PLY_NONE) {
+                if (face.count != PLY_NONE || plySize(it->count) == 0 || plySize(it->type) == 0)
+                    return false; // only the list of point indices is supported
+                face.offset = face.size;
+                face.count = it->count;
+                face.index = it->type;
+                face.size += plySize(it->count) + 3 * plySize(it->type);
+            }
+            else if (plySize(it->type) == 0) {
+                return false;
+            }
+            else {
+                face.size += plySize(it->type);
+            }
         }
-        else if (xyz_double) {
-            Base::Vector3d pt;
-            for (std::size_t i = 0; i < v_count; i++) {
-                is >> pt.x >> pt.y >> pt.z;
-                meshPoints.push_back(Base::Vector3f((float)pt.x,(float)pt.y,(float)pt.z));
-                if (rgb_value == MeshIO::PER_VERTEX) {
-                    is >> r >> g >> b;
-                    if (_material) {
-                        float fr = (float)r/255.0f;
-                        float fg = (float)g/255.0f;
-                        float fb = (float)b/255.0f;
-                        _material->diffuseColor.push_back(App::Color(fr, fg, fb));
+
+        bool triangles = false;
+        bool valid = true;
+        if (face.count != PLY_NONE && std::size_t(f_end - f_data) >= f_count * face.size) {
+            face.data = f_data;
+            face.swap = swap;
+            face.points = v_count;
+            meshFacets.resize(f_count);
+            face.facets = &meshFacets;
+
+            std::vector<PlyFaceDecoder::Range> f_ranges;
+            ulStep = f_count / ulCtRanges + 1;
+            for (unsigned long i = 0; i < f_count; i += ulStep) {
+                PlyFaceDecoder::Range range;
+                range.first = i;
+                range.second = std::min<unsigned long>(i + ulStep, f_count);
+                range.triangles = true;
+                range.valid = true;
+                f_ranges.push_back(range);
+            }
+            QtConcurrent::blockingMap(f_ranges, boost::bind(&PlyFaceDecoder::decode, &face, _1));
+
+            triangles = true;
+            for (std::vector<PlyFaceDecoder::Range>::iterator it = f_ranges.begin(); it != f_ranges.end(); ++it) {
+                triangles = triangles && it->triangles;
+                valid = valid && it->valid;
+            }
+        }
+
+        if (!triangles) {
+            // faces with a different number of points, go through the records one by one
+            meshFacets.clear();
+            const char* record = f_data;
+            for (std::size_t i = 0; i < f_count && record < f_end; i++) {
+                for (std::vector<PlyProperty>::iterator it = f_props.begin(); it != f_props.end(); ++it) {
+                    if (it->count == PLY_NONE) {
+                        record += plySize(it->type);
+                        continue;
+                    }
+
+                    unsigned long n = (unsigned long)plyValue(record, it->count, swap);
+                    std::size_t isize = plySize(it->type);
+                    record += plySize(it->count);
+                    if (record + n * isize > f_end)
+                        break;
+                    if (n == 3) {
+                        MeshFacet f;
+                        for (int j=0; j<3; j++)
+                            f._aulPoints[j] = (unsigned long)plyValue(record + j * isize, it->type, swap);
+                        if (f._aulPoints[0] < v_count && f._aulPoints[1] < v_count && f._aulPoints[2] < v_count)
+                            meshFacets.push_back(f);
                     }
+                    record += n * isize;
                 }
             }
         }
-        unsigned char n;
-        int f1, f2, f3;
-        for (std::size_t i = 0; i < f_count; i++) {
-            is >> n;
-            if (n==3) {
-                is >> f1 >> f2 >> f3;
-                meshFacets.push_back(MeshFacet(f1,f2,f3));
+        else if (!valid) {
+            // remove the faces with invalid point indices
+            MeshFacetArray faces;
+            faces.reserve(meshFacets.size());
+            for (MeshFacetArray::_TConstIterator it = meshFacets.begin(); it != meshFacets.end(); ++it) {
+                if (it->_aulPoints[0] != ULONG_MAX && it->_aulPoints[1] != ULONG_MAX && it->_aulPoints[2] != ULONG_MAX)
+                    faces.push_back(*it);
             }
+            meshFacets.swap(faces);
         }
     }
 
@@ -1008,8 +1316,6 @@ bool MeshInput::LoadAsciiSTL (std::istream &rstrIn)
 bool MeshInput::LoadBinarySTL (std::istream &rstrIn)
 {
     char szInfo[80];
-    Base::Vector3f clVects[4];
-    uint16_t usAtt; 
     uint32_t ulCt;
 
     if (!rstrIn || rstrIn.bad() == true)
@@ -1039,21 +1345,87 @@ bool MeshInput::LoadBinarySTL (std::istream &rstrIn)
     if (ulCt > ulFac)
         return false;// not a valid STL file
  
-    MeshBuilder builder(this->_rclMesh);
-    builder.Initialize(ulCt);
+    try {
+        MeshFastBuilder builder(this->_rclMesh);
+        builder.Initialize(ulCt);
+
+        // read the facets in blocks
+        const uint32_t ulBlock = 20000;
+        std::vector<char> buffer(50 * std::min<uint32_t>(ulCt, ulBlock) + 1);
+        Base::SequencerLauncher seq("Loading STL...", ulCt / ulBlock + 1);
+        for (uint32_t i = 0; i < ulCt; i += ulBlock) {
+            uint32_t ulRead = std::min<uint32_t>(ulCt - i, ulBlock);
+            if (!rstrIn.read(&buffer[0], 50 * ulRead))
+                return false;
+            decodeBinarySTL(&buffer[0], i, &builder, std::make_pair<unsigned long, unsigned long>(0, ulRead));
+            seq.next(true); // allow to cancel
+        }
 
-    for (uint32_t i = 0; i < ulCt; i++) {
-        // read normal, points
-        rstrIn.read((char*)&clVects, sizeof(clVects));
+        builder.Finish();
+    }
+    catch (const Base::AbortException&) {
+        _rclMesh.Clear();
+        return false;
+    }
 
-        std::swap(clVects[0], clVects[3]);
-        builder.AddFacet(clVects);
+    return true;
+}
 
-        // overread 2 bytes attribute
-        rstrIn.read((char*)&usAtt, sizeof(usAtt));
-    }
+/** Checks whether the data block is a binary STL file. */
+bool MeshInput::IsBinarySTL (const char* pData, std::size_t ulSize)
+{
+    // see LoadSTL()
+    const std::size_t ulHeader = 80 + sizeof(uint32_t);
+    if (ulSize < ulHeader)
+        return false;
+    uint32_t ulCt;
+    memcpy(&ulCt, pData + 80, sizeof(ulCt));
+    std::size_t ulBytes = ulCt > 1 ? 100 : 50;
+    if (ulSize < ulHeader + ulBytes)
+        return false;
 
-    builder.Finish();
+    char szBuf[200];
+    memcpy(szBuf, pData + ulHeader, ulBytes);
+    szBuf[ulBytes] = 0;
+    upper(szBuf);
+    return !hasAsciiSTLKeyword(szBuf);
+}
+
+/** Loads a binary STL file from a data block, e.g. a file mapped into memory.
+ * The facets are decoded by several threads.
+ */
+bool MeshInput::LoadBinarySTL (const char* pData, std::size_t ulSize)
+{
+    const std::size_t ulHeader = 80 + sizeof(uint32_t);
+    if (ulSize < ulHeader)
+        return false;
+    uint32_t ulCt;
+    memcpy(&ulCt, pData + 80, sizeof(ulCt));
+
+    // compare the calculated with the read value
+    if (ulCt > (ulSize - ulHeader) / 50)
+        return false;// not a valid STL file
+
+    try {
+        MeshFastBuilder builder(this->_rclMesh);
+        builder.Initialize(ulCt);
+
+        // split the facets into ranges
+        unsigned long ulCtRanges = 1;
+        if (ulCt >= MESH_PARALLEL_ELEMENTS)
+            ulCtRanges = 4 * std::max<unsigned long>(QThread::idealThreadCount(), 1);
+        unsigned long ulStep = ulCt / ulCtRanges + 1;
+        std::vector<std::pair<unsigned long, unsigned long> > ranges;
+        for (unsigned long i = 0; i < ulCt; i += ulStep)
+            ranges.push_back(std::make_pair(i, std::min<unsigned long>(i + ulStep, ulCt)));
+
+        QtConcurrent::blockingMap(ranges, boost::bind(&decodeBinarySTL, pData + ulHeader, 0, &builder, _1));
+        builder.Finish();
+    }
+    catch (const Base::AbortException&) {
+        _rclMesh.Clear();
+        return false;
+    }
 
     return true;
 }
@@ -1379,6 +1751,276 @@ bool MeshInput::LoadCadmouldFE (std::ifstream &rstrIn)
 std::string MeshOutput::stl_header = "MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-"
                                      "MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH\n";
 
+namespace MeshCore {
+/*
+ * Writes a sequence of elements in blocks. The blocks of a batch are encoded
+ * concurrently into their own buffers which are then written in order. Thus,
+ * the memory of the buffers is limited to the size of a batch.
+ */
+class MeshBlockEncoder
+{
+public:
+    struct Block {
+        unsigned long first, last;
+        std::string data;
+    };
+
+    MeshBlockEncoder() {}
+    virtual ~MeshBlockEncoder() {}
+
+    /// writes the elements [0, count) into the stream
+    bool Write(std::ostream& out, unsigned long count) const
+    {
+        const unsigned long ulBlockSize = 16384;
+        unsigned long ulCtBlocks = 1;
+        if (count >= MESH_PARALLEL_ELEMENTS)
+            ulCtBlocks = 4 * std::max<unsigned long>(QThread::idealThreadCount(), 1);
+
+        Base::SequencerLauncher seq("saving...", count / ulBlockSize + 1);
+        std::vector<Block> blocks;
+        for (unsigned long i = 0; i < count; i += ulCtBlocks * ulBlockSize) {
+            blocks.resize(std::min<unsigned long>(ulCtBlocks, (count - i + ulBlockSize - 1) / ulBlockSize));
+            for (std::size_t j = 0; j < blocks.size(); j++) {
+                blocks[j].first = i + j * ulBlockSize;
+                blocks[j].last = std::min<unsigned long>(blocks[j].first + ulBlockSize, count);
+                blocks[j].data.clear();
+            }
+
+            if (blocks.size() > 1)
+                QtConcurrent::blockingMap(blocks, boost::bind(&MeshBlockEncoder::Encode, this, _1));
+            else
+                Encode(blocks.front());
+
+            for (std::vector<Block>::iterator it = blocks.begin(); it != blocks.end(); ++it) {
+                out.write(it->data.c_str(), it->data.size());
+                seq.next(true); // allow to cancel
+            }
+            if (!out)
+                return false;
+        }
+
+        return true;
+    }
+
+protected:
+    /// encodes the elements of the block into its buffer
+    virtual void Encode(Block&) const = 0;
+
+    static void AppendFloat(std::string& data, float value)
+    {
+        data.append(reinterpret_cast<const char*>(&value), sizeof(float));
+    }
+};
+
+// the facets of a binary STL file
+class MeshBinarySTLEncoder : public MeshBlockEncoder
+{
+public:
+    MeshBinarySTLEncoder(const MeshKernel& mesh, const Base::Matrix4D& mat)
+      : _mesh(mesh), _mat(mat)
+    {
+    }
+
+protected:
+    void Encode(Block& block) const
+    {
+        MeshFacetIterator clIter(_mesh);
+        clIter.Transform(_mat);
+        uint16_t usAtt = 0;
+        block.data.reserve(50 * (block.last - block.first));
+        for (unsigned long i = block.first; i < block.last; i++) {
+            clIter.Set(i);
+            const MeshGeomFacet& rFacet = *clIter;
+            // normal
+            Base::Vector3f normal = rFacet.GetNormal();
+            AppendFloat(block.data, normal.x);
+            AppendFloat(block.data, normal.y);
+            AppendFloat(block.data, normal.z);
+            // vertices
+            for (int j = 0; j < 3; j++) {
+                AppendFloat(block.data, rFacet._aclPoints[j].x);
+                AppendFloat(block.data, rFacet._aclPoints[j].y);
+                AppendFloat(block.data, rFacet._aclPoints[j].z);
+            }
+            // attribute
+            block.data.append(reinterpret_cast<const char*>(&usAtt), sizeof(usAtt));
+        }
+    }
+
+private:
+    const MeshKernel& _mesh;
+    Base::Matrix4D _mat;
+};
+
+// the facets of an ASCII STL file
+class MeshAsciiSTLEncoder : public MeshBlockEncoder
+{
+public:
+    MeshAsciiSTLEncoder(const MeshKernel& mesh, const Base::Matrix4D& mat)
+      : _mesh(mesh), _mat(mat)
+    {
+    }
+
+protected:
+    void Encode(Block& block) const
+    {
+        MeshFacetIterator clIter(_mesh);
+        clIter.Transform(_mat);
+        std::ostringstream str;
+        str.precision(6);
+        str.setf(std::ios::fixed | std::ios::showpoint);
+        for (unsigned long i = block.first; i < block.last; i++) {
+            clIter.Set(i);
+            const MeshGeomFacet& rFacet = *clIter;
+            // normal
+            Base::Vector3f normal = rFacet.GetNormal();
+            str << "  facet normal " << normal.x << " " << normal.y << " " << normal.z << '\n';
+            str << "    outer loop" << '\n';
+            // vertices
+            for (int j = 0; j < 3; j++) {
+                str << "      vertex "  << rFacet._aclPoints[j].x << " "
+                                        << rFacet._aclPoints[j].y << " "
+                                        << rFacet._aclPoints[j].z << '\n';
+            }
+            str << "    endloop" << '\n';
+            str << "  endfacet" << '\n';
+        }
+        block.data = str.str();
+    }
+
+private:
+    const MeshKernel& _mesh;
+    Base::Matrix4D _mat;
+};
+
+// the vertices of an OBJ file
+class MeshOBJPointEncoder : public MeshBlockEncoder
+{
+public:
+    MeshOBJPointEncoder(const MeshPointArray& points, const Base::Matrix4D& mat, bool apply, const std::ostream& fmt)
+      : _points(points), _mat(mat), _apply(apply), _fmt(fmt)
+    {
+    }
+
+protected:
+    void Encode(Block& block) const
+    {
+        std::ostringstream str;
+        str.flags(_fmt.flags());
+        str.precision(_fmt.precision());
+        str.imbue(_fmt.getloc());
+        Base::Vector3f pt;
+        for (unsigned long i = block.first; i < block.last; i++) {
+            pt = _points[i];
+            if (_apply)
+                pt = _mat * pt;
+            str << "v " << pt.x << " " << pt.y << " " << pt.z << '\n';
+        }
+        block.data = str.str();
+    }
+
+private:
+    const MeshPointArray& _points;
+    Base::Matrix4D _mat;
+    bool _apply;
+    const std::ostream& _fmt;
+};
+
+// the facets of an OBJ file
+class MeshOBJFacetEncoder : public MeshBlockEncoder
+{
+public:
+    MeshOBJFacetEncoder(const MeshFacetArray& facets, const std::ostream& fmt)
+      : _facets(facets), _fmt(fmt)
+    {
+    }
+
+protected:
+    void Encode(Block& block) const
+    {
+        std::ostringstream str;
+        str.flags(_fmt.flags());
+        str.imbue(_fmt.getloc());
+        for (unsigned long i = block.first; i < block.last; i++) {
+            const MeshFacet& f = _facets[i];
+            str << "f " << f._aulPoints[0]+1 << " "
+                        << f._aulPoints[1]+1 << " "
+                        << f._aulPoints[2]+1 << '\n';
+        }
+        block.data = str.str();
+    }
+
+private:
+    const MeshFacetArray& _facets;
+    const std::ostream& _fmt;
+};
+
+// the vertices of a binary PLY file in the byte order of the host
+class MeshPLYPointEncoder : public MeshBlockEncoder
+{
+public:
+    MeshPLYPointEncoder(const MeshPointArray& points, const Base::Matrix4D& mat, bool apply,
+                        const std::vector<App::Color>* colors)
+      : _points(points), _mat(mat), _apply(apply), _colors(colors)
+    {
+    }
+
+protected:
+    void Encode(Block& block) const
+    {
+        block.data.reserve(15 * (block.last - block.first));
+        Base::Vector3f pt;
+        for (unsigned long i = block.first; i < block.last; i++) {
+            pt = _points[i];
+            if (_apply)
+                pt = _mat * pt;
+            AppendFloat(block.data, pt.x);
+            AppendFloat(block.data, pt.y);
+            AppendFloat(block.data, pt.z);
+            if (_colors) {
+                const App::Color& c = (*_colors)[i];
+                block.data += (char)(unsigned char)(255.0f * c.r);
+                block.data += (char)(unsigned char)(255.0f * c.g);
+                block.data += (char)(unsigned char)(255.0f * c.b);
+            }
+        }
+    }
+
+private:
+    const MeshPointArray& _points;
+    Base::Matrix4D _mat;
+    bool _apply;
+    const std::vector<App::Color>* _colors;
+};
+
+// the facets of a binary PLY file in the byte order of the host
+class MeshPLYFacetEncoder : public MeshBlockEncoder
+{
+public:
+    MeshPLYFacetEncoder(const MeshFacetArray& facets)
+      : _facets(facets)
+    {
+    }
+
+protected:
+    void Encode(Block& block) const
+    {
+        block.data.reserve(13 * (block.last - block.first));
+        for (unsigned long i = block.first; i < block.last; i++) {
+            const MeshFacet& f = _facets[i];
+            block.data += (char)3;
+            for (int j = 0; j < 3; j++) {
+                int32_t index = (int32_t)f._aulPoints[j];
+                block.data.append(reinterpret_cast<const char*>(&index), sizeof(index));
+            }
+        }
+    }
+
+private:
+    const MeshFacetArray& _facets;
+};
+}
+
 void MeshOutput::SetSTLHeaderData(const std::string& header)
 {
     if (header.size() > 80) {
@@ -1546,47 +2188,21 @@ bool MeshOutput::SaveAny(const char* FileName, MeshIO::Format format) const
 /** Saves the mesh object into an ASCII file. */
 bool MeshOutput::SaveAsciiSTL (std::ostream &rstrOut) const
 {
-    MeshFacetIterator clIter(_rclMesh), clEnd(_rclMesh);
-    clIter.Transform(this->_transform);
-    const MeshGeomFacet *pclFacet;
-    unsigned long i;
-
     if (!rstrOut || rstrOut.bad() == true || _rclMesh.CountFacets() == 0)
         return false;
 
     rstrOut.precision(6);
     rstrOut.setf(std::ios::fixed | std::ios::showpoint);
-    Base::SequencerLauncher seq("saving...", _rclMesh.CountFacets() + 1);
 
     if (this->objectName.empty())
         rstrOut << "solid Mesh" << std::endl;
     else
         rstrOut << "solid " << this->objectName << std::endl;
 
-    clIter.Begin();
-    clEnd.End();
-    while (clIter < clEnd) {
-        pclFacet = &(*clIter);
-      
-        // normal
-        rstrOut << "  facet normal " << pclFacet->GetNormal().x << " " 
-                                     << pclFacet->GetNormal().y << " "
-                                     << pclFacet->GetNormal().z << std::endl;
-        rstrOut << "    outer loop" << std::endl;
-
-        // vertices
-        for (i = 0; i < 3; i++) {
-            rstrOut << "      vertex "  << pclFacet->_aclPoints[i].x << " "
-                                        << pclFacet->_aclPoints[i].y << " "
-                                        << pclFacet->_aclPoints[i].z << std::endl;
-        }
-
-        rstrOut << "    endloop" << std::endl;
-        rstrOut << "  endfacet" << std::endl;
-
-        ++clIter; 
-        seq.next(true);// allow to cancel
-    }
+    // the facets are formatted block-wise and in parallel for large meshes
+    MeshAsciiSTLEncoder encoder(_rclMesh, this->_transform);
+    if (!encoder.Write(rstrOut, _rclMesh.CountFacets()))
+        return false;
 
     rstrOut << "endsolid Mesh" << std::endl;
  
@@ -1596,50 +2212,20 @@ bool MeshOutput::SaveAsciiSTL (std::ostream &rstrOut) const
 /** Saves the mesh object into a binary file. */
 bool MeshOutput::SaveBinarySTL (std::ostream &rstrOut) const
 {
-    MeshFacetIterator clIter(_rclMesh), clEnd(_rclMesh);
-    clIter.Transform(this->_transform);
-    const MeshGeomFacet *pclFacet;
-    uint32_t i;
-    uint16_t usAtt;
     char szInfo[81];
 
     if (!rstrOut || rstrOut.bad() == true /*|| _rclMesh.CountFacets() == 0*/)
         return false;
 
-    Base::SequencerLauncher seq("saving...", _rclMesh.CountFacets() + 1);  
- 
     strcpy(szInfo, stl_header.c_str());
     rstrOut.write(szInfo, std::strlen(szInfo));
 
     uint32_t uCtFts = (uint32_t)_rclMesh.CountFacets();
     rstrOut.write((const char*)&uCtFts, sizeof(uCtFts));
 
-    usAtt = 0;
-    clIter.Begin();
-    clEnd.End();
-    while (clIter < clEnd) {
-        pclFacet = &(*clIter);
-        // normal
-        Base::Vector3f normal = pclFacet->GetNormal();
-        rstrOut.write((const char*)&(normal.x), sizeof(float));
-        rstrOut.write((const char*)&(normal.y), sizeof(float));
-        rstrOut.write((const char*)&(normal.z), sizeof(float));
-
-        // vertices
-        for (i = 0; i < 3; i++) {
-            rstrOut.write((const char*)&(pclFacet->_aclPoints[i].x), sizeof(float));
-            rstrOut.write((const char*)&(pclFacet->_aclPoints[i].y), sizeof(float));
-            rstrOut.write((const char*)&(pclFacet->_aclPoints[i].z), sizeof(float));
-        }
-
-        // attribute 
-        rstrOut.write((const char*)&usAtt, sizeof(usAtt));
-
-        ++clIter;
-        seq.next(true); // allow to cancel
-    }
-
-    return true;
+    // the records are encoded into blocks of memory instead of writing each value
+    MeshBinarySTLEncoder encoder(_rclMesh, this->_transform);
+    return encoder.Write(rstrOut, uCtFts);
 }
 
 /** Saves an OBJ file. */
@@ -1651,32 +2237,13 @@ bool MeshOutput::SaveOBJ (std::ostream &rstrOut) const
     if (!rstrOut || rstrOut.bad() == true)
         return false;
 
-    Base::SequencerLauncher seq("saving...", _rclMesh.CountPoints() + _rclMesh.CountFacets());  
-
     // vertices
-    if (this->apply_transform) {
-        Base::Vector3f pt;
-        for (MeshPointArray::_TConstIterator it = rPoints.begin(); it != rPoints.end(); ++it) {
-            pt = this->_transform * *it;
-            rstrOut << "v " << pt.x << " " << pt.y << " " << pt.z << std::endl;
-            seq.next(true); // allow to cancel
-        }
-    }
-    else {
-        for (MeshPointArray::_TConstIterator it = rPoints.begin(); it != rPoints.end(); ++it) {
-            rstrOut << "v " << it->x << " " << it->y << " " << it->z << std::endl;
-            seq.next(true); // allow to cancel
-        }
-    }
+    MeshOBJPointEncoder points(rPoints, this->_transform, this->apply_transform, rstrOut);
+    if (!points.Write(rstrOut, rPoints.size()))
+        return false;
     // facet indices (no texture and normal indices)
-    for (MeshFacetArray::_TConstIterator it = rFacets.begin(); it != rFacets.end(); ++it) {
-        rstrOut << "f " << it->_aulPoints[0]+1 << " "
-                        << it->_aulPoints[1]+1 << " "
-                        << it->_aulPoints[2]+1 << std::endl;
-        seq.next(true); // allow to cancel
-    }
-
-    return true;
+    MeshOBJFacetEncoder facets(rFacets, rstrOut);
+    return facets.Write(rstrOut, rFacets.size());
 }
 
 /** Saves an OFF file. */
@@ -1730,8 +2297,11 @@ bool MeshOutput::SaveBinaryPLY (std::ostream &out) const
         return false;
     bool saveVertexColor = (_material && _material->binding == MeshIO::PER_VERTEX
         && _material->diffuseColor.size() == rPoints.size());
+    // the data is written in the byte order of the host
+    const char* format = (Base::SwapOrder() == LOW_ENDIAN
+        ? "binary_little_endian" : "binary_big_endian");
     out << "ply" << std::endl
-        << "format binary_little_endian 1.0" << std::endl
+        << "format " << format << " 1.0" << std::endl
         << "comment Created by FreeCAD <http://www.freecadweb.org>" << std::endl
         << "element vertex " << v_count << std::endl
         << "property float32 x" << std::endl
@@ -1746,36 +2316,14 @@ bool MeshOutput::SaveBinaryPLY (std::ostream &out) const
         << "property list uchar int vertex_index" << std::endl
         << "end_header" << std::endl;
 
-    Base::OutputStream os(out);
-    os.setByteOrder(Base::Stream::LittleEndian);
-    Base::Vector3f pt;
-    for (std::size_t i = 0; i < v_count; i++) {
-        const MeshPoint& p = rPoints[i];
-        if (this->apply_transform) {
-            Base::Vector3f pt = this->_transform * p;
-            os << pt.x << pt.y << pt.z;
-        }
-        else {
-            os << p.x << p.y << p.z;
-        }
-        if (saveVertexColor) {
-            const App::Color& c = _material->diffuseColor[i];
-            int r = (int)(255.0f * c.r);
-            int g = (int)(255.0f * c.g);
-            int b = (int)(255.0f * c.b);
-            os << r << g << b;
-        }
-    }
-    unsigned char n = 3;
-    int f1, f2, f3;
-    for (std::size_t i = 0; i < f_count; i++) {
-        const MeshFacet& f = rFacets[i];
-        f1 = (int)f._aulPoints[0];
-        f2 = (int)f._aulPoints[1];
-        f3 = (int)f._aulPoints[2];
-        os << n;
-        os << f1 << f2 << f3;
-    }
+    // the colors are written as uchar as declared in the header
+    MeshPLYPointEncoder points(rPoints, this->_transform, this->apply_transform,
+        saveVertexColor ? &_material->diffuseColor : 0);
+    if (!points.Write(out, v_count))
+        return false;
+    MeshPLYFacetEncoder facets(rFacets);
+    if (!facets.Write(out, f_count))
+        return false;
 
     return true;
 }
@@ -92,6 +92,10 @@ public:
     bool LoadAsciiSTL (std::istream &rstrIn);
     /** Loads a binary STL file. */
     bool LoadBinarySTL (std::istream &rstrIn);
+    /** Loads a binary STL file from a data block, e.g. a file mapped into memory. */
+    bool LoadBinarySTL (const char* pData, std::size_t ulSize);
+    /** Checks whether the data block contains a binary STL file. */
+    static bool IsBinarySTL (const char* pData, std::size_t ulSize);
     /** Loads an OBJ Mesh file. */
     bool LoadOBJ (std::istream &rstrIn);
     /** Loads an OFF Mesh file. */
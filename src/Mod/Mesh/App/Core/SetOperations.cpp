@@ -25,6 +25,7 @@
 
 
 #ifndef _PreComp_
+# include <algorithm>
 # include <ios>
 #endif
 
@@ -46,9 +47,257 @@
 #include <Base/Builder3D.h>
 #include <Base/Tools2D.h>
 
+#include <QThread>
+#include <QtConcurrentMap>
+#include <boost/bind.hpp>
+
 using namespace Base;
 using namespace MeshCore;
 
+namespace MeshCore {
+
+/**
+ * Bounding volume hierarchy of the facets of a mesh. It is used to find the pairs
+ * of facets of two meshes whose bounding boxes overlap.
+ */
+class MeshFacetBVH
+{
+public:
+  MeshFacetBVH (const MeshKernel& mesh)
+  {
+    const MeshPointArray& rPoints = mesh.GetPoints();
+    const MeshFacetArray& rFacets = mesh.GetFacets();
+    unsigned long ctFacets = rFacets.size();
+    _boxes.reserve(ctFacets);
+    _facets.reserve(ctFacets);
+    std::vector<Base::Vector3f> centers;
+    centers.reserve(ctFacets);
+    for (MeshFacetArray::_TConstIterator it = rFacets.begin(); it != rFacets.end(); ++it)
+    {
+      Base::BoundBox3f box;
+      box.Add(rPoints[it->_aulPoints[0]]);
+      box.Add(rPoints[it->_aulPoints[1]]);
+      box.Add(rPoints[it->_aulPoints[2]]);
+      centers.push_back(box.CalcCenter());
+      _facets.push_back(_boxes.size());
+      _boxes.push_back(box);
+    }
+
+    if (ctFacets > 0)
+    {
+      _nodes.reserve(2 * (ctFacets / LeafSize + 1));
+      _nodes.push_back(Node());
+      Build(0, 0, ctFacets, centers);
+    }
+  }
+
+  /** Appends the facets whose bounding boxes overlap with \a box in ascending order */
+  void Search (const Base::BoundBox3f& box, std::vector<unsigned long>& facets) const
+  {
+    facets.clear();
+    if (_nodes.empty())
+      return;
+
+    std::vector<unsigned long> stack;
+    stack.push_back(0);
+    while (!stack.empty())
+    {
+      const Node& node = _nodes[stack.back()];
+      stack.pop_back();
+      if (!Overlap(node.box, box))
+        continue;
+      if (node.count > 0)
+      {
+        for (unsigned long i = node.first; i < node.first + node.count; i++)
+        {
+          if (Overlap(_boxes[_facets[i]], box))
+            facets.push_back(_facets[i]);
+        }
+      }
+      else
+      {
+        stack.push_back(node.first);
+        stack.push_back(node.first + 1);
+      }
+    }
+
+    std::sort(facets.begin(), facets.end());
+  }
+
+  static bool Overlap (const Base::BoundBox3f& box1, const Base::BoundBox3f& box2)
+  {
+    return box1.MinX <= box2.MaxX && box2.MinX <= box1.MaxX &&
+           box1.MinY <= box2.MaxY && box2.MinY <= box1.MaxY &&
+           box1.MinZ <= box2.MaxZ && box2.MinZ <= box1.MaxZ;
+  }
+
+private:
+  enum { LeafSize = 4 };
+
+  // an inner node refers to its two children at first and first+1,
+  // a leaf refers to count facets starting at first
+  struct Node
+  {
+    Base::BoundBox3f box;
+    unsigned long first;
+    unsigned long count;
+  };
+
+  struct CenterLess
+  {
+    const std::vector<Base::Vector3f>& centers;
+    int axis;
+    CenterLess (const std::vector<Base::Vector3f>& c, int a) : centers(c), axis(a) {}
+    bool operator () (unsigned long f1, unsigned long f2) const
+    {
+      return centers[f1][axis] < centers[f2][axis];
+    }
+  };
+
+  void Build (unsigned long index, unsigned long first, unsigned long last, const std::vector<Base::Vector3f>& centers)
+  {
+    Base::BoundBox3f box, centerBox;
+    for (unsigned long i = first; i < last; i++)
+    {
+      box.Add(_boxes[_facets[i]]);
+      centerBox.Add(centers[_facets[i]]);
+    }
+    _nodes[index].box = box;
+
+    if (last - first <= LeafSize)
+    {
+      _nodes[index].first = first;
+      _nodes[index].count = last - first;
+      return;
+    }
+
+    // split at the median of the centers along the longest side
+    int axis = 0;
+    if (centerBox.LengthY() > centerBox.LengthX())
+      axis = 1;
+    if (centerBox.LengthZ() > std::max<float>(centerBox.LengthX(), centerBox.LengthY()))
+      axis = 2;
+    unsigned long mid = first + (last - first) / 2;
+    std::nth_element(_facets.begin() + first, _facets.begin() + mid, _facets.begin() + last,
+                     CenterLess(centers, axis));
+
+    // the children are stored next to each other
+    unsigned long left = _nodes.size();
+    _nodes.push_back(Node());
+    _nodes.push_back(Node());
+    _nodes[index].first = left;
+    _nodes[index].count = 0;
+    Build(left, first, mid, centers);
+    Build(left + 1, mid, last, centers);
+  }
+
+  std::vector<Node> _nodes;
+  std::vector<unsigned long> _facets;
+  std::vector<Base::BoundBox3f> _boxes;
+};
+
+/**
+ * Intersects a range of facets of the first mesh with the facets of the second
+ * mesh. The cut lines are only recorded and applied afterwards in the order of
+ * the ranges so that the result doesn't depend on the number of threads.
+ */
+class MeshFacetCutJob
+{
+public:
+  struct Cut
+  {
+    unsigned long facet0, facet1;
+    MeshPoint point0, point1;
+  };
+
+  MeshFacetCutJob (const MeshKernel& mesh0, const MeshKernel& mesh1, const MeshFacetBVH& bvh,
+                   float minDistanceToPoint, unsigned long first, unsigned long last)
+    : _mesh0(&mesh0), _mesh1(&mesh1), _bvh(&bvh), _minDistanceToPoint(minDistanceToPoint),
+      _first(first), _last(last)
+  {
+  }
+
+  void run ()
+  {
+    float eps = MeshDefinitions::_fMinPointDistance;
+    std::vector<unsigned long> facets2;
+    for (unsigned long fidx1 = _first; fidx1 < _last; fidx1++)
+    {
+      MeshGeomFacet f1 = _mesh0->GetFacet(fidx1);
+      Base::BoundBox3f box = f1.GetBoundBox();
+      box.MinX -= eps; box.MinY -= eps; box.MinZ -= eps;
+      box.MaxX += eps; box.MaxY += eps; box.MaxZ += eps;
+      _bvh->Search(box, facets2);
+
+      for (std::vector<unsigned long>::iterator it2 = facets2.begin(); it2 != facets2.end(); ++it2)
+      {
+        unsigned long fidx2 = *it2;
+        MeshGeomFacet f2 = _mesh1->GetFacet(fidx2);
+
+        MeshPoint p0, p1;
+
+        int isect = f1.IntersectWithFacet(f2, p0, p1);
+        if (isect > 0)
+        {
+          // optimize cut line if distance to nearest point is too small
+          float minDist1 = _minDistanceToPoint, minDist2 = _minDistanceToPoint;
+          MeshPoint np0 = p0, np1 = p1;
+          int i;
+          for (i = 0; i < 3; i++)
+          {
+            float d1 = (f1._aclPoints[i] - p0).Length();
+            float d2 = (f1._aclPoints[i] - p1).Length();
+            if (d1 < minDist1)
+            {
+              minDist1 = d1;
+              np0 = f1._aclPoints[i];
+            }
+            if (d2 < minDist2)
+            {
+              minDist2 = d2;
+              p1 = f1._aclPoints[i];
+            }
+          } // for (int i = 0; i < 3; i++)
+
+          // optimize cut line if distance to nearest point is too small
+          for (i = 0; i < 3; i++)
+          {
+            float d1 = (f2._aclPoints[i] - p0).Length();
+            float d2 = (f2._aclPoints[i] - p1).Length();
+            if (d1 < minDist1)
+            {
+              minDist1 = d1;
+              np0 = f2._aclPoints[i];
+            }
+            if (d2 < minDist2)
+            {
+              minDist2 = d2;
+              np1 = f2._aclPoints[i];
+            }
+          } // for (int i = 0; i < 3; i++)
+
+          Cut cut;
+          cut.facet0 = fidx1;
+          cut.facet1 = fidx2;
+          cut.point0 = np0;
+          cut.point1 = np1;
+          cuts.push_back(cut);
+        } // if (f1.IntersectWithFacet(f2, p0, p1))
+      }
+    }
+  }
+
+  std::vector<Cut> cuts;
+
+private:
+  const MeshKernel* _mesh0;
+  const MeshKernel* _mesh1;
+  const MeshFacetBVH* _bvh;
+  float _minDistanceToPoint;
+  unsigned long _first, _last;
+};
+
+} // namespace MeshCore
 
 SetOperations::SetOperations (const MeshKernel &cutMesh1, const MeshKernel &cutMesh2, MeshKernel &result, OperationType opType, float minDistanceToPoint)
 : _cutMesh0(cutMesh1),
@@ -74,11 +323,12 @@ void SetOperations::Do ()
   // _builder.clear();
 
   //Base::Sequencer().next();
-  std::set<unsigned long> facetsCuttingEdge0, facetsCuttingEdge1;
+  std::vector<bool> facetsCuttingEdge0, facetsCuttingEdge1;
   Cut(facetsCuttingEdge0, facetsCuttingEdge1);
 
   // no intersection curve of the meshes found
-  if (facetsCuttingEdge0.empty() || facetsCuttingEdge1.empty())
+  if (std::find(facetsCuttingEdge0.begin(), facetsCuttingEdge0.end(), true) == facetsCuttingEdge0.end() ||
+      std::find(facetsCuttingEdge1.begin(), facetsCuttingEdge1.end(), true) == facetsCuttingEdge1.end())
   {
     switch (_operationType)
     {
@@ -108,18 +358,8 @@ void SetOperations::Do ()
     return;
   }
 
-  unsigned long i;
-  for (i = 0; i < _cutMesh0.CountFacets(); i++)
-  {
-    if (facetsCuttingEdge0.find(i) == facetsCuttingEdge0.end())
-      _newMeshFacets[0].push_back(_cutMesh0.GetFacet(i));
-  }
-
-  for (i = 0; i < _cutMesh1.CountFacets(); i++)
-  {
-    if (facetsCuttingEdge1.find(i) == facetsCuttingEdge1.end())
-      _newMeshFacets[1].push_back(_cutMesh1.GetFacet(i));
-  }
+  CopyFacets(_cutMesh0, facetsCuttingEdge0, 0);
+  CopyFacets(_cutMesh1, facetsCuttingEdge1, 1);
 
   //Base::Sequencer().next();
   TriangulateMesh(_cutMesh0, 0);
@@ -170,135 +410,87 @@ void SetOperations::Do ()
   MeshDefinitions::SetMinPointDistance(saveMinMeshDistance);
 }
 
-void SetOperations::Cut (std::set<unsigned long>& facetsCuttingEdge0, std::set<unsigned long>& facetsCuttingEdge1)
+void SetOperations::Cut (std::vector<bool>& facetsCuttingEdge0, std::vector<bool>& facetsCuttingEdge1)
 {
-  MeshFacetGrid grid1(_cutMesh0, 20);
-  MeshFacetGrid grid2(_cutMesh1, 20);
+  facetsCuttingEdge0.assign(_cutMesh0.CountFacets(), false);
+  facetsCuttingEdge1.assign(_cutMesh1.CountFacets(), false);
+
+  MeshFacetBVH bvh(_cutMesh1);
+
+  // split the facets of the first mesh into ranges which are intersected concurrently
+  unsigned long ctFacets = _cutMesh0.CountFacets();
+  unsigned long ctRanges = 1;
+  if (ctFacets >= MESH_PARALLEL_ELEMENTS)
+    ctRanges = 4 * std::max<int>(QThread::idealThreadCount(), 1);
+  std::vector<MeshFacetCutJob> jobs;
+  jobs.reserve(ctRanges);
+  for (unsigned long r = 0; r < ctRanges; r++)
+  {
+    jobs.push_back(MeshFacetCutJob(_cutMesh0, _cutMesh1, bvh, _minDistanceToPoint,
+                                   ctFacets * r / ctRanges, ctFacets * (r + 1) / ctRanges));
+  }
 
-  unsigned long ctGx1, ctGy1, ctGz1;
-  grid1.GetCtGrids(ctGx1, ctGy1, ctGz1);
+  if (jobs.size() > 1)
+    QtConcurrent::blockingMap(jobs, boost::bind(&MeshFacetCutJob::run, _1));
+  else
+    jobs.front().run();
 
-  unsigned long gx1;
-  for (gx1 = 0; gx1 < ctGx1; gx1++)  
+  for (std::vector<MeshFacetCutJob>::iterator jt = jobs.begin(); jt != jobs.end(); ++jt)
   {
-    unsigned long gy1;
-    for (gy1 = 0; gy1 < ctGy1; gy1++)
+    for (std::vector<MeshFacetCutJob::Cut>::iterator it = jt->cuts.begin(); it != jt->cuts.end(); ++it)
     {
-      unsigned long gz1;
-      for (gz1 = 0; gz1 < ctGz1; gz1++)
+      unsigned long fidx1 = it->facet0;
+      unsigned long fidx2 = it->facet1;
+      const MeshPoint& mp0 = it->point0;
+      const MeshPoint& mp1 = it->point1;
+
+      if (mp0 != mp1)
+      {
+        facetsCuttingEdge0[fidx1] = true;
+        facetsCuttingEdge1[fidx2] = true;
+
+        std::pair<std::set<MeshPoint>::iterator, bool> pit0 = _cutPoints.insert(mp0);
+        std::pair<std::set<MeshPoint>::iterator, bool> pit1 = _cutPoints.insert(mp1);
+
+        _edges[Edge(mp0, mp1)] = EdgeInfo();
+
+        _facet2points[0][fidx1].push_back(pit0.first);
+        _facet2points[0][fidx1].push_back(pit1.first);
+        _facet2points[1][fidx2].push_back(pit0.first);
+        _facet2points[1][fidx2].push_back(pit1.first);
+      }
+      else
       {
-        if (grid1.GetCtElements(gx1, gy1, gz1) > 0)
+        std::pair<std::set<MeshPoint>::iterator, bool> pit = _cutPoints.insert(mp0);
+
+        // do not insert a facet when only one corner point cuts the edge
+        // if (!((mp0 == f1._aclPoints[0]) || (mp0 == f1._aclPoints[1]) || (mp0 == f1._aclPoints[2])))
         {
-          std::vector<unsigned long> vecFacets2;
-          grid2.Inside(grid1.GetBoundBox(gx1, gy1, gz1), vecFacets2);
-      
-          if (vecFacets2.size() > 0)
-          {
-            std::set<unsigned long> vecFacets1;
-            grid1.GetElements(gx1, gy1, gz1, vecFacets1);
-            
-            std::set<unsigned long>::iterator it1;
-            for (it1 = vecFacets1.begin(); it1 != vecFacets1.end(); it1++)
-            {
-              unsigned long fidx1 = *it1;
-              MeshGeomFacet f1 = _cutMesh0.GetFacet(*it1);
-              
-              std::vector<unsigned long>::iterator it2;
-              for (it2 = vecFacets2.begin(); it2 != vecFacets2.end(); it2++)
-              {
-                unsigned long fidx2 = *it2;
-                MeshGeomFacet f2 = _cutMesh1.GetFacet(fidx2);
-
-                MeshPoint p0, p1;
-
-                int isect = f1.IntersectWithFacet(f2, p0, p1);
-                if (isect > 0)
-                { 
-                   // optimize cut line if distance to nearest point is too small
-                  float minDist1 = _minDistanceToPoint, minDist2 = _minDistanceToPoint;
-                  MeshPoint np0 = p0, np1 = p1;
-                  int i;
-                  for (i = 0; i < 3; i++)
-                  {
-                    float d1 = (f1._aclPoints[i] - p0).Length();
-                    float d2 = (f1._aclPoints[i] - p1).Length();
-                    if (d1 < minDist1)
-                    {
-                      minDist1 = d1;
-                      np0 = f1._aclPoints[i];
-                    }
-                    if (d2 < minDist2)
-                    {
-                      minDist2 = d2;
-                      p1 = f1._aclPoints[i];
-                    }
-                  } // for (int i = 0; i < 3; i++)
-
-                  // optimize cut line if distance to nearest point is too small
-                  for (i = 0; i < 3; i++)
-                  {
-                    float d1 = (f2._aclPoints[i] - p0).Length();
-                    float d2 = (f2._aclPoints[i] - p1).Length();
-                    if (d1 < minDist1)
-                    {
-                      minDist1 = d1;
-                      np0 = f2._aclPoints[i];
-                    }
-                    if (d2 < minDist2)
-                    {
-                      minDist2 = d2;
-                      np1 = f2._aclPoints[i];
-                    }
-                  } // for (int i = 0; i < 3; i++)
-
-                  MeshPoint mp0 = np0;
-                  MeshPoint mp1 = np1;
-
-                  if (mp0 != mp1)
-                  {
-                    facetsCuttingEdge0.insert(fidx1);
-                    facetsCuttingEdge1.insert(fidx2);
-
-                    _cutPoints.insert(mp0);
-                    _cutPoints.insert(mp1);
-
-                    std::pair<std::set<MeshPoint>::iterator, bool> pit0 = _cutPoints.insert(mp0);
-                    std::pair<std::set<MeshPoint>::iterator, bool> pit1 = _cutPoints.insert(mp1);
-
-                    _edges[Edge(mp0, mp1)] = EdgeInfo();
-
-                    _facet2points[0][fidx1].push_back(pit0.first);
-                    _facet2points[0][fidx1].push_back(pit1.first);
-                    _facet2points[1][fidx2].push_back(pit0.first);
-                    _facet2points[1][fidx2].push_back(pit1.first);
-
-                  }
-                  else
-                  {
-                    std::pair<std::set<MeshPoint>::iterator, bool> pit = _cutPoints.insert(mp0);
-
-                    // do not insert a facet when only one corner point cuts the edge
-                    // if (!((mp0 == f1._aclPoints[0]) || (mp0 == f1._aclPoints[1]) || (mp0 == f1._aclPoints[2])))
-                    {
-                      facetsCuttingEdge0.insert(fidx1);
-                      _facet2points[0][fidx1].push_back(pit.first);
-                    }
-
-                    // if (!((mp0 == f2._aclPoints[0]) || (mp0 == f2._aclPoints[1]) || (mp0 == f2._aclPoints[2])))
-                    {
-                      facetsCuttingEdge1.insert(fidx2);
-                      _facet2points[1][fidx2].push_back(pit.first);
-                    }
-                  }
-
-                 } // if (f1.IntersectWithFacet(f2, p0, p1))
-              } // for (it2 = vecFacets2.begin(); it2 != vecFacets2.end(); it2++)
-            } // for (it1 = vecFacets1.begin(); it1 != vecFacets1.end(); it1++)
-          } // if (vecFacets2.size() > 0)
-        } // if (grid1.GetCtElements(gx1, gy1, gz1) > 0)
-      } // for (gz1 = 0; gz1 < ctGz1; gz1++)
-    } // for (gy1 = 0; gy1 < ctGy1; gy1++)
-  } // for (gx1 = 0; gx1 < ctGx1; gx1++)  
+          facetsCuttingEdge0[fidx1] = true;
+          _facet2points[0][fidx1].push_back(pit.first);
+        }
+
+        // if (!((mp0 == f2._aclPoints[0]) || (mp0 == f2._aclPoints[1]) || (mp0 == f2._aclPoints[2])))
+        {
+          facetsCuttingEdge1[fidx2] = true;
+          _facet2points[1][fidx2].push_back(pit.first);
+        }
+      }
+    }
+  }
+}
+
+void SetOperations::CopyFacets (const MeshKernel &cutMesh, const std::vector<bool>& facetsCuttingEdge, int side)
+{
+  const MeshFacetArray& rFacets = cutMesh.GetFacets();
+  std::vector<MeshGeomFacet>& newFacets = _newMeshFacets[side];
+  newFacets.reserve(newFacets.size() + std::count(facetsCuttingEdge.begin(), facetsCuttingEdge.end(), false));
+  std::vector<bool>::const_iterator jt = facetsCuttingEdge.begin();
+  for (MeshFacetArray::_TConstIterator it = rFacets.begin(); it != rFacets.end(); ++it, ++jt)
+  {
+    if (!*jt)
+      newFacets.push_back(cutMesh.GetFacet(*it));
+  }
 }
 
 void SetOperations::TriangulateMesh (const MeshKernel &cutMesh, int side)
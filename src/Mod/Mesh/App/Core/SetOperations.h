@@ -169,8 +169,10 @@ private:
 
   std::vector<MeshGeomFacet> _newMeshFacets[2];
 
-  /** Cut mesh 1 with mesh 2 */
-  void Cut (std::set<unsigned long>& facetsNotCuttingEdge0, std::set<unsigned long>& facetsCuttingEdge1);
+  /** Cut mesh 1 with mesh 2, the cut facets are flagged in the two arrays */
+  void Cut (std::vector<bool>& facetsCuttingEdge0, std::vector<bool>& facetsCuttingEdge1);
+  /** Copy all facets of the mesh which are not cut */
+  void CopyFacets (const MeshKernel &cutMesh, const std::vector<bool>& facetsCuttingEdge, int side);
   /** Trianglute each facets cutted with his cutting points */
   void TriangulateMesh (const MeshKernel &cutMesh, int side);
   /** search facets for adding (with region growing) */
@@ -74,11 +74,11 @@ void PlaneFitSmoothing::Smooth(unsigned int iterations)
             MeshCore::PlaneFit pf;
             pf.AddPoint(*v_it);
             center = *v_it;
-            const std::set<unsigned long>& cv = vv_it[v_it.Position()];
+            MeshCore::MeshIndexRange cv = vv_it[v_it.Position()];
             if (cv.size() < 3)
                 continue;
 
-            std::set<unsigned long>::const_iterator cv_it;
+            MeshCore::MeshIndexRange::const_iterator cv_it;
             for (cv_it = cv.begin(); cv_it !=cv.end(); ++cv_it) {
                 pf.AddPoint(v_beg[*cv_it]);
                 center += v_beg[*cv_it];
@@ -128,11 +128,11 @@ void PlaneFitSmoothing::SmoothPoints(unsigned int iterations, const std::vector<
             MeshCore::PlaneFit pf;
             pf.AddPoint(*v_it);
             center = *v_it;
-            const std::set<unsigned long>& cv = vv_it[v_it.Position()];
+            MeshCore::MeshIndexRange cv = vv_it[v_it.Position()];
             if (cv.size() < 3)
                 continue;
 
-            std::set<unsigned long>::const_iterator cv_it;
+            MeshCore::MeshIndexRange::const_iterator cv_it;
             for (cv_it = cv.begin(); cv_it !=cv.end(); ++cv_it) {
                 pf.AddPoint(v_beg[*cv_it]);
                 center += v_beg[*cv_it];
@@ -184,7 +184,7 @@ void LaplaceSmoothing::Umbrella(const MeshRefPointToPoints& vv_it,
 
     unsigned long pos = 0;
     for (v_it = points.begin(); v_it != v_end; ++v_it,++pos) {
-        const std::set<unsigned long>& cv = vv_it[pos];
+        MeshCore::MeshIndexRange cv = vv_it[pos];
         if (cv.size() < 3)
             continue;
         if (cv.size() != vf_it[pos].size()) {
@@ -197,7 +197,7 @@ void LaplaceSmoothing::Umbrella(const MeshRefPointToPoints& vv_it,
         w=1.0/double(n_count);
 
         double delx=0.0,dely=0.0,delz=0.0;
-        std::set<unsigned long>::const_iterator cv_it;
+        MeshCore::MeshIndexRange::const_iterator cv_it;
         for (cv_it = cv.begin(); cv_it !=cv.end(); ++cv_it) {
             delx += w*((v_beg[*cv_it]).x-v_it->x);
             dely += w*((v_beg[*cv_it]).y-v_it->y);
@@ -219,7 +219,7 @@ void LaplaceSmoothing::Umbrella(const MeshRefPointToPoints& vv_it,
     MeshCore::MeshPointArray::_TConstIterator v_beg = points.begin();
 
     for (std::vector<unsigned long>::const_iterator pos = point_indices.begin(); pos != point_indices.end(); ++pos) {
-        const std::set<unsigned long>& cv = vv_it[*pos];
+        MeshCore::MeshIndexRange cv = vv_it[*pos];
         if (cv.size() < 3)
             continue;
         if (cv.size() != vf_it[*pos].size()) {
@@ -232,7 +232,7 @@ void LaplaceSmoothing::Umbrella(const MeshRefPointToPoints& vv_it,
         w=1.0/double(n_count);
 
         double delx=0.0,dely=0.0,delz=0.0;
-        std::set<unsigned long>::const_iterator cv_it;
+        MeshCore::MeshIndexRange::const_iterator cv_it;
         for (cv_it = cv.begin(); cv_it !=cv.end(); ++cv_it) {
             delx += w*((v_beg[*cv_it]).x-(v_beg[*pos]).x);
             dely += w*((v_beg[*cv_it]).y-(v_beg[*pos]).y);
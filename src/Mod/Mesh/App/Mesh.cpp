@@ -44,6 +44,7 @@
 #include "Core/Info.h"
 #include "Core/TopoAlgorithm.h"
 #include "Core/Evaluation.h"
+#include "Core/Decimation.h"
 #include "Core/Degeneration.h"
 #include "Core/Segmentation.h"
 #include "Core/SetOperations.h"
@@ -809,6 +810,18 @@ void MeshObject::smooth(int iterations, float d_max)
     _kernel.Smooth(iterations, d_max);
 }
 
+void MeshObject::decimate(unsigned long targetSize, float tolerance, bool preserveBorder, bool parallel)
+{
+    MeshCore::MeshDecimation dm(_kernel);
+    dm.SetTolerance(tolerance);
+    dm.SetPreserveBorder(preserveBorder);
+    dm.SetParallel(parallel);
+    dm.Simplify(targetSize);
+
+    // clear the segments because the facet indices have changed
+    this->_segments.clear();
+}
+
 Base::Vector3d MeshObject::getPointNormal(unsigned long index) const
 {
     std::vector<Base::Vector3f> temp = _kernel.CalcVertexNormals();
@@ -826,8 +839,25 @@ Base::Vector3d MeshObject::getPointNormal(unsigned long index) const
 void MeshObject::crossSections(const std::vector<MeshObject::TPlane>& planes, std::vector<MeshObject::TPolylines> &sections,
                                float fMinEps, bool bConnectPolygons) const
 {
-    MeshCore::MeshFacetGrid grid(_kernel);
     MeshCore::MeshAlgorithm algo(_kernel);
+    // a stack of parallel planes is cut in one sweep
+    std::vector<MeshObject::TPolylines> polylines;
+    if (algo.CutWithPlanes(planes, polylines, fMinEps, bConnectPolygons)) {
+        // move the polylines instead of copying them
+        if (sections.empty()) {
+            sections.swap(polylines);
+        }
+        else {
+            sections.reserve(sections.size() + polylines.size());
+            for (std::vector<MeshObject::TPolylines>::iterator it = polylines.begin(); it != polylines.end(); ++it) {
+                sections.push_back(MeshObject::TPolylines());
+                sections.back().swap(*it);
+            }
+        }
+        return;
+    }
+
+    MeshCore::MeshFacetGrid grid(_kernel);
     for (std::vector<MeshObject::TPlane>::const_iterator it = planes.begin(); it != planes.end(); ++it) {
         MeshObject::TPolylines polylines;
         algo.CutWithPlane(it->first, it->second, grid, polylines, fMinEps, bConnectPolygons);
@@ -23,6 +23,7 @@
 
 #include "PreCompiled.h"
 #ifndef _PreComp_
+# include <algorithm>
 #endif
 
 #include <CXX/Objects.hxx>
@@ -445,26 +446,58 @@ PropertyMeshKernel::~PropertyMeshKernel()
     }
 }
 
+void PropertyMeshKernel::bindMesh(MeshObject* mesh)
+{
+    // the Python wrapper must refer to the current mesh object
+    if (meshPyObject) {
+        mesh->ref();
+        meshPyObject->getMeshObjectPtr()->unref();
+        meshPyObject->_pcTwinPointer = mesh;
+    }
+    _meshObject = mesh;
+}
+
+void PropertyMeshKernel::detachMesh(bool copyData)
+{
+    // the Python wrapper holds a reference, too
+    int owners = meshPyObject ? 2 : 1;
+    if (_meshObject.getRefCount() <= owners)
+        return;
+
+    // the mesh object is shared with a copy of this property
+    MeshObject* mesh = new MeshObject();
+    if (copyData)
+        *mesh = *_meshObject;
+    else
+        mesh->setTransform(_meshObject->getTransform());
+    bindMesh(mesh);
+}
+
 void PropertyMeshKernel::setValuePtr(MeshObject* mesh)
 {
     // use the tmp. object to guarantee that the referenced mesh is not destroyed
     // before calling hasSetValue()
     Base::Reference<MeshObject> tmp(_meshObject);
     aboutToSetValue();
-    _meshObject = mesh;
+    bindMesh(mesh);
     hasSetValue();
 }
 
 void PropertyMeshKernel::setValue(const MeshObject& mesh)
 {
+    // keep the passed mesh alive if it's the shared object
+    Base::Reference<MeshObject> tmp(_meshObject);
     aboutToSetValue();
+    detachMesh(false);
     *_meshObject = mesh;
     hasSetValue();
 }
 
 void PropertyMeshKernel::setValue(const MeshCore::MeshKernel& mesh)
 {
+    Base::Reference<MeshObject> tmp(_meshObject);
     aboutToSetValue();
+    detachMesh(false);
     _meshObject->setKernel(mesh);
     hasSetValue();
 }
@@ -472,6 +505,7 @@ void PropertyMeshKernel::setValue(const MeshCore::MeshKernel& mesh)
 void PropertyMeshKernel::swapMesh(MeshObject& mesh)
 {
     aboutToSetValue();
+    detachMesh(true);
     _meshObject->swap(mesh);
     hasSetValue();
 }
@@ -479,6 +513,7 @@ void PropertyMeshKernel::swapMesh(MeshObject& mesh)
 void PropertyMeshKernel::swapMesh(MeshCore::MeshKernel& mesh)
 {
     aboutToSetValue();
+    detachMesh(true);
     _meshObject->swap(mesh);
     hasSetValue();
 }
@@ -512,8 +547,11 @@ void PropertyMeshKernel::getFaces(std::vector<Base::Vector3d> &aPoints,
 
 unsigned int PropertyMeshKernel::getMemSize (void) const
 {
+    // a mesh shared with copies of this property is counted in proportion,
+    // the reference of the Python wrapper doesn't count
+    int owners = _meshObject.getRefCount() - (meshPyObject ? 1 : 0);
     unsigned int size = 0;
-    size += _meshObject->getMemSize();
+    size += _meshObject->getMemSize() / std::max<int>(owners, 1);
     
     return size;
 }
@@ -521,6 +559,7 @@ unsigned int PropertyMeshKernel::getMemSize (void) const
 MeshObject* PropertyMeshKernel::startEditing()
 {
     aboutToSetValue();
+    detachMesh(true);
     return (MeshObject*)_meshObject;
 }
 
@@ -532,13 +571,21 @@ void PropertyMeshKernel::finishEditing()
 void PropertyMeshKernel::transformGeometry(const Base::Matrix4D &rclMat)
 {
     aboutToSetValue();
+    detachMesh(true);
     _meshObject->transformGeometry(rclMat);
     hasSetValue();
 }
 
+void PropertyMeshKernel::setTransform(const Base::Matrix4D& rclTrf)
+{
+    detachMesh(true);
+    _meshObject->setTransform(rclTrf);
+}
+
 void PropertyMeshKernel::setPointIndices(const std::vector<std::pair<unsigned long, Base::Vector3f> >& inds)
 {
     aboutToSetValue();
+    detachMesh(true);
     MeshCore::MeshKernel& kernel = _meshObject->getKernel();
     for (std::vector<std::pair<unsigned long, Base::Vector3f> >::const_iterator it = inds.begin(); it != inds.end(); ++it)
         kernel.SetPoint(it->first, it->second);
@@ -610,6 +657,7 @@ void PropertyMeshKernel::Restore(Base::XMLReader &reader)
         kernel.Adopt(points, facets);
 
         aboutToSetValue();
+        detachMesh(false);
         _meshObject->getKernel().Adopt(points, facets);
         hasSetValue();
     } 
@@ -627,23 +675,26 @@ void PropertyMeshKernel::SaveDocFile (Base::Writer &writer) const
 void PropertyMeshKernel::RestoreDocFile(Base::Reader &reader)
 {
     aboutToSetValue();
+    detachMesh(false);
     _meshObject->load(reader);
     hasSetValue();
 }
 
 App::Property *PropertyMeshKernel::Copy(void) const
 {
-    // Note: Copy the content, do NOT reference the same mesh object
+    // Note: The copy references the same mesh object which is duplicated
+    // when one of both properties gets modified
     PropertyMeshKernel *prop = new PropertyMeshKernel();
-    *(prop->_meshObject) = *(this->_meshObject);
+    prop->_meshObject = this->_meshObject;
     return prop;
 }
 
 void PropertyMeshKernel::Paste(const App::Property &from)
 {
-    // Note: Copy the content, do NOT reference the same mesh object
-    aboutToSetValue();
+    // Note: Reference the same mesh object, see Copy()
     const PropertyMeshKernel& prop = dynamic_cast<const PropertyMeshKernel&>(from);
-    *(this->_meshObject) = *(prop._meshObject);
+    Base::Reference<MeshObject> tmp(_meshObject);
+    aboutToSetValue();
+    bindMesh(prop._meshObject);
     hasSetValue();
 }
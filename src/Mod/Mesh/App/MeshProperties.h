@@ -159,6 +159,9 @@ private:
 };
 
 /** The mesh kernel property class.
+ * The copies of the property that are made for the Undo/Redo share the mesh
+ * object with the property. The mesh object is only duplicated when the property
+ * is modified while it is still referenced by a copy (copy-on-write).
  * @author Werner Mayer
  */
 class MeshExport PropertyMeshKernel : public App::PropertyComplexGeoData
@@ -231,6 +234,11 @@ public:
     void setPyObject(PyObject *value);
     //@}
 
+    /** Sets the transformation of the mesh without notification. This is used
+     * by the owning feature to keep the placement and the mesh in sync.
+     */
+    void setTransform(const Base::Matrix4D& rclTrf);
+
     const char* getEditorName(void) const { return "MeshGui::PropertyMeshKernelItem"; }
 
     /** @name Save/restore */
@@ -240,11 +248,21 @@ public:
 
     void SaveDocFile (Base::Writer &writer) const;
     void RestoreDocFile(Base::Reader &reader);
+    bool canSaveDocFileConcurrently() const {
+        return true;
+    }
+    bool canRestoreDocFileConcurrently() const {
+        return true;
+    }
 
     App::Property *Copy(void) const;
     void Paste(const App::Property &from);
     //@}
 
+private:
+    void bindMesh(MeshObject*);
+    void detachMesh(bool copyData);
+
 private:
     Base::Reference<MeshObject> _meshObject;
     MeshPy* meshPyObject;
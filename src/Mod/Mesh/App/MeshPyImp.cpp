@@ -386,8 +386,22 @@ PyObject*  MeshPy::outer(PyObject *args)
 
 PyObject*  MeshPy::coarsen(PyObject *args)
 {
-    PyErr_SetString(PyExc_NotImplementedError, "Not yet implemented");
-    return 0;
+    unsigned long size;
+    float tolerance=0.0f;
+    PyObject* border=Py_True;
+    PyObject* parallel=Py_False;
+    if (!PyArg_ParseTuple(args, "k|fO!O!", &size, &tolerance, &PyBool_Type, &border,
+                                                              &PyBool_Type, &parallel))
+        return NULL;
+
+    PY_TRY {
+        MeshPropertyLock lock(this->parentProperty);
+        getMeshObjectPtr()->decimate(size, tolerance,
+            PyObject_IsTrue(border) ? true : false,
+            PyObject_IsTrue(parallel) ? true : false);
+    } PY_CATCH;
+
+    Py_Return;
 }
 
 PyObject*  MeshPy::translate(PyObject *args)
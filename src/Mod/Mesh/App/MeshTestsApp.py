@@ -1,7 +1,7 @@
 #   (c) Juergen Riegel (juergen.riegel@web.de) 2007      LGPL
 
 import FreeCAD, os, sys, unittest, Mesh
-import thread, time, tempfile
+import thread, time, tempfile, math
 
 
 #---------------------------------------------------------------------------
@@ -163,3 +163,148 @@ class LoadMeshInThreadsCases(unittest.TestCase):
 
     def tearDown(self):
         pass
+
+
+class MeshUndoTestCases(unittest.TestCase):
+    def setUp(self):
+        self.doc = FreeCAD.newDocument("MeshUndoTest")
+        self.doc.UndoMode = 1
+        self.feature = self.doc.addObject("Mesh::Feature","Mesh")
+
+    def testUndoRedo(self):
+        box = Mesh.createBox(1.0,1.0,1.0)
+        sphere = Mesh.createSphere(1.0,20)
+        self.doc.openTransaction("Box")
+        self.feature.Mesh = box
+        self.doc.commitTransaction()
+        mesh = self.feature.Mesh
+        self.doc.openTransaction("Sphere")
+        self.feature.Mesh = sphere
+        self.doc.commitTransaction()
+        # the Python object always refers to the current mesh of the feature
+        self.assertEqual(mesh.CountFacets, sphere.CountFacets)
+        self.doc.undo()
+        self.assertEqual(self.feature.Mesh.CountFacets, box.CountFacets)
+        self.assertEqual(mesh.CountFacets, box.CountFacets)
+        self.doc.redo()
+        self.assertEqual(self.feature.Mesh.CountFacets, sphere.CountFacets)
+        self.doc.undo()
+        self.doc.undo()
+        self.assertEqual(self.feature.Mesh.CountFacets, 0)
+
+    def tearDown(self):
+        FreeCAD.closeDocument("MeshUndoTest")
+
+
+class MeshDecimationTestCases(unittest.TestCase):
+    def setUp(self):
+        # set up a planar face with 18 triangles
+        self.planarMesh = []
+        for x in range(3):
+            for y in range(3):
+                self.planarMesh.append( [0.0 + x, 0.0 + y,0.0000] )
+                self.planarMesh.append( [1.0 + x, 1.0 + y,0.0000] )
+                self.planarMesh.append( [0.0 + x, 1.0 + y,0.0000] )
+                self.planarMesh.append( [0.0 + x, 0.0 + y,0.0000] )
+                self.planarMesh.append( [1.0 + x, 0.0 + y,0.0000] )
+                self.planarMesh.append( [1.0 + x, 1.0 + y,0.0000] )
+
+    def testSphere(self):
+        sphere = Mesh.createSphere(1.0,50)
+        count = sphere.CountFacets
+        sphere.coarsen(count/10)
+        self.assertTrue(0 < sphere.CountFacets <= count/10)
+        self.assertTrue(sphere.isSolid())
+        self.assertFalse(sphere.hasNonManifolds())
+
+    def testPlanarBorder(self):
+        planarMeshObject = Mesh.Mesh(self.planarMesh)
+        planarMeshObject.coarsen(2, 0.0, True)
+        # only the four inner points can be removed
+        self.assertEqual(planarMeshObject.CountFacets, 10)
+        self.assertAlmostEqual(planarMeshObject.Area, 9.0, 4)
+        planarMeshObject.coarsen(2, 0.0, False)
+        self.assertEqual(planarMeshObject.CountFacets, 2)
+        self.assertAlmostEqual(planarMeshObject.Area, 9.0, 4)
+
+
+class MeshCrossSectionTestCases(unittest.TestCase):
+    def setUp(self):
+        self.sphere = Mesh.createSphere(1.0,50)
+        self.box = Mesh.createBox(1.0,1.0,1.0)
+
+    def sectionPoints(self, section):
+        # compare the sections independent of the order of the polylines
+        points = []
+        for polyline in section:
+            for p in polyline:
+                points.append((round(p.x,4),round(p.y,4),round(p.z,4)))
+        points.sort()
+        return (len(section), points)
+
+    def checkPlanes(self, mesh, planes, other):
+        # a stack of parallel planes is cut in one sweep
+        sections = mesh.crossSections(planes)
+        self.assertEqual(len(sections), len(planes))
+        for i in range(len(planes)):
+            # a non-parallel plane forces the cut plane by plane
+            single = mesh.crossSections([planes[i], (planes[i][0], other)])
+            self.assertEqual(self.sectionPoints(sections[i]), self.sectionPoints(single[0]))
+
+    def testParallelStack(self):
+        n = FreeCAD.Vector(0,0,1)
+        planes = []
+        for i in range(-4,5):
+            planes.append((FreeCAD.Vector(0,0,0.2*i),n))
+        self.checkPlanes(self.sphere, planes, FreeCAD.Vector(1,0,0))
+
+    def testTouchingAndAntiparallel(self):
+        bb = self.box.BoundBox
+        n = FreeCAD.Vector(1,1,1)
+        m = FreeCAD.Vector(-1,-1,-1)
+        c = bb.Center
+        # the first and the last plane only touch a corner of the box
+        planes = [(FreeCAD.Vector(bb.XMin,bb.YMin,bb.ZMin),n),
+                  (FreeCAD.Vector(c.x-0.2,c.y,c.z),m),
+                  (c,n),
+                  (FreeCAD.Vector(c.x,c.y,c.z+0.2),m),
+                  (FreeCAD.Vector(bb.XMax,bb.YMax,bb.ZMax),n)]
+        self.checkPlanes(self.box, planes, FreeCAD.Vector(1,0,0))
+
+
+class MeshSetOperationsTestCases(unittest.TestCase):
+    def setUp(self):
+        # the centers are offset along a skew direction so that no vertices
+        # or edges of the two tessellations coincide
+        self.offset = FreeCAD.Vector(0.5,0.4,0.3)
+
+    def checkResult(self, mesh, volume, tolerance):
+        self.assertTrue(mesh.CountFacets > 0)
+        self.assertTrue(mesh.isSolid())
+        self.assertFalse(mesh.hasNonManifolds())
+        self.assertTrue(abs(mesh.Volume - volume) <= tolerance * volume)
+
+    def checkSpheres(self, sampling, tolerance):
+        sphere1 = Mesh.createSphere(1.0,sampling)
+        sphere2 = sphere1.copy()
+        sphere2.translate(self.offset.x,self.offset.y,self.offset.z)
+
+        # volume of the lens shaped intersection of two unit spheres, scaled to
+        # the volume of the tessellated sphere
+        d = self.offset.Length
+        scale = sphere1.Volume / (4.0 * math.pi / 3.0)
+        sphere = sphere1.Volume
+        lens = math.pi * (4.0 + d) * (2.0 - d) ** 2 / 12.0 * scale
+
+        self.checkResult(sphere1.unite(sphere2), 2.0 * sphere - lens, tolerance)
+        self.checkResult(sphere1.intersect(sphere2), lens, tolerance)
+        self.checkResult(sphere1.difference(sphere2), sphere - lens, tolerance)
+        return sphere1.CountFacets
+
+    def testSpheres(self):
+        self.checkSpheres(30, 0.02)
+
+    def testParallelSpheres(self):
+        # enough facets to intersect the meshes in parallel
+        count = self.checkSpheres(250, 0.005)
+        self.assertTrue(count >= 100000)
@@ -16,6 +16,7 @@
 # include <IGESControl_Controller.hxx>
 # include <STEPControl_Controller.hxx>
 # include <OSD.hxx>
+# include <Standard.hxx>
 # include <sstream>
 #endif
 
@@ -84,6 +85,7 @@
 #include "BRepOffsetAPI_MakePipeShellPy.h"
 #include "PartFeaturePy.h"
 #include "PropertyGeometryList.h"
+#include "ShapeCache.h"
 
 extern struct PyMethodDef Part_methods[];
 
@@ -105,6 +107,10 @@ void PartExport initPart()
     OSD::SetSignal(Standard_False);
 //#endif
 
+    // Shapes are recomputed and saved in worker threads which requires the
+    // thread-safe reference counting of the OCC handles.
+    Standard::SetReentrant(Standard_True);
+
     PyObject* partModule = Py_InitModule3("Part", Part_methods, module_part_doc);   /* mod name, table ptr */
     Base::Console().Log("Loading Part module... done\n");
 
@@ -236,6 +242,9 @@ void PartExport initPart()
     Part::GeomSurfaceOfRevolution ::init();
     Part::GeomSurfaceOfExtrusion  ::init();
 
+    // create the shape cache in the main thread because it observes the user parameters
+    Part::ShapeCache::instance();
+
 
     IGESControl_Controller::Init();
     STEPControl_Controller::Init();
@@ -23,16 +23,20 @@
 
 #include "PreCompiled.h"
 #ifndef _PreComp_
+# include <algorithm>
+# include <string>
 # include <BRepAdaptor_Surface.hxx>
 # include <BRepAlgoAPI_Common.hxx>
 # include <BRepAlgoAPI_Cut.hxx>
 # include <BRepAlgoAPI_Section.hxx>
+# include <BRepBuilderAPI_Copy.hxx>
 # include <BRepBuilderAPI_MakeFace.hxx>
 # include <BRepBuilderAPI_MakeWire.hxx>
 # include <BRepGProp_Face.hxx>
 # include <BRepPrimAPI_MakeHalfSpace.hxx>
 # include <gp_Pln.hxx>
 # include <Precision.hxx>
+# include <Standard_Failure.hxx>
 # include <ShapeFix_Wire.hxx>
 # include <ShapeAnalysis_FreeBounds.hxx>
 # include <TopExp.hxx>
@@ -44,10 +48,57 @@
 # include <TopoDS_Wire.hxx>
 #endif
 
+#include <QThread>
+#include <QtConcurrentMap>
+#include <boost/bind.hpp>
+
 #include "CrossSection.h"
 
 using namespace Part;
 
+// the minimum number of planes per thread to slice in parallel
+#define CROSSSECTION_PARALLEL_PLANES 2
+
+namespace Part {
+// slices every n-th plane starting at the given index
+struct SliceJob
+{
+    SliceJob(double a_, double b_, double c_, const TopoDS_Shape& s_,
+             const std::vector<double>* d_, std::vector< std::list<TopoDS_Wire> >* w_,
+             std::size_t start_, std::size_t step_)
+      : a(a_), b(b_), c(c_), shape(s_), d(d_), wires(w_), start(start_), step(step_)
+    {
+    }
+    void run()
+    {
+        try {
+            // the boolean operations may update the tolerances of the
+            // input shape, so it must not be shared with the other threads
+            BRepBuilderAPI_Copy copy(shape);
+            TopoDS_Shape myShape = copy.Shape();
+            CrossSection cs(a, b, c, myShape);
+            for (std::size_t i = start; i < d->size(); i += step)
+                (*wires)[i] = cs.slice((*d)[i]);
+        }
+        catch (Standard_Failure) {
+            Handle_Standard_Failure e = Standard_Failure::Caught();
+            error = e->GetMessageString();
+            if (error.empty())
+                error = "Slicing the shape failed";
+        }
+        catch (...) {
+            error = "Slicing the shape failed";
+        }
+    }
+
+    double a,b,c;
+    TopoDS_Shape shape;
+    const std::vector<double>* d;
+    std::vector< std::list<TopoDS_Wire> >* wires;
+    std::size_t start, step;
+    std::string error;
+};
+}
 
 CrossSection::CrossSection(double a, double b, double c, const TopoDS_Shape& s)
   : a(a), b(b), c(c), s(s)
@@ -73,6 +124,35 @@ std::list<TopoDS_Wire> CrossSection::slice(double d) const
     return wires;
 }
 
+std::vector< std::list<TopoDS_Wire> > CrossSection::slices(const std::vector<double>& d) const
+{
+    std::vector< std::list<TopoDS_Wire> > wires(d.size());
+    std::size_t numJobs = std::min<std::size_t>(std::max(QThread::idealThreadCount(), 1),
+                                                d.size() / CROSSSECTION_PARALLEL_PLANES);
+    if (numJobs < 2) {
+        for (std::size_t i = 0; i < d.size(); i++)
+            wires[i] = slice(d[i]);
+        return wires;
+    }
+
+    // The planes are distributed round-robin because the sections in the
+    // middle of a part are usually more expensive than at its ends. The OCC
+    // handles are thread-safe as Standard::SetReentrant() is enabled when
+    // loading the Part module.
+    std::vector<SliceJob> jobs;
+    jobs.reserve(numJobs);
+    for (std::size_t i = 0; i < numJobs; i++)
+        jobs.push_back(SliceJob(a, b, c, s, &d, &wires, i, numJobs));
+    QtConcurrent::blockingMap(jobs, boost::bind(&SliceJob::run, _1));
+
+    for (std::vector<SliceJob>::iterator it = jobs.begin(); it != jobs.end(); ++it) {
+        if (!it->error.empty())
+            Standard_Failure::Raise(it->error.c_str());
+    }
+
+    return wires;
+}
+
 void CrossSection::sliceNonSolid(double d, const TopoDS_Shape& shape, std::list<TopoDS_Wire>& wires) const
 {
     BRepAlgoAPI_Section cs(shape, gp_Pln(a,b,c,-d));
@@ -25,6 +25,7 @@
 #define PART_CROSSSECTION_H
 
 #include <list>
+#include <vector>
 
 class TopoDS_Shape;
 class TopoDS_Wire;
@@ -37,6 +38,12 @@ class PartExport CrossSection
 public:
     CrossSection(double a, double b, double c, const TopoDS_Shape& s);
     std::list<TopoDS_Wire> slice(double d) const;
+    /** Slices the shape with the planes at the given distances. The wires of
+     * each plane are returned in the order of the distances. If there are
+     * enough planes they are sliced concurrently whereby each thread works on
+     * its own copy of the shape.
+     */
+    std::vector< std::list<TopoDS_Wire> > slices(const std::vector<double>& d) const;
 
 private:
     void sliceNonSolid(double d, const TopoDS_Shape&, std::list<TopoDS_Wire>& wires) const;
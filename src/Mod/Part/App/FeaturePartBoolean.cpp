@@ -26,8 +26,12 @@
 # include <BRepAlgoAPI_BooleanOperation.hxx>
 # include <BRepCheck_Analyzer.hxx>
 # include <memory>
+# include <Standard.hxx>
 #endif
 
+#include <QMutex>
+#include <QMutexLocker>
+
 #include "FeaturePartBoolean.h"
 #include "modelRefine.h"
 #include <App/Application.h>
@@ -59,6 +63,22 @@ short Boolean::mustExecute() const
     return 0;
 }
 
+bool Boolean::isThreadSafe(void) const
+{
+    return Standard::IsReentrant() ? true : false;
+}
+
+void Boolean::getParameters(bool& checkModel, bool& refineModel)
+{
+    // the parameter groups are not thread-safe
+    static QMutex mutex;
+    QMutexLocker locker(&mutex);
+    Base::Reference<ParameterGrp> hGrp = App::GetApplication().GetUserParameter()
+        .GetGroup("BaseApp")->GetGroup("Preferences")->GetGroup("Mod/Part/Boolean");
+    checkModel = hGrp->GetBool("CheckModel", false);
+    refineModel = hGrp->GetBool("RefineModel", false);
+}
+
 App::DocumentObjectExecReturn *Boolean::execute(void)
 {
     try {
@@ -83,10 +103,10 @@ App::DocumentObjectExecReturn *Boolean::execute(void)
         if (resShape.IsNull()) {
             return new App::DocumentObjectExecReturn("Resulting shape is invalid");
         }
-        Base::Reference<ParameterGrp> hGrp = App::GetApplication().GetUserParameter()
-            .GetGroup("BaseApp")->GetGroup("Preferences")->GetGroup("Mod/Part/Boolean");
+        bool checkModel, refineModel;
+        getParameters(checkModel, refineModel);
 
-        if (hGrp->GetBool("CheckModel", false)) {
+        if (checkModel) {
             BRepCheck_Analyzer aChecker(resShape);
             if (! aChecker.IsValid() ) {
                 return new App::DocumentObjectExecReturn("Resulting shape is invalid");
@@ -97,7 +117,7 @@ App::DocumentObjectExecReturn *Boolean::execute(void)
         history.push_back(buildHistory(*mkBool.get(), TopAbs_FACE, resShape, BaseShape));
         history.push_back(buildHistory(*mkBool.get(), TopAbs_FACE, resShape, ToolShape));
 
-        if (hGrp->GetBool("RefineModel", false)) {
+        if (refineModel) {
             TopoDS_Shape oldShape = resShape;
             BRepBuilderAPI_RefineModel mkRefine(oldShape);
             resShape = mkRefine.Shape();
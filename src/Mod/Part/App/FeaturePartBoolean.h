@@ -48,8 +48,15 @@ public:
     /// recalculate the Feature
     App::DocumentObjectExecReturn *execute(void);
     short mustExecute() const;
+    bool canCacheResult(void) const {
+        return true;
+    }
+    bool isThreadSafe(void) const;
     //@}
 
+    /// reads the user parameters of the boolean operations, can be called from worker threads
+    static void getParameters(bool& checkModel, bool& refineModel);
+
     /// returns the type name of the ViewProvider
     const char* getViewProviderName(void) const {
         return "PartGui::ViewProviderBoolean";
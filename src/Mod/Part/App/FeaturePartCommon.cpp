@@ -27,6 +27,7 @@
 # include <BRepAlgoAPI_Common.hxx>
 # include <BRepCheck_Analyzer.hxx>
 # include <Standard_Failure.hxx>
+# include <Standard.hxx>
 #endif
 
 
@@ -72,6 +73,11 @@ short MultiCommon::mustExecute() const
     return 0;
 }
 
+bool MultiCommon::isThreadSafe(void) const
+{
+    return Standard::IsReentrant() ? true : false;
+}
+
 App::DocumentObjectExecReturn *MultiCommon::execute(void)
 {
     std::vector<TopoDS_Shape> s;
@@ -111,15 +117,15 @@ App::DocumentObjectExecReturn *MultiCommon::execute(void)
             if (resShape.IsNull())
                 throw Base::Exception("Resulting shape is invalid");
 
-            Base::Reference<ParameterGrp> hGrp = App::GetApplication().GetUserParameter()
-                .GetGroup("BaseApp")->GetGroup("Preferences")->GetGroup("Mod/Part/Boolean");
-            if (hGrp->GetBool("CheckModel", false)) {
+            bool checkModel, refineModel;
+            Boolean::getParameters(checkModel, refineModel);
+            if (checkModel) {
                  BRepCheck_Analyzer aChecker(resShape);
                  if (! aChecker.IsValid() ) {
                      return new App::DocumentObjectExecReturn("Resulting shape is invalid");
                  }
             }
-            if (hGrp->GetBool("RefineModel", false)) {
+            if (refineModel) {
                 TopoDS_Shape oldShape = resShape;
                 BRepBuilderAPI_RefineModel mkRefine(oldShape);
                 resShape = mkRefine.Shape();
@@ -26,6 +26,7 @@
 # include <BRepAlgoAPI_Fuse.hxx>
 # include <BRepCheck_Analyzer.hxx>
 # include <Standard_Failure.hxx>
+# include <Standard.hxx>
 #endif
 
 
@@ -71,6 +72,11 @@ short MultiFuse::mustExecute() const
     return 0;
 }
 
+bool MultiFuse::isThreadSafe(void) const
+{
+    return Standard::IsReentrant() ? true : false;
+}
+
 App::DocumentObjectExecReturn *MultiFuse::execute(void)
 {
     std::vector<TopoDS_Shape> s;
@@ -110,15 +116,15 @@ App::DocumentObjectExecReturn *MultiFuse::execute(void)
             if (resShape.IsNull())
                 throw Base::Exception("Resulting shape is invalid");
 
-            Base::Reference<ParameterGrp> hGrp = App::GetApplication().GetUserParameter()
-                .GetGroup("BaseApp")->GetGroup("Preferences")->GetGroup("Mod/Part/Boolean");
-            if (hGrp->GetBool("CheckModel", false)) {
+            bool checkModel, refineModel;
+            Boolean::getParameters(checkModel, refineModel);
+            if (checkModel) {
                 BRepCheck_Analyzer aChecker(resShape);
                 if (! aChecker.IsValid() ) {
                     return new App::DocumentObjectExecReturn("Resulting shape is invalid");
                 }
             }
-            if (hGrp->GetBool("RefineModel", false)) {
+            if (refineModel) {
                 TopoDS_Shape oldShape = resShape;
                 BRepBuilderAPI_RefineModel mkRefine(oldShape);
                 resShape = mkRefine.Shape();
@@ -61,6 +61,7 @@ public:
     /// recalculate the Feature
     App::DocumentObjectExecReturn *execute(void);
     short mustExecute() const;
+    bool isThreadSafe(void) const;
     //@}
     /// returns the type name of the ViewProvider
     const char* getViewProviderName(void) const {
@@ -47,6 +47,9 @@ public:
     /// recalculate the feature
     App::DocumentObjectExecReturn *execute(void);
     short mustExecute() const;
+    bool canCacheResult(void) const {
+        return true;
+    }
     /// returns the type name of the view provider
     const char* getViewProviderName(void) const {
         return "PartGui::ViewProviderRevolution";
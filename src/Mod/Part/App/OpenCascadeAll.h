@@ -25,6 +25,7 @@
 #define __OpenCascadeAll__
 
 // OpenCASCADE
+#include <Standard.hxx>
 #include <Standard_AbortiveTransaction.hxx>
 #include <Standard_Address.hxx>
 #include <Standard_AncestorIterator.hxx>
@@ -159,6 +160,7 @@
 #include <BRepTools.hxx>
 #include <BRep_Tool.hxx>
 #include <BRepTools_ShapeSet.hxx>
+#include <BinTools.hxx>
 #include <BRepBuilderAPI_Copy.hxx>
 #include <BRepCheck_Analyzer.hxx>
 #include <BRepCheck_Result.hxx>
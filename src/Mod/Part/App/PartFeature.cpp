@@ -54,6 +54,7 @@
 
 #include "PartFeature.h"
 #include "PartFeaturePy.h"
+#include "ShapeCache.h"
 
 using namespace Part;
 
@@ -61,7 +62,7 @@ using namespace Part;
 PROPERTY_SOURCE(Part::Feature, App::GeoFeature)
 
 
-Feature::Feature(void) 
+Feature::Feature(void) : recordChanges(false)
 {
     ADD_PROPERTY(Shape, (TopoDS_Shape()));
 }
@@ -77,10 +78,30 @@ short Feature::mustExecute(void) const
 
 App::DocumentObjectExecReturn *Feature::recompute(void)
 {
+    ShapeCache& cache = ShapeCache::instance();
+    ShapeCache::Key key;
+    bool useCache = canCacheResult() && cache.isEnabled() && cache.makeKey(this, key);
+    if (useCache) {
+        // the same input was already computed
+        setStatus(App::Recompute, true);
+        bool hit = cache.restore(key, this);
+        setStatus(App::Recompute, false);
+        if (hit)
+            return App::DocumentObject::StdReturn;
+    }
+
     try {
-        return App::GeoFeature::recompute();
+        changedProperties.clear();
+        recordChanges = useCache;
+        App::DocumentObjectExecReturn* ret = App::GeoFeature::recompute();
+        recordChanges = false;
+        if (useCache && ret == App::DocumentObject::StdReturn)
+            cache.store(key, this, changedProperties);
+        changedProperties.clear();
+        return ret;
     }
     catch (Standard_Failure) {
+        recordChanges = false;
         Handle_Standard_Failure e = Standard_Failure::Caught();
         App::DocumentObjectExecReturn* ret = new App::DocumentObjectExecReturn(e->GetMessageString());
         if (ret->Why.empty()) ret->Why = "Unknown OCC exception";
@@ -115,13 +136,16 @@ std::vector<PyObject *> Feature::getPySubObjects(const std::vector<std::string>&
 
 void Feature::onChanged(const App::Property* prop)
 {
+    if (recordChanges && std::find(changedProperties.begin(), changedProperties.end(), prop) == changedProperties.end())
+        changedProperties.push_back(prop);
     // if the placement has changed apply the change to the point data as well
     if (prop == &this->Placement) {
         TopoShape& shape = const_cast<TopoShape&>(this->Shape.getShape());
         shape.setTransform(this->Placement.getValue().toMatrix());
     }
     // if the point data has changed check and adjust the transformation as well
-    else if (prop == &this->Shape) {
+    // a shape that is not decoded yet was saved together with the placement
+    else if (prop == &this->Shape && this->Shape.isLoaded()) {
         if (this->isRecomputing()) {
             TopoShape& shape = const_cast<TopoShape&>(this->Shape.getShape());
             shape.setTransform(this->Placement.getValue().toMatrix());
@@ -60,6 +60,13 @@ public:
     virtual App::DocumentObjectExecReturn *recompute(void);
     virtual App::DocumentObjectExecReturn *execute(void);
     virtual short mustExecute(void) const;
+    /** Returns true if the result of execute() only depends on the input properties
+     * and the shapes of the linked objects. If the shape cache is enabled such a
+     * feature is not executed again if the same input was already computed.
+     */
+    virtual bool canCacheResult(void) const {
+        return false;
+    }
     //@}
 
     /// returns the type name of the ViewProvider
@@ -87,6 +94,11 @@ protected:
     ShapeHistory buildHistory(BRepBuilderAPI_MakeShape&, TopAbs_ShapeEnum type,
         const TopoDS_Shape& newS, const TopoDS_Shape& oldS);
     ShapeHistory joinHistory(const ShapeHistory&, const ShapeHistory&);
+
+private:
+    // the properties changed by execute() which are stored in the shape cache
+    bool recordChanges;
+    std::vector<const App::Property*> changedProperties;
 };
 
 class FilletBase : public Part::Feature
@@ -100,6 +112,9 @@ public:
     PropertyFilletEdges Edges;
 
     short mustExecute() const;
+    bool canCacheResult(void) const {
+        return true;
+    }
 };
 
 typedef App::FeaturePythonT<Feature> FeaturePython;
@@ -59,6 +59,7 @@
 # include <TopoDS_Solid.hxx>
 # include <TopoDS_Vertex.hxx>
 # include <Standard_Version.hxx>
+# include <Standard.hxx>
 #endif
 
 
@@ -97,6 +98,11 @@ short Primitive::mustExecute(void) const
     return Feature::mustExecute();
 }
 
+bool Primitive::isThreadSafe(void) const
+{
+    return Standard::IsReentrant() ? true : false;
+}
+
 void Primitive::onChanged(const App::Property* prop)
 {
     if (!isRestoring()) {
@@ -43,6 +43,10 @@ public:
     /// recalculate the feature
     App::DocumentObjectExecReturn *execute(void) = 0;
     short mustExecute() const;
+    /** The primitives only work on their own data and can be recomputed concurrently
+     * as long as OCC uses thread-safe reference counting for its handles.
+     */
+    bool isThreadSafe(void) const;
     //@}
 
 protected:
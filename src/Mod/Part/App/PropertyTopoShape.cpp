@@ -24,6 +24,7 @@
 #include "PreCompiled.h"
 
 #ifndef _PreComp_
+# include <iterator>
 # include <sstream>
 # include <BRepAdaptor_Curve.hxx>
 # include <BRepAdaptor_Surface.hxx>
@@ -32,19 +33,24 @@
 # include <Bnd_Box.hxx>
 # include <BRepTools.hxx>
 # include <BRepTools_ShapeSet.hxx>
+# include <BRep_Builder.hxx>
+# include <BRep_Tool.hxx>
+# include <Poly_Triangulation.hxx>
 # include <BRepBuilderAPI_Copy.hxx>
 # include <TopTools_HSequenceOfShape.hxx>
 # include <TopTools_MapOfShape.hxx>
 # include <TopoDS.hxx>
 # include <TopoDS_Iterator.hxx>
 # include <TopExp.hxx>
+# include <TopExp_Explorer.hxx>
+# include <Standard.hxx>
 # include <Standard_Failure.hxx>
 # include <gp_GTrsf.hxx>
 # include <gp_Trsf.hxx>
 #endif
 
+#include <QMutexLocker>
 
-#include <strstream>
 #include <Base/Console.h>
 #include <Base/Writer.h>
 #include <Base/Reader.h>
@@ -68,7 +74,16 @@ using namespace Part;
 
 TYPESYSTEM_SOURCE(Part::PropertyPartShape , App::PropertyComplexGeoData);
 
-PropertyPartShape::PropertyPartShape()
+namespace Part {
+// checks the flag without the mutex, the acquire ordering makes sure that the
+// decoded shape is visible if the flag was reset by another thread
+static inline bool isPending(QAtomicInt& flag)
+{
+    return !flag.testAndSetAcquire(0, 0);
+}
+}
+
+PropertyPartShape::PropertyPartShape() : _pendingBinary(false)
 {
 }
 
@@ -79,6 +94,7 @@ PropertyPartShape::~PropertyPartShape()
 void PropertyPartShape::setValue(const TopoShape& sh)
 {
     aboutToSetValue();
+    clearPending();
     _Shape = sh;
     hasSetValue();
 }
@@ -86,27 +102,92 @@ void PropertyPartShape::setValue(const TopoShape& sh)
 void PropertyPartShape::setValue(const TopoDS_Shape& sh)
 {
     aboutToSetValue();
+    clearPending();
     _Shape._Shape = sh;
     hasSetValue();
 }
 
 const TopoDS_Shape& PropertyPartShape::getValue(void)const 
 {
+    loadPending();
     return _Shape._Shape;
 }
 
 const TopoShape& PropertyPartShape::getShape() const
 {
+    loadPending();
     return this->_Shape;
 }
 
 const Data::ComplexGeoData* PropertyPartShape::getComplexData() const
 {
+    loadPending();
     return &(this->_Shape);
 }
 
+bool PropertyPartShape::isLoaded() const
+{
+    return !isPending(_hasPending);
+}
+
+void PropertyPartShape::clearPending()
+{
+    if (isPending(_hasPending)) {
+        QMutexLocker locker(&_pendingMutex);
+        _pendingData.clear();
+        _hasPending.fetchAndStoreRelease(0);
+    }
+}
+
+void PropertyPartShape::loadPending() const
+{
+    if (!isPending(_hasPending))
+        return;
+    QMutexLocker locker(&_pendingMutex);
+    // another thread was faster
+    if (!_hasPending)
+        return;
+
+    std::istringstream str(_pendingData);
+    TopoDS_Shape shape;
+    try {
+        if (_pendingBinary) {
+            TopoShape binary;
+            binary.importBinary(str);
+            shape = binary._Shape;
+        }
+        else {
+            BRep_Builder builder;
+            BRepTools::Read(shape, str, builder);
+        }
+    }
+    catch (Standard_Failure) {
+        shape.Nullify();
+    }
+    catch (const Base::Exception&) {
+        shape.Nullify();
+    }
+
+    if (shape.IsNull()) {
+        App::PropertyContainer* father = this->getContainer();
+        if (father && father->isDerivedFrom(App::DocumentObject::getClassTypeId())) {
+            App::DocumentObject* obj = static_cast<App::DocumentObject*>(father);
+            Base::Console().Error("BRep data with shape of '%s' seems to be empty\n",
+                obj->Label.getValue());
+        }
+        else {
+            Base::Console().Warning("Loaded BRep data seems to be empty\n");
+        }
+    }
+
+    _Shape._Shape = shape;
+    std::string().swap(_pendingData);
+    _hasPending.fetchAndStoreRelease(0);
+}
+
 Base::BoundBox3d PropertyPartShape::getBoundingBox() const
 {
+    loadPending();
     Base::BoundBox3d box;
     if (_Shape._Shape.IsNull())
         return box;
@@ -135,11 +216,13 @@ void PropertyPartShape::getFaces(std::vector<Base::Vector3d> &aPoints,
                                  std::vector<Data::ComplexGeoData::Facet> &aTopo,
                                  float accuracy, uint16_t flags) const
 {
+    loadPending();
     _Shape.getFaces(aPoints, aTopo, accuracy, flags);
 }
 
 void PropertyPartShape::transformGeometry(const Base::Matrix4D &rclTrf)
 {
+    loadPending();
     aboutToSetValue();
     _Shape.transformGeometry(rclTrf);
     hasSetValue();
@@ -147,6 +230,7 @@ void PropertyPartShape::transformGeometry(const Base::Matrix4D &rclTrf)
 
 PyObject *PropertyPartShape::getPyObject(void)
 {
+    loadPending();
     Base::PyObjectBase* prop;
     const TopoDS_Shape& sh = _Shape._Shape;
     if (sh.IsNull()) {
@@ -206,6 +290,7 @@ void PropertyPartShape::setPyObject(PyObject *value)
 
 App::Property *PropertyPartShape::Copy(void) const
 {
+    loadPending();
     PropertyPartShape *prop = new PropertyPartShape();
     prop->_Shape = this->_Shape;
     if (!_Shape._Shape.IsNull()) {
@@ -218,13 +303,21 @@ App::Property *PropertyPartShape::Copy(void) const
 
 void PropertyPartShape::Paste(const App::Property &from)
 {
+    const PropertyPartShape& shape = dynamic_cast<const PropertyPartShape&>(from);
+    shape.loadPending();
     aboutToSetValue();
-    _Shape = dynamic_cast<const PropertyPartShape&>(from)._Shape;
+    clearPending();
+    _Shape = shape._Shape;
     hasSetValue();
 }
 
 unsigned int PropertyPartShape::getMemSize (void) const
 {
+    if (isPending(_hasPending)) {
+        QMutexLocker locker(&_pendingMutex);
+        if (_hasPending)
+            return _pendingData.size();
+    }
     return _Shape.getMemSize();
 }
 
@@ -232,9 +325,17 @@ void PropertyPartShape::Save (Base::Writer &writer) const
 {
     if(!writer.isForceXML()) {
         //See SaveDocFile(), RestoreDocFile()
-        writer.Stream() << writer.ind() << "<Part file=\"" 
-                        << writer.addFile("PartShape.brp", this)
-                        << "\"/>" << std::endl;
+        // The file extension tells RestoreDocFile() which format is used
+        if (writer.getMode("BinaryBrep")) {
+            writer.Stream() << writer.ind() << "<Part file=\"" 
+                            << writer.addFile("PartShape.bin", this)
+                            << "\"/>" << std::endl;
+        }
+        else {
+            writer.Stream() << writer.ind() << "<Part file=\"" 
+                            << writer.addFile("PartShape.brp", this)
+                            << "\"/>" << std::endl;
+        }
     }
 }
 
@@ -249,103 +350,170 @@ void PropertyPartShape::Restore(Base::XMLReader &reader)
     }
 }
 
+namespace Part {
+// checks whether any face of the shape has a triangulation
+static bool hasTriangulation(const TopoDS_Shape& shape)
+{
+    TopLoc_Location loc;
+    for (TopExp_Explorer xp(shape, TopAbs_FACE); xp.More(); xp.Next()) {
+        if (!BRep_Tool::Triangulation(TopoDS::Face(xp.Current()), loc).IsNull())
+            return true;
+    }
+    return false;
+}
+}
+
 void PropertyPartShape::SaveDocFile (Base::Writer &writer) const
 {
+    // A shape that was never accessed since loading the project can be
+    // written back unchanged if the format is the same
+    if (isPending(_hasPending)) {
+        QMutexLocker locker(&_pendingMutex);
+        if (_hasPending && _pendingBinary == writer.getMode("BinaryBrep")) {
+            writer.Stream().write(_pendingData.c_str(), _pendingData.size());
+            return;
+        }
+    }
+
+    loadPending();
     // If the shape is empty we simply store nothing. The file size will be 0 which
     // can be checked when reading in the data.
     if (_Shape._Shape.IsNull())
         return;
     // NOTE: Cleaning the triangulation may cause problems on some algorithms like BOP
-    // Before writing to the project we clean all triangulation data to save memory
-    BRepBuilderAPI_Copy copy(_Shape._Shape);
-    const TopoDS_Shape& myShape = copy.Shape();
-    BRepTools::Clean(myShape); // remove triangulation
-
-    // create a temporary file and copy the content to the zip stream
-    // once the tmp. filename is known use always the same because otherwise
-    // we may run into some problems on the Linux platform
-    static Base::FileInfo fi(Base::FileInfo::getTempFileName());
-
-    if (!BRepTools::Write(myShape,(const Standard_CString)fi.filePath().c_str())) {
-        // Note: Do NOT throw an exception here because if the tmp. file could
-        // not be created we should not abort.
-        // We only print an error message but continue writing the next files to the
-        // stream...
+    // Before writing to the project we clean all triangulation data to save memory.
+    // The shape only needs to be copied if there is a triangulation at all.
+    TopoDS_Shape myShape = _Shape._Shape;
+    if (hasTriangulation(myShape)) {
+        BRepBuilderAPI_Copy copy(myShape);
+        myShape = copy.Shape();
+        BRepTools::Clean(myShape); // remove triangulation
+    }
+
+    // write the shape directly into the zip stream
+    bool ok = true;
+    try {
+        TopoShape shape(myShape);
+        if (writer.getMode("BinaryBrep"))
+            shape.exportBinary(writer.Stream());
+        else
+            shape.exportBrep(writer.Stream());
+        ok = !writer.Stream().fail();
+    }
+    catch (const Base::Exception&) {
+        ok = false;
+    }
+
+    if (!ok) {
+        // Note: Do NOT throw an exception here because if the shape could
+        // not be written we should not abort.
+        // We only report an error message but continue writing the next files to the
+        // stream. The writer prints it in the main thread because this may run in a
+        // worker thread.
         App::PropertyContainer* father = this->getContainer();
         if (father && father->isDerivedFrom(App::DocumentObject::getClassTypeId())) {
             App::DocumentObject* obj = static_cast<App::DocumentObject*>(father);
-            Base::Console().Error("Shape of '%s' cannot be written to BRep file '%s'\n", 
-                obj->Label.getValue(),fi.filePath().c_str());
+            writer.addError(std::string("Shape of '") + obj->Label.getValue() +
+                            "' cannot be written to BRep file");
         }
         else {
-            Base::Console().Error("Cannot save BRep file '%s'\n", fi.filePath().c_str());
-        }
-    }
-
-    Base::ifstream file(fi, std::ios::in | std::ios::binary);
-    if (file){
-        unsigned long ulSize = 0; 
-        std::streambuf* buf = file.rdbuf();
-        if (buf) {
-            unsigned long ulCurr;
-            ulCurr = buf->pubseekoff(0, std::ios::cur, std::ios::in);
-            ulSize = buf->pubseekoff(0, std::ios::end, std::ios::in);
-            buf->pubseekoff(ulCurr, std::ios::beg, std::ios::in);
+            writer.addError("Cannot save BRep file");
         }
-
-        // read in the ASCII file and write back to the stream
-        std::strstreambuf sbuf(ulSize);
-        file >> &sbuf;
-        writer.Stream() << &sbuf;
     }
-
-    file.close();
-    // remove temp file
-    fi.deleteFile();
 }
 
-void PropertyPartShape::RestoreDocFile(Base::Reader &reader)
+bool PropertyPartShape::canSaveDocFileConcurrently() const
 {
-    BRep_Builder builder;
+    // sub-shapes can be shared by several shapes and their handles are only
+    // counted safely in the reentrant mode
+    return Standard::IsReentrant() ? true : false;
+}
 
-    // create a temporary file and copy the content from the zip stream
-    Base::FileInfo fi(Base::FileInfo::getTempFileName());
+bool PropertyPartShape::canRestoreDocFileConcurrently() const
+{
+    return Standard::IsReentrant() ? true : false;
+}
 
-    // read in the ASCII file and write back to the file stream
-    Base::ofstream file(fi, std::ios::out | std::ios::binary);
-    unsigned long ulSize = 0; 
-    if (reader) {
-        std::streambuf* buf = file.rdbuf();
-        reader >> buf;
-        file.flush();
-        ulSize = buf->pubseekoff(0, std::ios::cur, std::ios::in);
+void PropertyPartShape::applyDocFileBuffer(Base::Persistence* buffer)
+{
+    // take over the shape or the data that is not decoded yet
+    PropertyPartShape* prop = static_cast<PropertyPartShape*>(buffer);
+    aboutToSetValue();
+    {
+        QMutexLocker locker(&_pendingMutex);
+        _Shape._Shape = prop->_Shape._Shape;
+        _pendingData.swap(prop->_pendingData);
+        _pendingBinary = prop->_pendingBinary;
+        _hasPending.fetchAndStoreRelease(prop->_hasPending);
     }
-    file.close();
+    hasSetValue();
+}
 
-    // Read the shape from the temp file, if the file is empty the stored shape was already empty.
+void PropertyPartShape::RestoreDocFile(Base::Reader &reader)
+{
+    // Read the shape from the stream, if the file is empty the stored shape was already empty.
     // If it's still empty after reading the (non-empty) file there must occurred an error.
     TopoDS_Shape shape;
-    if (ulSize > 0) {
-        if (!BRepTools::Read(shape, (const Standard_CString)fi.filePath().c_str(), builder)) {
-            // Note: Do NOT throw an exception here because if the tmp. created file could
-            // not be read it's NOT an indication for an invalid input stream 'reader'.
+    if (reader && reader.peek() != EOF) {
+        // older projects only contain the ASCII format
+        Base::FileInfo fi(reader.getFileName());
+
+        // keep the data and decode it when the shape is accessed the first time
+        if (reader.isLazyLoading()) {
+            std::string data((std::istreambuf_iterator<char>(reader)),
+                              std::istreambuf_iterator<char>());
+            aboutToSetValue();
+            _Shape._Shape.Nullify();
+            {
+                QMutexLocker locker(&_pendingMutex);
+                _pendingData.swap(data);
+                _pendingBinary = fi.hasExtension("bin");
+                _hasPending.fetchAndStoreRelease(1);
+            }
+            hasSetValue();
+            return;
+        }
+
+        try {
+            if (fi.hasExtension("bin")) {
+                TopoShape binary;
+                binary.importBinary(reader);
+                shape = binary._Shape;
+            }
+            else {
+                BRep_Builder builder;
+                BRepTools::Read(shape, reader, builder);
+            }
+        }
+        catch (Standard_Failure) {
+            shape.Nullify();
+        }
+        catch (const Base::Exception&) {
+            shape.Nullify();
+        }
+
+        if (shape.IsNull()) {
+            // Note: Do NOT throw an exception here because if the file could not be
+            // read it's NOT an indication for an invalid input stream 'reader'.
             // We only print an error message but continue reading the next files from the
             // stream...
             App::PropertyContainer* father = this->getContainer();
-            if (father && father->isDerivedFrom(App::DocumentObject::getClassTypeId())) {
+            if (!father) {
+                // a buffer restored in a worker thread, the reader reports the error
+                // in the main thread
+                throw Base::Exception("Loaded BRep data seems to be empty");
+            }
+            else if (father->isDerivedFrom(App::DocumentObject::getClassTypeId())) {
                 App::DocumentObject* obj = static_cast<App::DocumentObject*>(father);
                 Base::Console().Error("BRep file '%s' with shape of '%s' seems to be empty\n", 
-                    fi.filePath().c_str(),obj->Label.getValue());
+                    fi.fileName().c_str(),obj->Label.getValue());
             }
             else {
-                Base::Console().Warning("Loaded BRep file '%s' seems to be empty\n", fi.filePath().c_str());
+                Base::Console().Warning("Loaded BRep file '%s' seems to be empty\n", fi.fileName().c_str());
             }
         }
     }
 
-    // delete the temp file
-    fi.deleteFile();
-
     setValue(shape);
 }
 
@@ -28,6 +28,8 @@
 #include <TopAbs_ShapeEnum.hxx>
 #include <App/DocumentObject.h>
 #include <App/PropertyGeo.h>
+#include <QAtomicInt>
+#include <QMutex>
 #include <map>
 #include <vector>
 
@@ -57,6 +59,8 @@ public:
     const TopoDS_Shape& getValue(void) const;
     const TopoShape& getShape() const;
     const Data::ComplexGeoData* getComplexData() const;
+    /// returns false if the restored shape data is not decoded yet
+    bool isLoaded() const;
     //@}
 
     /** @name Modification */
@@ -88,6 +92,9 @@ public:
 
     void SaveDocFile (Base::Writer &writer) const;
     void RestoreDocFile(Base::Reader &reader);
+    bool canSaveDocFileConcurrently() const;
+    bool canRestoreDocFileConcurrently() const;
+    void applyDocFileBuffer(Base::Persistence* buffer);
 
     App::Property *Copy(void) const;
     void Paste(const App::Property &from);
@@ -95,7 +102,18 @@ public:
     //@}
 
 private:
-    TopoShape _Shape;
+    void loadPending() const;
+    void clearPending();
+
+private:
+    mutable TopoShape _Shape;
+    // If lazy loading is enabled the data file is only decoded when the
+    // shape is accessed the first time
+    mutable std::string _pendingData;
+    mutable bool _pendingBinary;
+    mutable QAtomicInt _hasPending;
+    // guards the decoding of the pending data
+    mutable QMutex _pendingMutex;
 };
 
 struct PartExport ShapeHistory {
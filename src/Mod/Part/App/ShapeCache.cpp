@@ -0,0 +1,267 @@
+/***************************************************************************
+ *   Copyright (c) 2014                                                    *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+#ifndef _PreComp_
+# include <cstring>
+# include <set>
+# include <sstream>
+# include <gp_Trsf.hxx>
+# include <TopLoc_Location.hxx>
+#endif
+
+#include <QMutexLocker>
+
+#include <Base/Writer.h>
+#include <App/Application.h>
+
+#include "ShapeCache.h"
+#include "PartFeature.h"
+
+using namespace Part;
+
+namespace Part {
+// writes the identity of a shape, i.e. its TShape, location and orientation
+static void writeShapeId(std::ostream& str, const TopoDS_Shape& shape)
+{
+    str << (const void*)shape.TShape().operator->() << ' ' << (int)shape.Orientation();
+    gp_Trsf trsf = shape.Location().Transformation();
+    for (int i=1; i<=3; i++) {
+        for (int j=1; j<=4; j++)
+            str << ' ' << trsf.Value(i,j);
+    }
+    str << ';';
+}
+}
+
+ShapeCache& ShapeCache::instance()
+{
+    static ShapeCache cache;
+    return cache;
+}
+
+ShapeCache::ShapeCache() : memsize(0), enabled(false), maxSize(0)
+{
+    hGrp = App::GetApplication().GetParameterGroupByPath
+        ("User parameter:BaseApp/Preferences/Mod/Part/General");
+    hGrp->Attach(this);
+    // the parameters read by the boolean and PartDesign features
+    hBoolean = App::GetApplication().GetParameterGroupByPath
+        ("User parameter:BaseApp/Preferences/Mod/Part/Boolean");
+    hBoolean->Attach(this);
+    hPartDesign = App::GetApplication().GetParameterGroupByPath
+        ("User parameter:BaseApp/Preferences/Mod/PartDesign");
+    hPartDesign->Attach(this);
+    OnChange(*hGrp, "UseShapeCache");
+    OnChange(*hGrp, "ShapeCacheSize");
+    OnChange(*hBoolean, "RefineModel");
+}
+
+ShapeCache::~ShapeCache()
+{
+    hGrp->Detach(this);
+    hBoolean->Detach(this);
+    hPartDesign->Detach(this);
+    clear();
+}
+
+void ShapeCache::OnChange(Base::Subject<const char*> &rCaller, const char * sReason)
+{
+    if (strcmp(sReason, "UseShapeCache") == 0) {
+        bool on = hGrp->GetBool("UseShapeCache", false);
+        QMutexLocker locker(&mutex);
+        enabled = on;
+    }
+    else if (strcmp(sReason, "ShapeCacheSize") == 0) {
+        unsigned long size = (unsigned long)hGrp->GetInt("ShapeCacheSize", 256) * 1024 * 1024;
+        QMutexLocker locker(&mutex);
+        maxSize = size;
+        purge(maxSize);
+    }
+    else if (strcmp(sReason, "RefineModel") == 0 || strcmp(sReason, "CheckModel") == 0) {
+        std::stringstream str;
+        str << "CheckModel=" << hBoolean->GetBool("CheckModel", false)
+            << ";RefineModel=" << hBoolean->GetBool("RefineModel", false)
+            << ";PartDesign/RefineModel=" << hPartDesign->GetBool("RefineModel", false) << ';';
+        QMutexLocker locker(&mutex);
+        params = str.str();
+    }
+}
+
+bool ShapeCache::isEnabled() const
+{
+    QMutexLocker locker(&mutex);
+    return enabled;
+}
+
+bool ShapeCache::makeKey(const Feature* feat, Key& key) const
+{
+    std::stringstream str;
+    str.precision(17);
+    {
+        QMutexLocker locker(&mutex);
+        str << params;
+    }
+    str << feat->getTypeId().getName() << ';';
+
+    // the input properties of the feature
+    std::map<std::string,App::Property*> Map;
+    feat->getPropertyMap(Map);
+    for (std::map<std::string,App::Property*>::iterator it = Map.begin(); it != Map.end(); ++it) {
+        App::Property* prop = it->second;
+        if (prop == &feat->Label)
+            continue;
+        if (feat->getPropertyType(prop) & App::Prop_Output)
+            continue;
+        // own shapes are results of the execution
+        if (prop->getTypeId().isDerivedFrom(PropertyPartShape::getClassTypeId()))
+            continue;
+        Base::StringWriter writer;
+        writer.setForceXML(true);
+        prop->Save(writer);
+        str << it->first << '=' << writer.getString();
+    }
+
+    // the shapes of the objects the feature directly depends on, a change
+    // further upstream always changes one of these shapes
+    std::set<App::DocumentObject*> visited;
+    std::vector<App::DocumentObject*> links = feat->getOutList();
+    for (std::vector<App::DocumentObject*>::iterator it = links.begin(); it != links.end(); ++it) {
+        App::DocumentObject* obj = *it;
+        if (!obj || !visited.insert(obj).second)
+            continue;
+        // the result of other objects cannot be identified
+        if (!obj->getTypeId().isDerivedFrom(Feature::getClassTypeId()))
+            return false;
+        const TopoDS_Shape& shape = static_cast<Feature*>(obj)->Shape.getValue();
+        str << obj->getNameInDocument() << ':';
+        writeShapeId(str, shape);
+        key.shapes.push_back(shape);
+    }
+
+    key.data = str.str();
+    return true;
+}
+
+bool ShapeCache::restore(const Key& key, Feature* feat)
+{
+    // copy the entry and apply it after releasing the lock because setting
+    // the properties notifies observers which may access the cache
+    std::vector<std::pair<std::string, TopoDS_Shape> > shapes;
+    std::vector<std::pair<std::string, App::Property*> > props;
+    {
+        QMutexLocker locker(&mutex);
+        std::map<std::string, EntryList::iterator>::iterator it = index.find(key.data);
+        if (it == index.end())
+            return false;
+
+        // move to the front
+        entries.splice(entries.begin(), entries, it->second);
+        const Entry& entry = entries.front();
+        shapes = entry.shapes;
+        for (std::vector<std::pair<std::string, App::Property*> >::const_iterator jt = entry.props.begin(); jt != entry.props.end(); ++jt)
+            props.push_back(std::make_pair(jt->first, jt->second->Copy()));
+    }
+
+    for (std::vector<std::pair<std::string, App::Property*> >::iterator jt = props.begin(); jt != props.end(); ++jt) {
+        App::Property* prop = feat->getPropertyByName(jt->first.c_str());
+        if (prop)
+            prop->Paste(*jt->second);
+        delete jt->second;
+    }
+    for (std::vector<std::pair<std::string, TopoDS_Shape> >::const_iterator jt = shapes.begin(); jt != shapes.end(); ++jt) {
+        App::Property* prop = feat->getPropertyByName(jt->first.c_str());
+        if (prop && prop->getTypeId().isDerivedFrom(PropertyPartShape::getClassTypeId()))
+            static_cast<PropertyPartShape*>(prop)->setValue(jt->second);
+    }
+
+    return true;
+}
+
+void ShapeCache::store(const Key& key, const Feature* feat, const std::vector<const App::Property*>& props)
+{
+    Entry entry;
+    entry.key = key;
+    // only the results are charged, the input shapes are shared with the document
+    entry.memsize = key.data.size();
+    for (std::vector<const App::Property*>::const_iterator it = props.begin(); it != props.end(); ++it) {
+        const char* name = feat->getName(*it);
+        if (!name) // a temporary property
+            continue;
+        // shapes are immutable and thus can be shared
+        if ((*it)->getTypeId().isDerivedFrom(PropertyPartShape::getClassTypeId())) {
+            const PropertyPartShape* shape = static_cast<const PropertyPartShape*>(*it);
+            entry.shapes.push_back(std::make_pair(std::string(name), shape->getValue()));
+            entry.memsize += shape->getMemSize();
+        }
+        else {
+            App::Property* copy = (*it)->Copy();
+            entry.props.push_back(std::make_pair(std::string(name), copy));
+            entry.memsize += copy->getMemSize();
+        }
+    }
+
+    QMutexLocker locker(&mutex);
+    std::map<std::string, EntryList::iterator>::iterator it = index.find(key.data);
+    if (it != index.end()) {
+        // another thread was faster
+        for (std::vector<std::pair<std::string, App::Property*> >::iterator jt = entry.props.begin(); jt != entry.props.end(); ++jt)
+            delete jt->second;
+        return;
+    }
+
+    entries.push_front(entry);
+    index[key.data] = entries.begin();
+    memsize += entry.memsize;
+    purge(maxSize);
+}
+
+void ShapeCache::purge(unsigned long maxSize)
+{
+    // always keep the most recent entry
+    while (memsize > maxSize && entries.size() > 1)
+        removeLast();
+}
+
+void ShapeCache::removeLast()
+{
+    Entry& entry = entries.back();
+    for (std::vector<std::pair<std::string, App::Property*> >::iterator jt = entry.props.begin(); jt != entry.props.end(); ++jt)
+        delete jt->second;
+    memsize -= entry.memsize;
+    index.erase(entry.key.data);
+    entries.pop_back();
+}
+
+void ShapeCache::clear()
+{
+    QMutexLocker locker(&mutex);
+    while (!entries.empty())
+        removeLast();
+}
+
+unsigned long ShapeCache::getMemSize() const
+{
+    QMutexLocker locker(&mutex);
+    return memsize;
+}
@@ -0,0 +1,111 @@
+/***************************************************************************
+ *   Copyright (c) 2014                                                    *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef PART_SHAPECACHE_H
+#define PART_SHAPECACHE_H
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+#include <QMutex>
+#include <TopoDS_Shape.hxx>
+#include <Base/Parameter.h>
+
+namespace App {
+class Property;
+}
+
+namespace Part {
+
+class Feature;
+
+/** The ShapeCache class keeps the results of recent executions of shape features.
+ * The key of an entry is built from the type and the input properties of a feature,
+ * from the shapes of the objects it directly depends on and from the user parameters
+ * the features read in their execute() method, e.g. 'RefineModel'. Input shapes are
+ * identified by their TShape and location, so a hit of an upstream feature also makes
+ * a hit of the downstream features possible. The input shapes are held by the entry
+ * so that their memory can't be reused by other shapes while the entry exists. Only
+ * the memory of the results is charged to an entry because the input shapes are
+ * shared with the document.
+ *
+ * The cache is disabled by default and is limited by the 'ShapeCacheSize' (in MB)
+ * parameter. If the limit is exceeded the least recently used entries are removed.
+ * The parameters are observed in the main thread because features use the cache
+ * in worker threads during a parallel recompute.
+ */
+class PartExport ShapeCache : public ParameterGrp::ObserverType
+{
+public:
+    struct Key {
+        std::string data;
+        std::vector<TopoDS_Shape> shapes;
+    };
+
+    static ShapeCache& instance();
+
+    /// checks the user parameter whether the cache is enabled
+    bool isEnabled() const;
+    /// creates the key for the feature, returns false if its result cannot be cached
+    bool makeKey(const Feature*, Key&) const;
+    /// restores the result properties of the feature if the key is in the cache
+    bool restore(const Key&, Feature*);
+    /// stores the given properties of the feature as result of the key
+    void store(const Key&, const Feature*, const std::vector<const App::Property*>&);
+    /// removes all entries
+    void clear();
+    /// returns the approximate memory used by all entries
+    unsigned long getMemSize() const;
+    /// reads the parameters again if they have changed
+    void OnChange(Base::Subject<const char*> &rCaller, const char * sReason);
+
+private:
+    ShapeCache();
+    ~ShapeCache();
+    void purge(unsigned long maxSize);
+    void removeLast();
+
+    struct Entry {
+        Key key;
+        std::vector<std::pair<std::string, TopoDS_Shape> > shapes;
+        std::vector<std::pair<std::string, App::Property*> > props;
+        unsigned long memsize;
+    };
+    typedef std::list<Entry> EntryList;
+
+    mutable QMutex mutex;
+    EntryList entries; // most recently used first
+    std::map<std::string, EntryList::iterator> index;
+    unsigned long memsize;
+    ParameterGrp::handle hGrp;
+    ParameterGrp::handle hBoolean;
+    ParameterGrp::handle hPartDesign;
+    bool enabled;
+    unsigned long maxSize;
+    std::string params; // the parameters used by the features
+};
+
+} // namespace Part
+
+#endif // PART_SHAPECACHE_H
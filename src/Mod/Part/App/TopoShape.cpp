@@ -73,6 +73,7 @@
 # include <BRepTools.hxx>
 # include <BRepTools_ReShape.hxx>
 # include <BRepTools_ShapeSet.hxx>
+# include <BinTools.hxx>
 # include <GCE2d_MakeSegment.hxx>
 # include <Geom2d_Line.hxx>
 # include <Geom2d_TrimmedCurve.hxx>
@@ -657,6 +658,22 @@ void TopoShape::importBrep(std::istream& str)
     }
 }
 
+void TopoShape::importBinary(std::istream& str)
+{
+    try {
+        TopoDS_Shape aShape;
+        BinTools::Read(aShape, str);
+        this->_Shape = aShape;
+    }
+    catch (Standard_Failure) {
+        Handle(Standard_Failure) aFail = Standard_Failure::Caught();
+        throw Base::Exception(aFail->GetMessageString());
+    }
+    catch (const std::exception& e) {
+        throw Base::Exception(e.what());
+    }
+}
+
 void TopoShape::write(const char *FileName) const
 {
     Base::FileInfo File(FileName);
@@ -742,6 +759,17 @@ void TopoShape::exportBrep(std::ostream& out)
     BRepTools::Write(this->_Shape, out);
 }
 
+void TopoShape::exportBinary(std::ostream& out)
+{
+    try {
+        BinTools::Write(this->_Shape, out);
+    }
+    catch (Standard_Failure) {
+        Handle(Standard_Failure) aFail = Standard_Failure::Caught();
+        throw Base::Exception(aFail->GetMessageString());
+    }
+}
+
 void TopoShape::exportStl(const char *filename) const
 {
     StlAPI_Writer writer;
@@ -1314,11 +1342,8 @@ std::list<TopoDS_Wire> TopoShape::slice(const Base::Vector3d& dir, double d) con
 
 TopoDS_Compound TopoShape::slices(const Base::Vector3d& dir, const std::vector<double>& d) const
 {
-    std::vector< std::list<TopoDS_Wire> > wire_list;
     CrossSection cs(dir.x, dir.y, dir.z, this->_Shape);
-    for (std::vector<double>::const_iterator jt = d.begin(); jt != d.end(); ++jt) {
-        wire_list.push_back(cs.slice(*jt));
-    }
+    std::vector< std::list<TopoDS_Wire> > wire_list = cs.slices(d);
 
     std::vector< std::list<TopoDS_Wire> >::const_iterator ft;
     TopoDS_Compound comp;
@@ -123,10 +123,12 @@ public:
     void importStep(const char *FileName);
     void importBrep(const char *FileName);
     void importBrep(std::istream&);
+    void importBinary(std::istream&);
     void exportIges(const char *FileName) const;
     void exportStep(const char *FileName) const;
     void exportBrep(const char *FileName) const;
     void exportBrep(std::ostream&);
+    void exportBinary(std::ostream&);
     void exportStl (const char *FileName) const;
     void exportFaceSet(double, double, std::ostream&) const;
     void exportLineSet(std::ostream&) const;
@@ -105,6 +105,7 @@ void PartGuiExport initPartGui()
     PartGui::SoBrepEdgeSet                  ::initClass();
     PartGui::SoBrepPointSet                 ::initClass();
     PartGui::SoFCControlPoints              ::initClass();
+    PartGui::PropertyTessellation           ::init();
     PartGui::ViewProviderPartBase           ::init();
     PartGui::ViewProviderPartExt            ::init();
     PartGui::ViewProviderPart               ::init();
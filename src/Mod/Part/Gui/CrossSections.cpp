@@ -32,10 +32,6 @@
 # include <TopExp_Explorer.hxx>
 # include <gp_Pln.hxx>
 # include <cfloat>
-# include <QFuture>
-# include <QFutureWatcher>
-# include <QtConcurrentMap>
-# include <boost/bind.hpp>
 # include <Inventor/nodes/SoBaseColor.h>
 # include <Inventor/nodes/SoCoordinate3.h>
 # include <Inventor/nodes/SoDrawStyle.h>
@@ -57,7 +53,6 @@
 #include <Base/Sequencer.h>
 
 using namespace PartGui;
-#undef CS_FUTURE // multi-threading causes some problems
 
 namespace PartGui {
 class ViewProviderCrossSections : public Gui::ViewProvider
@@ -199,37 +194,13 @@ void CrossSections::apply()
             break;
     }
 
-#ifdef CS_FUTURE
-    Standard::SetReentrant(Standard_True);
-    for (std::vector<App::DocumentObject*>::iterator it = obj.begin(); it != obj.end(); ++it) {
-        Part::CrossSection cs(a,b,c,static_cast<Part::Feature*>(*it)->Shape.getValue());
-        QFuture< std::list<TopoDS_Wire> > future = QtConcurrent::mapped
-            (d, boost::bind(&Part::CrossSection::section, &cs, _1));
-        future.waitForFinished();
-        QFuture< std::list<TopoDS_Wire> >::const_iterator ft;
-        TopoDS_Compound comp;
-        BRep_Builder builder;
-        builder.MakeCompound(comp);
-
-        for (ft = future.begin(); ft != future.end(); ++ft) {
-            const std::list<TopoDS_Wire>& w = *ft;
-            for (std::list<TopoDS_Wire>::const_iterator wt = w.begin(); wt != w.end(); ++wt) {
-                if (!wt->IsNull())
-                    builder.Add(comp, *wt);
-            }
-        }
+    // all planes of a shape are sliced at once so that it can be done in parallel
+    QStringList planes;
+    for (std::vector<double>::iterator jt = d.begin(); jt != d.end(); ++jt)
+        planes << QString::number(*jt, 'g', 17);
 
-        App::Document* doc = (*it)->getDocument();
-        std::string s = (*it)->getNameInDocument();
-        s += "_cs";
-        Part::Feature* section = static_cast<Part::Feature*>
-            (doc->addObject("Part::Feature",s.c_str()));
-        section->Shape.setValue(comp);
-        section->purgeTouched();
-    }
-#else
     Gui::Application* app = Gui::Application::Instance;
-    Base::SequencerLauncher seq("Cross-sections...", obj.size() * (d.size() +1));
+    Base::SequencerLauncher seq("Cross-sections...", obj.size());
     app->runPythonCode("import Part\n");
     app->runPythonCode("from FreeCAD import Base\n");
     for (std::vector<App::DocumentObject*>::iterator it = obj.begin(); it != obj.end(); ++it) {
@@ -237,31 +208,20 @@ void CrossSections::apply()
         std::string s = (*it)->getNameInDocument();
         s += "_cs";
         app->runPythonCode(QString::fromAscii(
-            "wires=list()\n"
-            "shape=FreeCAD.getDocument(\"%1\").%2.Shape\n")
-            .arg(QLatin1String(doc->getName()))
-            .arg(QLatin1String((*it)->getNameInDocument())).toAscii());
-
-        for (std::vector<double>::iterator jt = d.begin(); jt != d.end(); ++jt) {
-            app->runPythonCode(QString::fromAscii(
-                "for i in shape.slice(Base.Vector(%1,%2,%3),%4):\n"
-                "    wires.append(i)\n"
-                ).arg(a).arg(b).arg(c).arg(*jt).toAscii());
-            seq.next();
-        }
-
-        app->runPythonCode(QString::fromAscii(
-            "comp=Part.Compound(wires)\n"
-            "slice=FreeCAD.getDocument(\"%1\").addObject(\"Part::Feature\",\"%2\")\n"
+            "shape=FreeCAD.getDocument(\"%1\").%2.Shape\n"
+            "comp=shape.slices(Base.Vector(%3,%4,%5),[%6])\n"
+            "slice=FreeCAD.getDocument(\"%1\").addObject(\"Part::Feature\",\"%7\")\n"
             "slice.Shape=comp\n"
             "slice.purgeTouched()\n"
-            "del slice,comp,wires,shape")
+            "del slice,comp,shape")
             .arg(QLatin1String(doc->getName()))
+            .arg(QLatin1String((*it)->getNameInDocument()))
+            .arg(a).arg(b).arg(c)
+            .arg(planes.join(QLatin1String(",")))
             .arg(QLatin1String(s.c_str())).toAscii());
 
         seq.next();
     }
-#endif
 }
 
 void CrossSections::on_xyPlane_clicked()
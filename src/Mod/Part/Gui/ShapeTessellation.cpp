@@ -0,0 +1,701 @@
+/***************************************************************************
+ *   Copyright (c) 2014                                                    *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <algorithm>
+# include <Bnd_Box.hxx>
+# include <BRepAdaptor_Surface.hxx>
+# include <BRepBndLib.hxx>
+# include <BRepBuilderAPI_Copy.hxx>
+# include <BRepMesh_IncrementalMesh.hxx>
+# include <BRep_Tool.hxx>
+# include <BRepTools.hxx>
+# include <Geom_Curve.hxx>
+# include <gp_Trsf.hxx>
+# include <gp_Vec.hxx>
+# include <Poly_Array1OfTriangle.hxx>
+# include <Poly_Polygon3D.hxx>
+# include <Poly_PolygonOnTriangulation.hxx>
+# include <Poly_Triangulation.hxx>
+# include <Standard_Failure.hxx>
+# include <Standard_Version.hxx>
+# include <TColgp_Array1OfPnt.hxx>
+# include <TColStd_Array1OfInteger.hxx>
+# include <TopLoc_Location.hxx>
+# include <TopExp.hxx>
+# include <TopExp_Explorer.hxx>
+# include <TopoDS.hxx>
+# include <TopoDS_Edge.hxx>
+# include <TopoDS_Face.hxx>
+# include <TopoDS_Shape.hxx>
+# include <TopoDS_Vertex.hxx>
+# include <TopTools_IndexedMapOfShape.hxx>
+#endif
+
+#include <QCryptographicHash>
+#include <QThread>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
+#include <boost/bind.hpp>
+
+#include <Base/Exception.h>
+#include <Base/Reader.h>
+#include <Base/Stream.h>
+#include <Base/Writer.h>
+#include <App/Application.h>
+
+#include "ShapeTessellation.h"
+#include "ViewProviderExt.h"
+
+using namespace PartGui;
+
+// the number of triangles from which on the faces are packed in parallel
+#define TESSELLATION_PARALLEL_TRIANGLES 20000
+
+struct ShapeTessellation::FaceData
+{
+    Handle(Poly_Triangulation) mesh;
+    gp_Trsf transf;
+    bool identity;
+    bool reversed;
+    // the polygons of the edges whose points are taken from this face
+    std::vector<Handle(Poly_PolygonOnTriangulation)> edges;
+    // the positions of the face in the arrays
+    int nodeOffset;
+    int triaOffset;
+    int lineOffset;
+};
+
+ShapeTessellation::ShapeTessellation() : vertexOffset(0)
+{
+}
+
+ShapeTessellation::~ShapeTessellation()
+{
+}
+
+void ShapeTessellation::clear()
+{
+    nodes.clear();
+    normals.clear();
+    triangles.clear();
+    parts.clear();
+    lines.clear();
+    vertexOffset = 0;
+}
+
+void ShapeTessellation::swap(ShapeTessellation& tess)
+{
+    nodes.swap(tess.nodes);
+    normals.swap(tess.normals);
+    triangles.swap(tess.triangles);
+    parts.swap(tess.parts);
+    lines.swap(tess.lines);
+    std::swap(vertexOffset, tess.vertexOffset);
+}
+
+unsigned int ShapeTessellation::getMemSize() const
+{
+    return (nodes.size() + normals.size()) * sizeof(SbVec3f) +
+           (triangles.size() + parts.size() + lines.size()) * sizeof(int32_t);
+}
+
+namespace PartGui {
+static void addToHash(QCryptographicHash& hash, double value)
+{
+    hash.addData(reinterpret_cast<const char*>(&value), sizeof(double));
+}
+
+static void addToHash(QCryptographicHash& hash, const gp_Pnt& pnt)
+{
+    addToHash(hash, pnt.X());
+    addToHash(hash, pnt.Y());
+    addToHash(hash, pnt.Z());
+}
+}
+
+std::string ShapeTessellation::shapeHash(const TopoDS_Shape& shape)
+{
+    if (shape.IsNull())
+        return std::string();
+
+    // the display mesh doesn't depend on the placement
+    TopoDS_Shape cShape(shape);
+    TopLoc_Location aLoc;
+    cShape.Location(aLoc);
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    try {
+        // the faces in the order and with the orientation they are tessellated,
+        // the surfaces are sampled at 3x3 points of their parameter range
+        for (TopExp_Explorer Ex(cShape, TopAbs_FACE); Ex.More(); Ex.Next()) {
+            const TopoDS_Face& face = TopoDS::Face(Ex.Current());
+            BRepAdaptor_Surface surface(face);
+            Standard_Real u1, u2, v1, v2;
+            BRepTools::UVBounds(face, u1, u2, v1, v2);
+            addToHash(hash, (double)face.Orientation());
+            addToHash(hash, (double)surface.GetType());
+            for (int i=0; i<3; i++) {
+                for (int j=0; j<3; j++)
+                    addToHash(hash, surface.Value(u1+0.5*i*(u2-u1), v1+0.5*j*(v2-v1)));
+            }
+        }
+
+        // the edges are sampled at 3 points
+        TopTools_IndexedMapOfShape M;
+        TopExp::MapShapes(cShape, TopAbs_EDGE, M);
+        addToHash(hash, (double)M.Extent());
+        for (int i=1; i <= M.Extent(); i++) {
+            TopLoc_Location loc;
+            Standard_Real first, last;
+            Handle(Geom_Curve) curve = BRep_Tool::Curve(TopoDS::Edge(M(i)), loc, first, last);
+            if (curve.IsNull())
+                continue;
+            for (int j=0; j<3; j++) {
+                gp_Pnt pnt = curve->Value(first+0.5*j*(last-first));
+                if (!loc.IsIdentity())
+                    pnt.Transform(loc.Transformation());
+                addToHash(hash, pnt);
+            }
+        }
+
+        TopTools_IndexedMapOfShape V;
+        TopExp::MapShapes(cShape, TopAbs_VERTEX, V);
+        addToHash(hash, (double)V.Extent());
+        for (int i=1; i <= V.Extent(); i++)
+            addToHash(hash, BRep_Tool::Pnt(TopoDS::Vertex(V(i))));
+    }
+    catch (Standard_Failure) {
+        return std::string();
+    }
+
+    return std::string(hash.result().toHex().constData());
+}
+
+void ShapeTessellation::compute(const TopoDS_Shape& shape, double deviation)
+{
+    clear();
+    if (shape.IsNull())
+        return;
+
+    // calculating the deflection value
+    Bnd_Box bounds;
+    BRepBndLib::Add(shape, bounds);
+    bounds.SetGap(0.0);
+    Standard_Real xMin, yMin, zMin, xMax, yMax, zMax;
+    bounds.Get(xMin, yMin, zMin, xMax, yMax, zMax);
+    Standard_Real deflection = ((xMax-xMin)+(yMax-yMin)+(zMax-zMin))/300.0 * deviation;
+
+    // create or use the mesh on the data structure
+#if OCC_VERSION_HEX >= 0x060700
+    BRepMesh_IncrementalMesh myMesh(shape, deflection, Standard_False, 0.5, Standard_True);
+#else
+    BRepMesh_IncrementalMesh myMesh(shape, deflection);
+#endif
+
+    // We must reset the location here because the transformation data
+    // are set in the placement property
+    TopoDS_Shape cShape(shape);
+    TopLoc_Location aLoc;
+    cShape.Location(aLoc);
+
+    // get an indexed map of edges
+    TopTools_IndexedMapOfShape M;
+    TopExp::MapShapes(cShape, TopAbs_EDGE, M);
+
+    // Note: The assumption that if for an edge BRep_Tool::Polygon3D
+    // returns a valid object is wrong. This e.g. happens for ruled
+    // surfaces which gets created by two edges or wires.
+    // So, we have to mark the edges associated to a face.
+    std::vector<bool> faceEdge(M.Extent() + 1, false);
+    std::vector<bool> edgeDone(M.Extent() + 1, false);
+
+    // collect the triangulations and count their nodes, triangles and edge points
+    // to get the position of each face in the arrays
+    std::vector<FaceData> faces;
+    int nbrNodes = 0, nbrTriangles = 0, nbrLines = 0;
+    for (TopExp_Explorer Ex(cShape, TopAbs_FACE); Ex.More(); Ex.Next()) {
+        const TopoDS_Face& actFace = TopoDS::Face(Ex.Current());
+        // Note: we must also count empty faces
+        faces.push_back(FaceData());
+        FaceData& face = faces.back();
+        face.identity = true;
+        face.reversed = (actFace.Orientation() != TopAbs_FORWARD);
+        face.nodeOffset = nbrNodes;
+        face.triaOffset = nbrTriangles;
+        face.lineOffset = nbrLines;
+
+        TopLoc_Location loc;
+        face.mesh = BRep_Tool::Triangulation(actFace, loc);
+        if (!face.mesh.IsNull() && !loc.IsIdentity()) {
+            face.identity = false;
+            face.transf = loc.Transformation();
+        }
+
+        for (TopExp_Explorer xp(actFace, TopAbs_EDGE); xp.More(); xp.Next()) {
+            const TopoDS_Edge& actEdge = TopoDS::Edge(xp.Current());
+            int idx = M.FindIndex(actEdge);
+            faceEdge[idx] = true;
+            // the first face with a polygon of the edge provides its points
+            if (face.mesh.IsNull() || edgeDone[idx])
+                continue;
+            Handle(Poly_PolygonOnTriangulation) aPoly = BRep_Tool::PolygonOnTriangulation(actEdge, face.mesh, loc);
+            if (aPoly.IsNull())
+                continue; // polygon does not exist
+            face.edges.push_back(aPoly);
+            nbrLines += aPoly->NbNodes() + 1;
+            edgeDone[idx] = true;
+        }
+
+        if (!face.mesh.IsNull()) {
+            nbrNodes += face.mesh->NbNodes();
+            nbrTriangles += face.mesh->NbTriangles();
+        }
+    }
+
+    TopTools_IndexedMapOfShape V;
+    TopExp::MapShapes(cShape, TopAbs_VERTEX, V);
+
+    // create memory for the nodes and indexes
+    nodes.reserve(nbrNodes + V.Extent());
+    nodes.resize(nbrNodes);
+    normals.resize(nbrNodes, SbVec3f(0.0f,0.0f,0.0f));
+    triangles.resize(nbrTriangles*4);
+    lines.resize(nbrLines);
+    parts.resize(faces.size());
+    for (std::size_t i=0; i<faces.size(); i++)
+        parts[i] = faces[i].mesh.IsNull() ? 0 : faces[i].mesh->NbTriangles();
+
+    // each face writes into its own range of the arrays
+    if (faces.size() > 1 && nbrTriangles >= TESSELLATION_PARALLEL_TRIANGLES &&
+        QThread::idealThreadCount() > 1) {
+        QtConcurrent::blockingMap(faces, boost::bind(&ShapeTessellation::packFace, this, _1));
+    }
+    else {
+        for (std::vector<FaceData>::iterator it = faces.begin(); it != faces.end(); ++it)
+            packFace(*it);
+    }
+
+    // handling of the free edges
+    for (int i=1; i <= M.Extent(); i++) {
+        if (faceEdge[i])
+            continue;
+        TopLoc_Location loc;
+        Handle(Poly_Polygon3D) aPoly = BRep_Tool::Polygon3D(TopoDS::Edge(M(i)), loc);
+        if (aPoly.IsNull())
+            continue;
+
+        gp_Trsf transf;
+        bool identity = loc.IsIdentity();
+        if (!identity)
+            transf = loc.Transformation();
+
+        const TColgp_Array1OfPnt& aNodes = aPoly->Nodes();
+        int nbNodesInEdge = aPoly->NbNodes();
+        for (Standard_Integer j=1; j <= nbNodesInEdge; j++) {
+            gp_Pnt pnt = aNodes(j);
+            if (!identity)
+                pnt.Transform(transf);
+            lines.push_back((int32_t)nodes.size());
+            nodes.push_back(SbVec3f((float)pnt.X(),(float)pnt.Y(),(float)pnt.Z()));
+        }
+        lines.push_back(-1);
+    }
+
+    // handling of the vertices
+    vertexOffset = (int32_t)nodes.size();
+    for (int i=1; i <= V.Extent(); i++) {
+        gp_Pnt pnt = BRep_Tool::Pnt(TopoDS::Vertex(V(i)));
+        nodes.push_back(SbVec3f((float)pnt.X(),(float)pnt.Y(),(float)pnt.Z()));
+    }
+}
+
+void ShapeTessellation::packFace(const FaceData& face)
+{
+    if (face.mesh.IsNull())
+        return;
+
+    const TColgp_Array1OfPnt& Nodes = face.mesh->Nodes();
+    const Poly_Array1OfTriangle& Triangles = face.mesh->Triangles();
+    int nbNodesInFace = face.mesh->NbNodes();
+    int nbTriInFace = face.mesh->NbTriangles();
+
+    // transform the nodes to the place of the face
+    for (int j=1; j <= nbNodesInFace; j++) {
+        gp_Pnt p(Nodes(j));
+        if (!face.identity)
+            p.Transform(face.transf);
+        nodes[face.nodeOffset+j-1].setValue((float)(p.X()),(float)(p.Y()),(float)(p.Z()));
+    }
+
+    for (int g=1; g <= nbTriInFace; g++) {
+        // Get the triangle
+        Standard_Integer N1,N2,N3;
+        Triangles(g).Get(N1,N2,N3);
+
+        // change orientation of the triangle if the face is reversed
+        if (face.reversed)
+            std::swap(N1,N2);
+
+        // get the 3 points of this triangle
+        gp_Pnt V1(Nodes(N1)), V2(Nodes(N2)), V3(Nodes(N3));
+        if (!face.identity) {
+            V1.Transform(face.transf);
+            V2.Transform(face.transf);
+            V3.Transform(face.transf);
+        }
+
+        // add the triangle normal to the vertex normal for all points of this triangle
+        gp_Vec v1(V1.XYZ()), v2(V2.XYZ()), v3(V3.XYZ());
+        gp_Vec Normal = (v2-v1)^(v3-v1);
+        SbVec3f normal((float)Normal.X(),(float)Normal.Y(),(float)Normal.Z());
+        normals[face.nodeOffset+N1-1] += normal;
+        normals[face.nodeOffset+N2-1] += normal;
+        normals[face.nodeOffset+N3-1] += normal;
+
+        // set the index vector with the 3 point indexes and the end delimiter
+        int32_t* index = &triangles[4*(face.triaOffset+g-1)];
+        index[0] = face.nodeOffset+N1-1;
+        index[1] = face.nodeOffset+N2-1;
+        index[2] = face.nodeOffset+N3-1;
+        index[3] = -1;
+    }
+
+    // normalize all normals of this face
+    for (int j=0; j < nbNodesInFace; j++)
+        normals[face.nodeOffset+j].normalize();
+
+    // the edges lying on this face
+    int l = face.lineOffset;
+    for (std::vector<Handle(Poly_PolygonOnTriangulation)>::const_iterator it = face.edges.begin();
+         it != face.edges.end(); ++it) {
+        const TColStd_Array1OfInteger& indices = (*it)->Nodes();
+        for (Standard_Integer i=indices.Lower(); i <= indices.Upper(); i++)
+            lines[l++] = face.nodeOffset+indices(i)-1;
+        lines[l++] = -1;
+    }
+}
+
+bool ShapeTessellation::tryCompute(const TopoDS_Shape& shape, double deviation)
+{
+    try {
+        compute(shape, deviation);
+        return true;
+    }
+    catch (...) {
+        clear();
+        return false;
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+namespace PartGui {
+// runs in the worker thread
+static bool tessellateCopy(ShapeTessellation* tess, TopoDS_Shape shape, double deviation)
+{
+    try {
+        // the triangulation is stored in the faces, so mesh a copy to not write
+        // to faces that are in use in the GUI thread
+        BRepBuilderAPI_Copy copy(shape);
+        return tess->tryCompute(copy.Shape(), deviation);
+    }
+    catch (...) {
+        tess->clear();
+        return false;
+    }
+}
+}
+
+ShapeTessellationJob::ShapeTessellationJob(ViewProviderPartExt* vp)
+  : viewProvider(vp), deviation(0.0), nextDeviation(0.0), busy(false)
+{
+    connect(&watcher, SIGNAL(finished()), this, SLOT(onFinished()));
+}
+
+ShapeTessellationJob::~ShapeTessellationJob()
+{
+    // the worker thread writes to tess
+    watcher.waitForFinished();
+}
+
+void ShapeTessellationJob::start(const TopoDS_Shape& s, double dev)
+{
+    nextShape = s;
+    nextDeviation = dev;
+    busy = true;
+    if (!watcher.isRunning())
+        launch();
+}
+
+void ShapeTessellationJob::cancel()
+{
+    busy = false;
+    nextShape.Nullify();
+}
+
+bool ShapeTessellationJob::isBusy() const
+{
+    return busy;
+}
+
+void ShapeTessellationJob::launch()
+{
+    shape = nextShape;
+    deviation = nextDeviation;
+    watcher.setFuture(QtConcurrent::run(&tessellateCopy, &tess, shape, deviation));
+}
+
+void ShapeTessellationJob::onFinished()
+{
+    if (!busy) {
+        tess.clear();
+        return;
+    }
+    // drop the outdated result
+    if (!shape.IsEqual(nextShape) || deviation != nextDeviation) {
+        launch();
+        return;
+    }
+
+    busy = false;
+    bool ok = watcher.result();
+    ShapeTessellation result;
+    result.swap(tess);
+    shape.Nullify();
+    nextShape.Nullify();
+    viewProvider->applyTessellation(result, ok);
+}
+
+// ----------------------------------------------------------------------------
+
+TYPESYSTEM_SOURCE(PartGui::PropertyTessellation , App::Property);
+
+PropertyTessellation::PropertyTessellation()
+  : restoredDeviation(0.0f), pending(false)
+{
+}
+
+PropertyTessellation::~PropertyTessellation()
+{
+}
+
+bool PropertyTessellation::isPending() const
+{
+    return pending;
+}
+
+bool PropertyTessellation::hasRestored() const
+{
+    return !restoredHash.empty();
+}
+
+bool PropertyTessellation::takeRestored(const std::string& hash, float deviation,
+                                        ShapeTessellation& tess)
+{
+    bool ok = hasRestored() && restoredHash == hash && restoredDeviation == deviation;
+    if (ok)
+        tess.swap(restored);
+    clearRestored();
+    return ok;
+}
+
+void PropertyTessellation::clearRestored()
+{
+    ShapeTessellation().swap(restored);
+    restoredHash.clear();
+    restoredDeviation = 0.0f;
+    pending = false;
+}
+
+void PropertyTessellation::Save (Base::Writer &writer) const
+{
+    std::string file;
+    if (!writer.isForceXML()) {
+        ParameterGrp::handle hGrp = App::GetApplication().GetParameterGroupByPath
+            ("User parameter:BaseApp/Preferences/Mod/Part");
+        if (hGrp->GetBool("SaveTessellation", false))
+            file = writer.addFile("Tessellation.bin", this);
+    }
+
+    writer.Stream() << writer.ind() << "<Tessellation file=\"" << file << "\"/>" << std::endl;
+}
+
+void PropertyTessellation::Restore(Base::XMLReader &reader)
+{
+    reader.readElement("Tessellation");
+    std::string file (reader.getAttribute("file") );
+
+    clearRestored();
+    if (!file.empty()) {
+        // initate a file read
+        reader.addFile(file.c_str(),this);
+        pending = true;
+    }
+}
+
+void PropertyTessellation::SaveDocFile (Base::Writer &writer) const
+{
+    // If the visual is not up to date we simply store nothing. The file size
+    // will be 0 which can be checked when reading in the data.
+    const ViewProviderPartExt* vp = dynamic_cast<const ViewProviderPartExt*>(getContainer());
+    ShapeTessellation tess;
+    std::string hash;
+    if (!vp || !vp->getTessellation(tess, hash))
+        return;
+
+    Base::OutputStream str(writer.Stream());
+    str << (uint32_t)hash.size();
+    for (std::string::const_iterator it = hash.begin(); it != hash.end(); ++it)
+        str << (int8_t)*it;
+    str << vp->Deviation.getValue();
+
+    str << (uint32_t)tess.nodes.size() << (uint32_t)tess.normals.size()
+        << (uint32_t)tess.triangles.size() << (uint32_t)tess.parts.size()
+        << (uint32_t)tess.lines.size() << tess.vertexOffset;
+    for (std::vector<SbVec3f>::const_iterator it = tess.nodes.begin(); it != tess.nodes.end(); ++it)
+        str << (*it)[0] << (*it)[1] << (*it)[2];
+    for (std::vector<SbVec3f>::const_iterator it = tess.normals.begin(); it != tess.normals.end(); ++it)
+        str << (*it)[0] << (*it)[1] << (*it)[2];
+    for (std::vector<int32_t>::const_iterator it = tess.triangles.begin(); it != tess.triangles.end(); ++it)
+        str << *it;
+    for (std::vector<int32_t>::const_iterator it = tess.parts.begin(); it != tess.parts.end(); ++it)
+        str << *it;
+    for (std::vector<int32_t>::const_iterator it = tess.lines.begin(); it != tess.lines.end(); ++it)
+        str << *it;
+}
+
+namespace PartGui {
+// checks that all indices refer to existing points so that a damaged file
+// cannot crash the rendering
+static bool isValidTessellation(const ShapeTessellation& tess)
+{
+    int32_t numNodes = (int32_t)tess.nodes.size();
+    int32_t numNormals = (int32_t)tess.normals.size();
+    if (numNormals > numNodes || tess.vertexOffset < 0 || tess.vertexOffset > numNodes)
+        return false;
+    if (tess.triangles.size() % 4 != 0)
+        return false;
+
+    std::size_t count = 0;
+    for (std::vector<int32_t>::const_iterator it = tess.parts.begin(); it != tess.parts.end(); ++it) {
+        if (*it < 0)
+            return false;
+        count += *it;
+    }
+    if (4 * count != tess.triangles.size())
+        return false;
+
+    for (std::size_t i=0; i < tess.triangles.size(); i += 4) {
+        for (int j=0; j<3; j++) {
+            if (tess.triangles[i+j] < 0 || tess.triangles[i+j] >= numNormals)
+                return false;
+        }
+        if (tess.triangles[i+3] != -1)
+            return false;
+    }
+    for (std::vector<int32_t>::const_iterator it = tess.lines.begin(); it != tess.lines.end(); ++it) {
+        if (*it < -1 || *it >= numNodes)
+            return false;
+    }
+
+    return true;
+}
+}
+
+void PropertyTessellation::RestoreDocFile(Base::Reader &reader)
+{
+    aboutToSetValue();
+    clearRestored();
+
+    if (reader && reader.peek() != EOF) {
+        ShapeTessellation tess;
+        std::string hash;
+        float deviation = 0.0f;
+        try {
+            Base::InputStream str(reader);
+            uint32_t len = 0;
+            str >> len;
+            for (uint32_t i=0; i<len && reader; i++) {
+                int8_t c;
+                str >> c;
+                hash.push_back((char)c);
+            }
+            str >> deviation;
+
+            uint32_t numNodes = 0, numNormals = 0, numTriangles = 0, numParts = 0, numLines = 0;
+            str >> numNodes >> numNormals >> numTriangles >> numParts >> numLines >> tess.vertexOffset;
+            if (!reader)
+                throw Base::Exception("Invalid tessellation data");
+
+            tess.nodes.resize(numNodes);
+            for (std::vector<SbVec3f>::iterator it = tess.nodes.begin(); it != tess.nodes.end() && reader; ++it)
+                str >> (*it)[0] >> (*it)[1] >> (*it)[2];
+            tess.normals.resize(numNormals);
+            for (std::vector<SbVec3f>::iterator it = tess.normals.begin(); it != tess.normals.end() && reader; ++it)
+                str >> (*it)[0] >> (*it)[1] >> (*it)[2];
+            tess.triangles.resize(numTriangles);
+            for (std::vector<int32_t>::iterator it = tess.triangles.begin(); it != tess.triangles.end() && reader; ++it)
+                str >> *it;
+            tess.parts.resize(numParts);
+            for (std::vector<int32_t>::iterator it = tess.parts.begin(); it != tess.parts.end() && reader; ++it)
+                str >> *it;
+            tess.lines.resize(numLines);
+            for (std::vector<int32_t>::iterator it = tess.lines.begin(); it != tess.lines.end() && reader; ++it)
+                str >> *it;
+            if (!reader)
+                throw Base::Exception("Invalid tessellation data");
+        }
+        catch (...) {
+            hash.clear();
+        }
+
+        // the data is ignored if it's damaged
+        if (!hash.empty() && isValidTessellation(tess)) {
+            restored.swap(tess);
+            restoredHash = hash;
+            restoredDeviation = deviation;
+        }
+    }
+
+    hasSetValue();
+}
+
+App::Property *PropertyTessellation::Copy(void) const
+{
+    // the restored data is only used once and not copied
+    return new PropertyTessellation();
+}
+
+void PropertyTessellation::Paste(const App::Property &from)
+{
+}
+
+unsigned int PropertyTessellation::getMemSize (void) const
+{
+    return restored.getMemSize() + restoredHash.size();
+}
+
+#include "moc_ShapeTessellation.cpp"
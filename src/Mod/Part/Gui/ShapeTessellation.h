@@ -0,0 +1,175 @@
+/***************************************************************************
+ *   Copyright (c) 2014                                                    *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef PARTGUI_SHAPETESSELLATION_H
+#define PARTGUI_SHAPETESSELLATION_H
+
+#include <string>
+#include <vector>
+#include <QObject>
+#include <QFutureWatcher>
+#include <Inventor/SbVec3f.h>
+#include <TopoDS_Shape.hxx>
+#include <App/Property.h>
+
+namespace PartGui {
+
+class ViewProviderPartExt;
+
+/** The ShapeTessellation class holds the display mesh of a shape as it is used
+ * by ViewProviderPartExt. The nodes of the faces come first, followed by the
+ * nodes of the free edges and the vertices of the shape.
+ *
+ * The triangulation of the faces is done by OCC and in parallel if supported.
+ * Afterwards the triangulations are packed face by face into the arrays whereby
+ * the position of each face is determined in advance from the node, triangle
+ * and edge polygon counts of the previous faces. So, the faces can be packed
+ * concurrently. As the class doesn't access any Inventor nodes it can be
+ * computed in a worker thread.
+ */
+class PartGuiExport ShapeTessellation
+{
+public:
+    ShapeTessellation();
+    ~ShapeTessellation();
+
+    /// tessellates the shape with a deflection relative to its bounding box
+    void compute(const TopoDS_Shape&, double deviation);
+    /// like compute() but catches all exceptions, returns false if it failed
+    bool tryCompute(const TopoDS_Shape&, double deviation);
+    void clear();
+    void swap(ShapeTessellation&);
+    unsigned int getMemSize() const;
+
+    /** Returns a hash of the topology and of sample points of the geometry of
+     * the shape. Unlike the hash codes of OCC it doesn't depend on the memory
+     * addresses and can be compared with the hash of a previous session.
+     * An empty string is returned if the hash cannot be computed.
+     */
+    static std::string shapeHash(const TopoDS_Shape&);
+
+    /// the points of the faces, free edges and vertices
+    std::vector<SbVec3f> nodes;
+    /// the normals of the face points
+    std::vector<SbVec3f> normals;
+    /// the triangles, each terminated by -1
+    std::vector<int32_t> triangles;
+    /// the number of triangles of each face
+    std::vector<int32_t> parts;
+    /// the polygons of the edges, each terminated by -1
+    std::vector<int32_t> lines;
+    /// the index of the first vertex in nodes
+    int32_t vertexOffset;
+
+private:
+    struct FaceData;
+    void packFace(const FaceData&);
+};
+
+/** The ShapeTessellationJob class tessellates the shape of a ViewProviderPartExt
+ * in a worker thread while the old display mesh stays on screen. When the job has
+ * finished the view provider takes the new mesh in the GUI thread. If the shape
+ * or the deviation has been changed in the meantime the result is dropped and the
+ * shape is tessellated again with the latest values.
+ */
+class ShapeTessellationJob : public QObject
+{
+    Q_OBJECT
+
+public:
+    ShapeTessellationJob(ViewProviderPartExt*);
+    /// waits for the worker thread
+    ~ShapeTessellationJob();
+
+    /// tessellates the shape, if a job is running it's done afterwards
+    void start(const TopoDS_Shape&, double deviation);
+    /// drops the result of the running job
+    void cancel();
+    /// returns true until the view provider has got the mesh of the last shape
+    bool isBusy() const;
+
+private Q_SLOTS:
+    void onFinished();
+
+private:
+    void launch();
+
+    ViewProviderPartExt* viewProvider;
+    QFutureWatcher<bool> watcher;
+    ShapeTessellation tess;
+    TopoDS_Shape shape, nextShape;
+    double deviation, nextDeviation;
+    bool busy;
+};
+
+/** The PropertyTessellation class stores the display mesh of a ViewProviderPartExt
+ * in the project file if the 'SaveTessellation' parameter is set. Together with
+ * the mesh the hash of the shape and the deviation are stored. On restore the
+ * view provider uses the mesh instead of tessellating the shape again if both
+ * still match.
+ *
+ * To not keep a second copy of the mesh in memory the data is fetched from the
+ * view provider when it's saved, and the restored data is released as soon as
+ * the view provider has taken it or decided to not use it.
+ */
+class PartGuiExport PropertyTessellation : public App::Property
+{
+    TYPESYSTEM_HEADER();
+
+public:
+    PropertyTessellation();
+    ~PropertyTessellation();
+
+    void setValue(void){}
+    /// returns true while the restored data file wasn't read yet
+    bool isPending() const;
+    /// returns true if a restored mesh is available
+    bool hasRestored() const;
+    /// moves the restored mesh to tess if it was made for the hash and deviation
+    bool takeRestored(const std::string& hash, float deviation, ShapeTessellation& tess);
+    /// releases the restored mesh
+    void clearRestored();
+
+    /** @name Save/restore */
+    //@{
+    void Save (Base::Writer &writer) const;
+    void Restore(Base::XMLReader &reader);
+
+    void SaveDocFile (Base::Writer &writer) const;
+    void RestoreDocFile(Base::Reader &reader);
+
+    App::Property *Copy(void) const;
+    void Paste(const App::Property &from);
+    unsigned int getMemSize (void) const;
+    //@}
+
+private:
+    ShapeTessellation restored;
+    std::string restoredHash;
+    float restoredDeviation;
+    bool pending;
+};
+
+} // namespace PartGui
+
+#endif // PARTGUI_SHAPETESSELLATION_H
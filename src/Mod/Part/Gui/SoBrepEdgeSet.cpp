@@ -278,12 +278,15 @@ void SoBrepEdgeSet::doAction(SoAction* action)
             return;
         }
 
-        const SoDetail* detail = selaction->getElement();
-        if (detail) {
+        bool changed = false;
+        const std::vector<const SoDetail*>& details = selaction->getElements();
+        for (std::vector<const SoDetail*>::const_iterator it = details.begin(); it != details.end(); ++it) {
+            const SoDetail* detail = *it;
             if (!detail->isOfType(SoLineDetail::getClassTypeId())) {
-                return;
+                continue;
             }
 
+            changed = true;
             int index = static_cast<const SoLineDetail*>(detail)->getLineIndex();
             switch (selaction->getType()) {
             case Gui::SoSelectionElementAction::Append:
@@ -301,7 +304,10 @@ void SoBrepEdgeSet::doAction(SoAction* action)
             default:
                 break;
             }
+        }
 
+        // rebuild the index array once for all elements
+        if (changed) {
             int numsegm = this->selectionIndex.getNum();
             if (numsegm > 0) {
                 const int32_t* selsegm = this->selectionIndex.getValues(0);
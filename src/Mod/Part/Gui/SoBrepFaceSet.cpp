@@ -123,10 +123,11 @@ void SoBrepFaceSet::doAction(SoAction* action)
             return;
         }
 
-        const SoDetail* detail = selaction->getElement();
-        if (detail) {
+        const std::vector<const SoDetail*>& details = selaction->getElements();
+        for (std::vector<const SoDetail*>::const_iterator it = details.begin(); it != details.end(); ++it) {
+            const SoDetail* detail = *it;
             if (!detail->isOfType(SoFaceDetail::getClassTypeId())) {
-                return;
+                continue;
             }
 
             int index = static_cast<const SoFaceDetail*>(detail)->getPartIndex();
@@ -29,6 +29,7 @@
 #include <TopoDS_Shape.hxx>
 #include <Gui/ViewProviderGeometryObject.h>
 #include <map>
+#include "ShapeTessellation.h"
 
 class TopoDS_Shape;
 class TopoDS_Edge;
@@ -60,6 +61,7 @@ class SoBrepPointSet;
 class PartGuiExport ViewProviderPartExt : public Gui::ViewProviderGeometryObject
 {
     PROPERTY_HEADER(PartGui::ViewProviderPartExt);
+    friend class ShapeTessellationJob;
 
 public:
     /// constructor
@@ -79,7 +81,7 @@ public:
     App::PropertyEnumeration DrawStyle;
 
     App::PropertyColorList DiffuseColor;
-
+    PropertyTessellation Tessellation;
 
     virtual void attach(App::DocumentObject *);
     virtual void setDisplayMode(const char* ModeName);
@@ -87,8 +89,11 @@ public:
     virtual std::vector<std::string> getDisplayModes(void) const;
     /// Update the view representation
     void reload();
+    /// copies the current display mesh, returns false if it's not up to date
+    bool getTessellation(ShapeTessellation&, std::string& hash) const;
 
     virtual void updateData(const App::Property*);
+    virtual void finishRestoring();
 
       /** @name Selection handling
       * This group of methodes do the selection handling.
@@ -119,6 +124,7 @@ protected:
     virtual void onChanged(const App::Property* prop);
     bool loadParameter();
     void updateVisual(const TopoDS_Shape &);
+    void applyTessellation(const ShapeTessellation&, bool ok);
 
     // nodes for the data representation
     SoMaterialBinding * pcShapeBind;
@@ -136,6 +142,7 @@ protected:
     SoBrepPointSet    * nodeset;
 
     bool VisualTouched;
+    ShapeTessellationJob* tessJob;
 
 private:
     // settings stuff
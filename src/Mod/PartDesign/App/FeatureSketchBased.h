@@ -52,6 +52,10 @@ public:
     App::PropertyBool       Midplane;
 
     short mustExecute() const;
+    /// the result only depends on the sketch and its support
+    bool canCacheResult(void) const {
+        return true;
+    }
 
     /** calculates and updates the Placement property based on the Sketch
      *  or its support if it has one
@@ -36,12 +36,23 @@
 #include "Points.h"
 #include "PointsAlgos.h"
 #include "PointsPy.h"
+#include "PointsTree.h"
 
 using namespace Points;
 using namespace std;
 
 TYPESYSTEM_SOURCE(Points::PointKernel, Data::ComplexGeoData);
 
+PointKernel::PointKernel(const PointKernel& Kernel)
+  : _Mtrx(Kernel._Mtrx), _Points(Kernel._Points), _pTree(0)
+{
+}
+
+PointKernel::~PointKernel()
+{
+    delete _pTree;
+}
+
 std::vector<const char*> PointKernel::getElementTypes(void) const
 {
     std::vector<const char*> temp;
@@ -136,6 +147,7 @@ void PointKernel::Restore(Base::XMLReader &reader)
 
 void PointKernel::RestoreDocFile(Base::Reader &reader)
 {
+    clearTree();
     Base::InputStream str(reader);
     uint32_t uCt = 0;
     str >> uCt;
@@ -163,6 +175,19 @@ void PointKernel::save(std::ostream& out) const
     //kernel.Write(out);
 }
 
+const PointsTree& PointKernel::getTree() const
+{
+    if (!_pTree)
+        _pTree = new PointsTree(*this);
+    return *_pTree;
+}
+
+void PointKernel::deleteTree()
+{
+    delete _pTree;
+    _pTree = 0;
+}
+
 void PointKernel::getFaces(std::vector<Base::Vector3d> &Points,std::vector<Facet> &Topo,
                            float Accuracy, uint16_t flags) const
 {
@@ -37,6 +37,7 @@
 
 namespace Points
 {
+class PointsTree;
 
 
 /** Point kernel
@@ -48,16 +49,15 @@ class PointsExport PointKernel : public Data::ComplexGeoData
 public:
     typedef Base::Vector3f value_type;
 
-    PointKernel(void)
+    PointKernel(void) : _pTree(0)
     {
     }
-    PointKernel(unsigned long size)
+    PointKernel(unsigned long size) : _pTree(0)
     {
         resize(size);
     }
-    virtual ~PointKernel()
-    {
-    }
+    PointKernel(const PointKernel&);
+    virtual ~PointKernel();
 
     void operator = (const PointKernel&);
 
@@ -73,14 +73,15 @@ public:
     virtual Data::Segment* getSubElement(const char* Type, unsigned long) const;
     //@}
 
-    inline void setTransform(const Base::Matrix4D& rclTrf){_Mtrx = rclTrf;}
+    inline void setTransform(const Base::Matrix4D& rclTrf){_Mtrx = rclTrf; clearTree();}
     inline Base::Matrix4D getTransform(void) const{return _Mtrx;}
+    /// the search tree is dropped because the points may be changed
     std::vector<value_type>& getBasicPoints()
-    { return this->_Points; }
+    { clearTree(); return this->_Points; }
     const std::vector<value_type>& getBasicPoints() const
     { return this->_Points; }
     void setBasicPoints(const std::vector<value_type>& pts)
-    { this->_Points = pts; }
+    { clearTree(); this->_Points = pts; }
     void getFaces(std::vector<Base::Vector3d> &Points,std::vector<Facet> &Topo,
         float Accuracy, uint16_t flags=0) const;
 
@@ -101,9 +102,23 @@ public:
     void load(std::istream&);
     //@}
 
+    /** Returns a kd-tree of the points for nearest neighbour searches. It is built
+     * on the first call and kept until the points or the transformation are changed
+     * via a non-const method. As it's built on demand it must not be called from
+     * several threads at the same time.
+     */
+    const PointsTree& getTree() const;
+
+private:
+    inline void clearTree() {
+        if (_pTree) deleteTree();
+    }
+    void deleteTree();
+
 private:
     Base::Matrix4D _Mtrx;
     std::vector<value_type> _Points;
+    mutable PointsTree* _pTree;
 
 public:
     typedef std::vector<value_type>::difference_type difference_type;
@@ -111,13 +126,14 @@ public:
 
     /// number of points stored 
     size_type size(void) const {return this->_Points.size();}
-    void resize(unsigned int n){_Points.resize(n);}
+    void resize(unsigned int n){clearTree(); _Points.resize(n);}
     void reserve(unsigned int n){_Points.reserve(n);}
     inline void erase(unsigned long first, unsigned long last) {
+        clearTree();
         _Points.erase(_Points.begin()+first,_Points.begin()+last);
     }
 
-    void clear(void){_Points.clear();}
+    void clear(void){clearTree(); _Points.clear();}
 
 
     /// get the points
@@ -126,10 +142,12 @@ public:
     }
     /// set the points
     inline void setPoint(const int idx,const Base::Vector3d& point) {
+        clearTree();
         _Points[idx] = transformToInside(point);
     }
     /// insert the points
     inline void push_back(const Base::Vector3d& point) {
+        clearTree();
         _Points.push_back(transformToInside(point));
     }
 
@@ -26,6 +26,10 @@
 #ifdef FC_OS_LINUX
 # include <unistd.h>
 #endif
+# include <algorithm>
+# include <cmath>
+# include <cstring>
+# include <limits>
 # include <sstream>
 #endif
 
@@ -38,11 +42,492 @@
 #include <Base/Console.h>
 #include <Base/Sequencer.h>
 #include <Base/Stream.h>
+#include <Base/Swap.h>
 
-#include <boost/regex.hpp>
+#include <boost/bind.hpp>
+#include <boost/math/special_functions/fpclassify.hpp>
+
+#include <QFile>
+#include <QThread>
+#include <QtConcurrentMap>
 
 using namespace Points;
 
+namespace Points {
+
+// the content of a point cloud file, it is mapped into memory if possible
+class PointsFile
+{
+public:
+    PointsFile(const char* FileName) : file(QString::fromUtf8(FileName)), ptr(0), len(0)
+    {
+        if (!file.open(QIODevice::ReadOnly))
+            throw Base::FileException("Cannot open file", FileName);
+        len = (std::size_t)file.size();
+        if (len > 0)
+            ptr = reinterpret_cast<const char*>(file.map(0, file.size()));
+        if (!ptr && len > 0) {
+            // mapping is not possible, read in the whole file instead
+            buffer.resize(len);
+            std::size_t pos = 0;
+            while (pos < len) {
+                qint64 cnt = file.read(&buffer[pos], (qint64)(len - pos));
+                if (cnt <= 0)
+                    throw Base::FileException("Reading in file failed", FileName);
+                pos += (std::size_t)cnt;
+            }
+            ptr = &buffer[0];
+        }
+    }
+    const char* begin() const
+    {
+        return ptr;
+    }
+    const char* end() const
+    {
+        return ptr + len;
+    }
+
+private:
+    QFile file;
+    const char* ptr;
+    std::size_t len;
+    std::vector<char> buffer;
+};
+
+// the scalar types of binary point cloud files
+enum ValueType {
+    TYPE_NONE, TYPE_INT8, TYPE_UINT8, TYPE_INT16, TYPE_UINT16,
+    TYPE_INT32, TYPE_UINT32, TYPE_FLOAT32, TYPE_FLOAT64
+};
+
+static ValueType plyType(const std::string& type)
+{
+    if (type == "char" || type == "int8")
+        return TYPE_INT8;
+    if (type == "uchar" || type == "uint8")
+        return TYPE_UINT8;
+    if (type == "short" || type == "int16")
+        return TYPE_INT16;
+    if (type == "ushort" || type == "uint16")
+        return TYPE_UINT16;
+    if (type == "int" || type == "int32")
+        return TYPE_INT32;
+    if (type == "uint" || type == "uint32")
+        return TYPE_UINT32;
+    if (type == "float" || type == "float32")
+        return TYPE_FLOAT32;
+    if (type == "double" || type == "float64")
+        return TYPE_FLOAT64;
+    return TYPE_NONE;
+}
+
+static ValueType pcdType(char type, int size)
+{
+    if (type == 'I') {
+        if (size == 1)
+            return TYPE_INT8;
+        if (size == 2)
+            return TYPE_INT16;
+        if (size == 4)
+            return TYPE_INT32;
+    }
+    else if (type == 'U') {
+        if (size == 1)
+            return TYPE_UINT8;
+        if (size == 2)
+            return TYPE_UINT16;
+        if (size == 4)
+            return TYPE_UINT32;
+    }
+    else if (type == 'F') {
+        if (size == 4)
+            return TYPE_FLOAT32;
+        if (size == 8)
+            return TYPE_FLOAT64;
+    }
+    return TYPE_NONE;
+}
+
+static std::size_t typeSize(ValueType type)
+{
+    switch (type) {
+    case TYPE_INT8:
+    case TYPE_UINT8:
+        return 1;
+    case TYPE_INT16:
+    case TYPE_UINT16:
+        return 2;
+    case TYPE_INT32:
+    case TYPE_UINT32:
+    case TYPE_FLOAT32:
+        return 4;
+    case TYPE_FLOAT64:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+template <class T>
+static inline float readScalar(const char* data, bool swap)
+{
+    T value;
+    memcpy(&value, data, sizeof(T));
+    if (swap)
+        Base::SwapEndian<T>(value);
+    return static_cast<float>(value);
+}
+
+static inline float readValue(const char* data, ValueType type, bool swap)
+{
+    switch (type) {
+    case TYPE_INT8:
+        return readScalar<int8_t>(data, swap);
+    case TYPE_UINT8:
+        return readScalar<uint8_t>(data, swap);
+    case TYPE_INT16:
+        return readScalar<int16_t>(data, swap);
+    case TYPE_UINT16:
+        return readScalar<uint16_t>(data, swap);
+    case TYPE_INT32:
+        return readScalar<int32_t>(data, swap);
+    case TYPE_UINT32:
+        return readScalar<uint32_t>(data, swap);
+    case TYPE_FLOAT32:
+        return readScalar<float>(data, swap);
+    case TYPE_FLOAT64:
+        return readScalar<double>(data, swap);
+    default:
+        return 0.0f;
+    }
+}
+
+// an element of a PLY file
+struct PlyElement
+{
+    std::string name;
+    std::size_t count;
+    std::size_t size; // the size of a record of a binary file
+    int columns; // the number of values of a line of an ASCII file
+    bool list; // has properties with a variable length
+};
+
+static bool isBigEndian()
+{
+    unsigned short value = 1;
+    return *reinterpret_cast<unsigned char*>(&value) == 0;
+}
+
+static inline bool isValidPoint(const Base::Vector3f& pt)
+{
+    return boost::math::isfinite(pt.x) && boost::math::isfinite(pt.y) && boost::math::isfinite(pt.z);
+}
+
+static inline bool isInvalidPoint(const Base::Vector3f& pt)
+{
+    return !isValidPoint(pt);
+}
+
+static inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static inline bool isSeparator(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == ',' || c == ';';
+}
+
+// the powers of ten which are exactly representable as double
+static const double powersOfTen[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool matchWord(const char* p, const char* end, const char* word)
+{
+    for (; *word; ++word, ++p) {
+        if (p == end || (*p | 0x20) != *word)
+            return false;
+    }
+    return true;
+}
+
+/* Scans a floating point number starting at p. Returns the position after the number
+ * or null if there is no number. This is much faster than atof or streams because it
+ * doesn't depend on the locale and doesn't need a terminating zero. The mantissa keeps
+ * 15 significant digits which is more than enough for the float coordinates.
+ */
+static const char* scanFloat(const char* p, const char* end, double& value)
+{
+    bool neg = false;
+    if (p != end && (*p == '-' || *p == '+')) {
+        neg = (*p == '-');
+        ++p;
+    }
+
+    double mant = 0.0;
+    int exp10 = 0;
+    bool digits = false;
+    for (; p != end && isDigit(*p); ++p) {
+        if (mant < 1e15)
+            mant = mant * 10.0 + (*p - '0');
+        else
+            exp10++;
+        digits = true;
+    }
+    if (p != end && *p == '.') {
+        for (++p; p != end && isDigit(*p); ++p) {
+            if (mant < 1e15) {
+                mant = mant * 10.0 + (*p - '0');
+                exp10--;
+            }
+            digits = true;
+        }
+    }
+
+    if (!digits) {
+        if (matchWord(p, end, "nan")) {
+            value = std::numeric_limits<double>::quiet_NaN();
+            return p + 3;
+        }
+        if (matchWord(p, end, "inf")) {
+            value = neg ? -std::numeric_limits<double>::infinity()
+                        :  std::numeric_limits<double>::infinity();
+            return matchWord(p, end, "infinity") ? p + 8 : p + 3;
+        }
+        return 0;
+    }
+
+    if (p != end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool eneg = false;
+        if (q != end && (*q == '-' || *q == '+')) {
+            eneg = (*q == '-');
+            ++q;
+        }
+        if (q != end && isDigit(*q)) {
+            int exp = 0;
+            for (; q != end && isDigit(*q); ++q) {
+                if (exp < 10000)
+                    exp = exp * 10 + (*q - '0');
+            }
+            exp10 += eneg ? -exp : exp;
+            p = q;
+        }
+    }
+
+    if (exp10 < 0)
+        mant /= (exp10 >= -22 ? powersOfTen[-exp10] : std::pow(10.0, -exp10));
+    else if (exp10 > 0)
+        mant *= (exp10 <= 22 ? powersOfTen[exp10] : std::pow(10.0, exp10));
+    value = neg ? -mant : mant;
+    return p;
+}
+
+/* Scans the numbers of the line starting at p and returns the start of the next line.
+ * The number of values is set to -1 if the line contains anything else than numbers
+ * or more than maxValues numbers.
+ */
+static const char* scanLine(const char* p, const char* end, double* values, int maxValues, int& count)
+{
+    count = 0;
+    for (;;) {
+        while (p != end && isSeparator(*p))
+            ++p;
+        if (p == end || *p == '\n')
+            break;
+        const char* q = count < maxValues ? scanFloat(p, end, values[count]) : 0;
+        if (q && (q == end || *q == '\n' || isSeparator(*q))) {
+            count++;
+            p = q;
+        }
+        else {
+            count = -1;
+            p = static_cast<const char*>(memchr(p, '\n', end - p));
+            if (!p)
+                p = end;
+            break;
+        }
+    }
+
+    if (p != end)
+        ++p;
+    return p;
+}
+
+// parses the lines of a part of an ASCII file
+struct AsciiPointsJob
+{
+    const char* begin;
+    const char* end;
+    int columns; // the number of values of a line
+    int index[3]; // the columns of the coordinates
+    std::vector<Base::Vector3f> points;
+
+    void run()
+    {
+        std::vector<double> values(columns);
+        const char* p = begin;
+        while (p != end) {
+            int count;
+            p = scanLine(p, end, &values[0], columns, count);
+            if (count != columns)
+                continue; // ignore comments and invalid lines
+            Base::Vector3f pt((float)values[index[0]],
+                              (float)values[index[1]],
+                              (float)values[index[2]]);
+            if (isValidPoint(pt))
+                points.push_back(pt);
+        }
+    }
+};
+
+// decodes the records of a binary file
+struct BinaryPointsJob
+{
+    const char* data;
+    std::size_t size; // the size of a record
+    std::size_t offset[3];
+    ValueType type[3];
+    bool swap;
+    Base::Vector3f* points;
+
+    void run(const std::pair<std::size_t, std::size_t>& range) const
+    {
+        bool raw = !swap && type[0] == TYPE_FLOAT32 &&
+                   type[1] == TYPE_FLOAT32 && type[2] == TYPE_FLOAT32;
+        for (std::size_t i = range.first; i < range.second; i++) {
+            const char* record = data + i * size;
+            Base::Vector3f& pt = points[i];
+            if (raw) {
+                memcpy(&pt.x, record + offset[0], sizeof(float));
+                memcpy(&pt.y, record + offset[1], sizeof(float));
+                memcpy(&pt.z, record + offset[2], sizeof(float));
+            }
+            else {
+                pt.x = readValue(record + offset[0], type[0], swap);
+                pt.y = readValue(record + offset[1], type[1], swap);
+                pt.z = readValue(record + offset[2], type[2], swap);
+            }
+        }
+    }
+};
+
+// returns the number of parts to process at once
+static std::size_t countParallelParts()
+{
+    return 2 * std::max<std::size_t>(QThread::idealThreadCount(), 1);
+}
+
+/* Parses the lines between begin and end and appends the points to the kernel.
+ * The text is split into parts at line ends which are parsed in parallel. The parts
+ * are processed in groups so that only a few temporary point arrays exist at a time.
+ */
+static void readAsciiPoints(PointKernel& kernel, const char* begin, const char* end,
+                            int columns, const int index[3])
+{
+    const std::size_t partSize = 4 * 1024 * 1024;
+    std::vector<AsciiPointsJob> parts;
+    for (const char* p = begin; p != end;) {
+        const char* q = p + std::min<std::size_t>(partSize, end - p);
+        if (q != end) {
+            q = static_cast<const char*>(memchr(q, '\n', end - q));
+            q = q ? q + 1 : end;
+        }
+        AsciiPointsJob job;
+        job.begin = p;
+        job.end = q;
+        job.columns = columns;
+        for (int j=0; j<3; j++)
+            job.index[j] = index[j];
+        parts.push_back(job);
+        p = q;
+    }
+
+    std::vector<Base::Vector3f>& points = kernel.getBasicPoints();
+    std::size_t group = countParallelParts();
+    Base::SequencerLauncher seq("Loading points...", (parts.size() + group - 1) / group);
+    for (std::size_t i = 0; i < parts.size(); i += group) {
+        std::vector<AsciiPointsJob>::iterator first = parts.begin() + i;
+        std::vector<AsciiPointsJob>::iterator last = parts.begin() + std::min(i + group, parts.size());
+        if (last - first > 1)
+            QtConcurrent::blockingMap(first, last, boost::bind(&AsciiPointsJob::run, _1));
+        else
+            first->run();
+
+        // the number of points is unknown, estimate it from the first group
+        if (i == 0 && last != parts.end()) {
+            std::size_t count = 0;
+            for (std::vector<AsciiPointsJob>::iterator it = first; it != last; ++it)
+                count += it->points.size();
+            double ratio = double(end - begin) / double((last-1)->end - begin);
+            points.reserve((std::size_t)(1.05 * ratio * count));
+        }
+        for (std::vector<AsciiPointsJob>::iterator it = first; it != last; ++it) {
+            points.insert(points.end(), it->points.begin(), it->points.end());
+            std::vector<Base::Vector3f>().swap(it->points);
+        }
+        seq.next(true);
+    }
+}
+
+/* Decodes the records of a binary file directly into the kernel. The range of
+ * records is split into parts which are decoded in parallel.
+ */
+static void readBinaryPoints(PointKernel& kernel, BinaryPointsJob& job, std::size_t count)
+{
+    std::vector<Base::Vector3f>& points = kernel.getBasicPoints();
+    points.resize(count);
+    if (count == 0)
+        return;
+    job.points = &points[0];
+
+    const std::size_t partSize = 1000000;
+    std::vector<std::pair<std::size_t, std::size_t> > parts;
+    for (std::size_t i = 0; i < count; i += partSize)
+        parts.push_back(std::make_pair(i, std::min(i + partSize, count)));
+
+    std::size_t group = countParallelParts();
+    Base::SequencerLauncher seq("Loading points...", (parts.size() + group - 1) / group);
+    for (std::size_t i = 0; i < parts.size(); i += group) {
+        std::vector<std::pair<std::size_t, std::size_t> >::iterator first = parts.begin() + i;
+        std::vector<std::pair<std::size_t, std::size_t> >::iterator last = parts.begin() + std::min(i + group, parts.size());
+        if (last - first > 1)
+            QtConcurrent::blockingMap(first, last, boost::bind(&BinaryPointsJob::run, &job, _1));
+        else
+            job.run(*first);
+        seq.next(true);
+    }
+
+    // remove undefined points, e.g. of organized point clouds
+    points.erase(std::remove_if(points.begin(), points.end(), isInvalidPoint), points.end());
+}
+
+// reads a line of a file header and returns the start of the next line
+static const char* readHeaderLine(const char* p, const char* end, std::string& line)
+{
+    const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+    if (!eol)
+        eol = end;
+    line.assign(p, eol);
+    if (!line.empty() && line[line.size()-1] == '\r')
+        line.erase(line.size()-1);
+    return eol != end ? eol + 1 : end;
+}
+
+// returns the position after the given number of lines
+static const char* skipLines(const char* p, const char* end, std::size_t count)
+{
+    for (std::size_t i = 0; i < count && p != end; i++) {
+        p = static_cast<const char*>(memchr(p, '\n', end - p));
+        p = p ? p + 1 : end;
+    }
+    return p;
+}
+}
+
 void PointsAlgos::Load(PointKernel &points, const char *FileName)
 {
     Base::FileInfo File(FileName);
@@ -51,63 +536,265 @@ void PointsAlgos::Load(PointKernel &points, const char *FileName)
     if (!File.isReadable())
         throw Base::FileException("File to load not existing or not readable", FileName);
 
-    if (File.extension() == "asc" ||File.extension() == "ASC")
+    if (File.hasExtension("asc"))
         LoadAscii(points,FileName);
+    else if (File.hasExtension("ply"))
+        LoadPly(points,FileName);
+    else if (File.hasExtension("pcd"))
+        LoadPcd(points,FileName);
     else
         throw Base::Exception("Unknown ending");
 }
 
 void PointsAlgos::LoadAscii(PointKernel &points, const char *FileName)
 {
-    boost::regex rx("^\\s*([-+]?[0-9]*)\\.?([0-9]+([eE][-+]?[0-9]+)?)"
-                     "\\s+([-+]?[0-9]*)\\.?([0-9]+([eE][-+]?[0-9]+)?)"
-                     "\\s+([-+]?[0-9]*)\\.?([0-9]+([eE][-+]?[0-9]+)?)\\s*$");
-    //boost::regex rx("(\\b[0-9]+\\.([0-9]+\\b)?|\\.[0-9]+\\b)");
-    //boost::regex rx("^\\s*(-?[0-9]*)\\.([0-9]+)\\s+(-?[0-9]*)\\.([0-9]+)\\s+(-?[0-9]*)\\.([0-9]+)\\s*$");
-    boost::cmatch what;
+    PointsFile file(FileName);
+    points.clear();
+
+    try {
+        // lines with exactly three numbers
+        const int index[3] = {0, 1, 2};
+        readAsciiPoints(points, file.begin(), file.end(), 3, index);
+    }
+    catch (const Base::AbortException&) {
+        points.clear();
+        throw;
+    }
+    catch (...) {
+        points.clear();
+        throw Base::Exception("Reading in points failed.");
+    }
+}
+
+void PointsAlgos::LoadPly(PointKernel &points, const char *FileName)
+{
+    // http://paulbourke.net/dataformats/ply/
+    enum {
+        ascii, binary_little_endian, binary_big_endian
+    } format = ascii;
 
-    Base::Vector3d pt;
-    int LineCnt=0;
+    PointsFile file(FileName);
+    const char* p = file.begin();
+    const char* end = file.end();
     std::string line;
-    Base::FileInfo fi(FileName);
+    p = readHeaderLine(p, end, line);
+    if (line != "ply")
+        throw Base::Exception("Not a PLY file");
 
-    Base::ifstream tmp_str(fi, std::ios::in);
+    std::vector<PlyElement> elements;
+    int vertex = -1;
+    int index[3] = {-1, -1, -1};
+    std::size_t offset[3] = {0, 0, 0};
+    ValueType type[3] = {TYPE_NONE, TYPE_NONE, TYPE_NONE};
+    bool header = false;
+    while (p != end && !header) {
+        p = readHeaderLine(p, end, line);
+        std::istringstream str(line);
+        std::string kw;
+        str >> kw;
+        if (kw == "format") {
+            std::string name;
+            str >> name;
+            if (name == "ascii")
+                format = ascii;
+            else if (name == "binary_little_endian")
+                format = binary_little_endian;
+            else if (name == "binary_big_endian")
+                format = binary_big_endian;
+            else
+                throw Base::Exception("Unknown PLY format");
+        }
+        else if (kw == "element") {
+            PlyElement element;
+            element.count = 0;
+            element.size = 0;
+            element.columns = 0;
+            element.list = false;
+            str >> element.name >> element.count;
+            if (element.name == "vertex" && vertex < 0)
+                vertex = (int)elements.size();
+            elements.push_back(element);
+        }
+        else if (kw == "property") {
+            if (elements.empty())
+                throw Base::Exception("Property without element in PLY header");
+            PlyElement& element = elements.back();
+            std::string kind, name;
+            str >> kind;
+            if (kind == "list") {
+                element.list = true;
+                continue;
+            }
+            str >> name;
+            ValueType value = plyType(kind);
+            if (value == TYPE_NONE)
+                throw Base::Exception("Unknown property type in PLY header");
+            if (vertex == (int)elements.size() - 1) {
+                const char* names[3] = {"x", "y", "z"};
+                for (int j=0; j<3; j++) {
+                    if (name == names[j]) {
+                        index[j] = element.columns;
+                        offset[j] = element.size;
+                        type[j] = value;
+                    }
+                }
+            }
+            element.size += typeSize(value);
+            element.columns++;
+        }
+        else if (kw == "end_header") {
+            header = true;
+        }
+    }
+
+    if (!header)
+        throw Base::Exception("Missing end of PLY header");
+    if (vertex < 0 || index[0] < 0 || index[1] < 0 || index[2] < 0)
+        throw Base::Exception("No vertex coordinates in PLY file");
+    if (elements[vertex].list)
+        throw Base::Exception("Lists of vertex properties are not supported");
+
+    points.clear();
+    try {
+        const PlyElement& v = elements[vertex];
+        if (format == ascii) {
+            // each record is on its own line
+            for (int i = 0; i < vertex; i++)
+                p = skipLines(p, end, elements[i].count);
+            const char* last = skipLines(p, end, v.count);
+            readAsciiPoints(points, p, last, v.columns, index);
+        }
+        else {
+            for (int i = 0; i < vertex; i++) {
+                if (elements[i].list)
+                    throw Base::Exception("Elements with lists before the vertices are not supported");
+                p += std::min<std::size_t>(elements[i].count * elements[i].size, end - p);
+            }
+            if ((std::size_t)(end - p) / v.size < v.count)
+                throw Base::Exception("Unexpected end of PLY file");
+
+            BinaryPointsJob job;
+            job.data = p;
+            job.size = v.size;
+            job.swap = (format == binary_big_endian) != isBigEndian();
+            for (int j=0; j<3; j++) {
+                job.offset[j] = offset[j];
+                job.type[j] = type[j];
+            }
+            readBinaryPoints(points, job, v.count);
+        }
+    }
+    catch (...) {
+        points.clear();
+        throw;
+    }
+}
 
-    // estimating size
-    while (std::getline(tmp_str,line))
-        LineCnt++;
+void PointsAlgos::LoadPcd(PointKernel &points, const char *FileName)
+{
+    // http://pointclouds.org/documentation/tutorials/pcd_file_format.php
+    PointsFile file(FileName);
+    const char* p = file.begin();
+    const char* end = file.end();
 
-    // resize the PointKernel
-    points.resize(LineCnt);
+    std::vector<std::string> fields;
+    std::vector<int> sizes, counts;
+    std::vector<char> types;
+    std::size_t numPoints = 0, width = 0, height = 1;
+    std::string line, data;
+    while (p != end && data.empty()) {
+        p = readHeaderLine(p, end, line);
+        std::istringstream str(line);
+        std::string kw;
+        str >> kw;
+        if (kw == "FIELDS") {
+            std::string name;
+            while (str >> name)
+                fields.push_back(name);
+        }
+        else if (kw == "SIZE") {
+            int size;
+            while (str >> size)
+                sizes.push_back(size);
+        }
+        else if (kw == "TYPE") {
+            char type;
+            while (str >> type)
+                types.push_back(type);
+        }
+        else if (kw == "COUNT") {
+            int count;
+            while (str >> count)
+                counts.push_back(count);
+        }
+        else if (kw == "WIDTH") {
+            str >> width;
+        }
+        else if (kw == "HEIGHT") {
+            str >> height;
+        }
+        else if (kw == "POINTS") {
+            str >> numPoints;
+        }
+        else if (kw == "DATA") {
+            str >> data;
+        }
+    }
 
-    Base::SequencerLauncher seq( "Loading points...", LineCnt );
+    if (data.empty())
+        throw Base::Exception("Missing DATA entry in PCD header");
+    if (counts.empty())
+        counts.resize(fields.size(), 1);
+    if (fields.empty() || sizes.size() != fields.size() ||
+        types.size() != fields.size() || counts.size() != fields.size())
+        throw Base::Exception("Inconsistent fields in PCD header");
+    if (numPoints == 0)
+        numPoints = width * height;
 
-    // again to the beginning
-    Base::ifstream file(fi, std::ios::in);
-    LineCnt = 0;
+    int index[3] = {-1, -1, -1};
+    BinaryPointsJob job;
+    job.size = 0;
+    int columns = 0;
+    for (std::size_t i = 0; i < fields.size(); i++) {
+        const char* names[3] = {"x", "y", "z"};
+        for (int j=0; j<3; j++) {
+            if (fields[i] == names[j]) {
+                index[j] = columns;
+                job.offset[j] = job.size;
+                job.type[j] = pcdType(types[i], sizes[i]);
+            }
+        }
+        columns += counts[i];
+        job.size += sizes[i] * counts[i];
+    }
+    if (index[0] < 0 || index[1] < 0 || index[2] < 0)
+        throw Base::Exception("No point coordinates in PCD file");
+    if (job.size == 0)
+        throw Base::Exception("Invalid field sizes in PCD header");
 
+    points.clear();
     try {
-        // read file
-        while (std::getline(file, line)) {
-            if (boost::regex_match(line.c_str(), what, rx)) {
-                pt.x = std::atof(what[1].first);
-                pt.y = std::atof(what[4].first);
-                pt.z = std::atof(what[7].first);
-
-                points.setPoint(LineCnt,pt);
-                seq.next();
-                LineCnt++;
+        if (data == "ascii") {
+            readAsciiPoints(points, p, end, columns, index);
+        }
+        else if (data == "binary") {
+            for (int j=0; j<3; j++) {
+                if (job.type[j] == TYPE_NONE)
+                    throw Base::Exception("Unknown field type in PCD header");
             }
+            if ((std::size_t)(end - p) / job.size < numPoints)
+                throw Base::Exception("Unexpected end of PCD file");
+            // the data is written in the byte order of the machine, which is little endian in practice
+            job.data = p;
+            job.swap = isBigEndian();
+            readBinaryPoints(points, job, numPoints);
+        }
+        else {
+            throw Base::Exception("Compressed PCD files are not supported");
         }
     }
     catch (...) {
         points.clear();
-        throw Base::Exception("Reading in points failed.");
+        throw;
     }
-
-    // now remove the last points from the kernel
-    // Note: first we allocate memory corresponding to the number of lines (points and comments)
-    //       and read in the file twice. But then the size of the kernel is too high
-    if (LineCnt < (int)points.size())
-        points.erase(LineCnt, points.size());
 }
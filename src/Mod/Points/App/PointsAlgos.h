@@ -34,12 +34,18 @@ namespace Points
 class PointsExport PointsAlgos
 {
 public:
-  /** Load a point cloud
+  /** Load a point cloud, the format is determined by the file extension
    */
   static void Load(PointKernel&, const char *FileName);
-  /** Load a point cloud
+  /** Load a point cloud from an ASCII file with three coordinates per line
    */
   static void LoadAscii(PointKernel&, const char *FileName);
+  /** Load the vertices of an ASCII or binary PLY file
+   */
+  static void LoadPly(PointKernel&, const char *FileName);
+  /** Load an ASCII or binary PCD file of the Point Cloud Library
+   */
+  static void LoadPcd(PointKernel&, const char *FileName);
 
 };
 
@@ -74,8 +74,7 @@ void Feature::onChanged(const App::Property* prop)
 {
     // if the placement has changed apply the change to the point data as well
     if (prop == &this->Placement) {
-        PointKernel& pts = const_cast<PointKernel&>(this->Points.getValue());
-        pts.setTransform(this->Placement.getValue().toMatrix());
+        this->Points.setTransform(this->Placement.getValue().toMatrix());
     }
     // if the point data has changed check and adjust the transformation as well
     else if (prop == &this->Points) {
@@ -24,6 +24,7 @@
 #include "PreCompiled.h"
 
 #include "Mod/Points/App/Points.h"
+#include "Mod/Points/App/PointsTree.h"
 #include <Base/Builder3D.h>
 #include <Base/VectorPy.h>
 #include <Base/GeometryPyCXX.h>
@@ -168,6 +169,106 @@ PyObject* PointsPy::addPoints(PyObject * args)
     Py_Return;
 }
 
+namespace Points {
+// converts a sequence of vectors or tuples into points
+static void getVectors(PyObject* obj, std::vector<Base::Vector3d>& points)
+{
+    Py::Sequence list(obj);
+    union PyType_Object pyType = {&(Base::VectorPy::Type)};
+    Py::Type vType(pyType.o);
+
+    points.reserve(list.size());
+    for (Py::Sequence::iterator it = list.begin(); it != list.end(); ++it) {
+        if ((*it).isType(vType)) {
+            Py::Vector p(*it);
+            points.push_back(p.toVector());
+        }
+        else {
+            Base::Vector3d pnt;
+            Py::Tuple tuple(*it);
+            pnt.x = (double)Py::Float(tuple[0]);
+            pnt.y = (double)Py::Float(tuple[1]);
+            pnt.z = (double)Py::Float(tuple[2]);
+            points.push_back(pnt);
+        }
+    }
+}
+
+static Py::List makeIndexList(const std::vector<std::vector<unsigned long> >& indices)
+{
+    Py::List result;
+    for (std::vector<std::vector<unsigned long> >::const_iterator it = indices.begin(); it != indices.end(); ++it) {
+        Py::List list;
+        for (std::vector<unsigned long>::const_iterator jt = it->begin(); jt != it->end(); ++jt)
+            list.append(Py::Int((long)*jt));
+        result.append(list);
+    }
+    return result;
+}
+}
+
+PyObject* PointsPy::nearestPoints(PyObject * args)
+{
+    PyObject *obj;
+    int k = 1;
+    if (!PyArg_ParseTuple(args, "O|i", &obj, &k))
+        return 0;
+    if (k < 1) {
+        PyErr_SetString(PyExc_ValueError, "number of neighbours must be positive");
+        return 0;
+    }
+
+    std::vector<Base::Vector3d> points;
+    try {
+        getVectors(obj, points);
+    }
+    catch (const Py::Exception&) {
+        PyErr_SetString(PyExc_Exception, "either expect\n"
+            "-- [Vector,...] \n"
+            "-- [(x,y,z),...]");
+        return 0;
+    }
+
+    std::vector<std::vector<unsigned long> > indices;
+    PY_TRY {
+        const Points::PointsTree& tree = getPointKernelPtr()->getTree();
+        tree.FindNearest(points, (unsigned long)k, indices);
+    } PY_CATCH;
+
+    return Py::new_reference_to(makeIndexList(indices));
+}
+
+PyObject* PointsPy::pointsInRadius(PyObject * args)
+{
+    PyObject *obj;
+    double radius;
+    if (!PyArg_ParseTuple(args, "Od", &obj, &radius))
+        return 0;
+    if (radius < 0.0) {
+        PyErr_SetString(PyExc_ValueError, "radius must not be negative");
+        return 0;
+    }
+
+    std::vector<Base::Vector3d> points;
+    try {
+        getVectors(obj, points);
+    }
+    catch (const Py::Exception&) {
+        PyErr_SetString(PyExc_Exception, "either expect\n"
+            "-- [Vector,...] \n"
+            "-- [(x,y,z),...]");
+        return 0;
+    }
+
+    std::vector<std::vector<unsigned long> > indices;
+    PY_TRY {
+        const Points::PointsTree& tree = getPointKernelPtr()->getTree();
+        tree.FindInRadius(points, radius, indices);
+    } PY_CATCH;
+
+    return Py::new_reference_to(makeIndexList(indices));
+}
+
 Py::Int PointsPy::getCountPoints(void) const
 {
     return Py::Int((long)getPointKernelPtr()->size());
@@ -0,0 +1,122 @@
+#   FreeCAD points module tests      LGPL
+
+import FreeCAD, os, unittest, Points
+import struct, tempfile
+
+
+#---------------------------------------------------------------------------
+# define the functions to test the FreeCAD points module
+#---------------------------------------------------------------------------
+
+
+class PointsReaderTestCases(unittest.TestCase):
+    def setUp(self):
+        self.files = []
+        self.coords = [(1.0,2.0,3.0),(-4.5,5.25,0.125),(1000.0,-0.025,7.0)]
+
+    def tearDown(self):
+        for name in self.files:
+            os.remove(name)
+
+    def writeFile(self, ending, data):
+        fd, name = tempfile.mkstemp(ending)
+        os.write(fd, data)
+        os.close(fd)
+        self.files.append(name)
+        return name
+
+    def readPoints(self, ending, data):
+        pts = Points.Points()
+        pts.read(self.writeFile(ending, data))
+        return pts
+
+    def checkPoints(self, pts, coords):
+        self.assertEqual(pts.CountPoints, len(coords))
+        for p, c in zip(pts.Points, coords):
+            self.assertAlmostEqual(p.x, c[0], 4)
+            self.assertAlmostEqual(p.y, c[1], 4)
+            self.assertAlmostEqual(p.z, c[2], 4)
+
+    def testAsciiPly(self):
+        # comments, an element before the vertices, an extra property before
+        # the coordinates, faces after the vertices and DOS line endings
+        data = "ply\r\nformat ascii 1.0\r\ncomment made by hand\r\nobj_info test\r\n"
+        data += "element camera 1\r\nproperty float view_px\r\nproperty float view_py\r\n"
+        data += "element vertex 3\r\nproperty uchar red\r\n"
+        data += "property float x\r\nproperty float y\r\nproperty float z\r\n"
+        data += "element face 1\r\nproperty list uchar int vertex_indices\r\nend_header\r\n"
+        data += "0.5 0.5\r\n"
+        data += "255 1 2 3\r\n"
+        data += "0\t-4.5\t5.25\t1.25e-1\r\n"
+        data += "7 1e3 -2.5E-2 +7\r\n"
+        data += "3 0 1 2\r\n"
+        self.checkPoints(self.readPoints(".ply", data), self.coords)
+
+    def testBinaryPlyLittleEndian(self):
+        data = "ply\nformat binary_little_endian 1.0\n"
+        data += "element vertex 3\nproperty float x\nproperty float y\nproperty float z\n"
+        data += "property uchar red\n"
+        data += "element face 1\nproperty list uchar int vertex_indices\nend_header\n"
+        for c in self.coords:
+            data += struct.pack("<fffB", c[0], c[1], c[2], 255)
+        data += struct.pack("<Biii", 3, 0, 1, 2)
+        self.checkPoints(self.readPoints(".ply", data), self.coords)
+
+    def testBinaryPlyBigEndian(self):
+        # double coordinates and an element before the vertices
+        data = "ply\nformat binary_big_endian 1.0\n"
+        data += "element material 2\nproperty int id\nproperty short flags\n"
+        data += "element vertex 3\nproperty int32 id\n"
+        data += "property float64 z\nproperty float64 y\nproperty float64 x\nend_header\n"
+        data += struct.pack(">ihih", 1, 0, 2, 0)
+        for i, c in enumerate(self.coords):
+            data += struct.pack(">iddd", i, c[2], c[1], c[0])
+        self.checkPoints(self.readPoints(".ply", data), self.coords)
+
+    def testAsciiPcd(self):
+        # comments, a field with several values and an invalid point
+        data = "# .PCD v0.7 - Point Cloud Data file format\nVERSION 0.7\n"
+        data += "FIELDS x y z normal\nSIZE 4 4 4 4\nTYPE F F F F\nCOUNT 1 1 1 3\n"
+        data += "WIDTH 4\nHEIGHT 1\nVIEWPOINT 0 0 0 1 0 0 0\nPOINTS 4\nDATA ascii\n"
+        for c in self.coords:
+            data += "%g %g %g 0 0 1\n" % c
+        data += "nan nan nan 0 0 1\n"
+        self.checkPoints(self.readPoints(".pcd", data), self.coords)
+
+    def testBinaryPcd(self):
+        # an organized point cloud without POINTS entry and undefined points
+        data = "VERSION .7\nFIELDS x y z rgb\nSIZE 4 4 4 4\nTYPE F F F U\n"
+        data += "WIDTH 2\nHEIGHT 2\nDATA binary\n"
+        nan = float("nan")
+        data += struct.pack("<fffI", nan, nan, nan, 0)
+        for c in self.coords:
+            data += struct.pack("<fffI", c[0], c[1], c[2], 0xffffff)
+        self.checkPoints(self.readPoints(".pcd", data), self.coords)
+
+    def testAsciiPartBoundary(self):
+        # the file is parsed in parts of 4 MB which ends in the middle of a line,
+        # comments and invalid lines are skipped
+        lines = ["# comment\n", "1 2\n", "a b c\n"]
+        count = 400000
+        for i in range(count):
+            lines.append("%07d 1 2\n" % i)
+        pts = self.readPoints(".asc", "".join(lines))
+        self.assertEqual(pts.CountPoints, count)
+        for i, p in enumerate(pts.Points):
+            self.assertEqual((p.x, p.y, p.z), (float(i), 1.0, 2.0))
+
+    def testMalformed(self):
+        vertex = "element vertex 3\nproperty float x\nproperty float y\nproperty float z\n"
+        binary = struct.pack("<fff", 1.0, 2.0, 3.0)
+        files = [(".ply", "plyx\nformat ascii 1.0\n" + vertex + "end_header\n"),
+                 (".ply", "ply\nformat ascii 1.0\n" + vertex),
+                 (".ply", "ply\nformat ascii 2.0\nelement vertex 3\nproperty float x\nend_header\n"),
+                 (".ply", "ply\nformat text 1.0\n" + vertex + "end_header\n"),
+                 (".ply", "ply\nformat ascii 1.0\n" + vertex + "property long w\nend_header\n"),
+                 (".ply", "ply\nformat binary_little_endian 1.0\n" + vertex + "end_header\n" + binary),
+                 (".pcd", "FIELDS x y z\nSIZE 4 4 4\nTYPE F F F\nPOINTS 1\n"),
+                 (".pcd", "FIELDS x y z\nSIZE 4 4\nTYPE F F F\nPOINTS 1\nDATA ascii\n1 2 3\n"),
+                 (".pcd", "FIELDS x y z\nSIZE 4 4 4\nTYPE F F F\nPOINTS 2\nDATA binary\n" + binary),
+                 (".pcd", "FIELDS x y z\nSIZE 4 4 4\nTYPE F F F\nPOINTS 1\nDATA binary_compressed\n" + binary)]
+        for ending, data in files:
+            self.assertRaises(Exception, self.readPoints, ending, data)
@@ -0,0 +1,351 @@
+/***************************************************************************
+ *   Copyright (c) 2014                                                    *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <algorithm>
+# include <cmath>
+#endif
+
+#include <boost/bind.hpp>
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include "PointsTree.h"
+
+using namespace Points;
+
+namespace Points {
+// the maximum number of points of a leaf
+static const unsigned long TreeLeafSize = 8;
+// the minimum number of points to build the tree in parallel
+static const unsigned long TreeParallelElements = 100000;
+// the number of queries handled by a job of a batch
+static const unsigned long TreeBatchSize = 1024;
+
+struct TreeEntry
+{
+    Base::Vector3f point;
+    unsigned long index;
+};
+
+// compares two entries along an axis
+struct TreeEntryLess
+{
+    TreeEntryLess(int axis) : axis(axis)
+    {
+    }
+    bool operator()(const TreeEntry& e1, const TreeEntry& e2) const
+    {
+        return e1.point[axis] < e2.point[axis];
+    }
+    unsigned short axis;
+};
+
+// sorts the entries into the order of the tree
+struct TreeBuilder
+{
+    typedef std::pair<unsigned long, unsigned long> Range;
+    std::vector<TreeEntry>* entries;
+    std::vector<unsigned char>* axis;
+
+    // splits the range at its middle along the axis with the largest extent
+    unsigned long splitRange(const Range& range) const
+    {
+        std::vector<TreeEntry>& e = *entries;
+        Base::Vector3f minPt = e[range.first].point;
+        Base::Vector3f maxPt = minPt;
+        for (unsigned long i = range.first + 1; i < range.second; i++) {
+            const Base::Vector3f& pt = e[i].point;
+            minPt.Set(std::min(minPt.x, pt.x), std::min(minPt.y, pt.y), std::min(minPt.z, pt.z));
+            maxPt.Set(std::max(maxPt.x, pt.x), std::max(maxPt.y, pt.y), std::max(maxPt.z, pt.z));
+        }
+
+        Base::Vector3f ext = maxPt - minPt;
+        int dir = 0;
+        if (ext.y > ext[dir])
+            dir = 1;
+        if (ext.z > ext[dir])
+            dir = 2;
+
+        unsigned long mid = range.first + (range.second - range.first) / 2;
+        std::nth_element(e.begin() + range.first, e.begin() + mid,
+                         e.begin() + range.second, TreeEntryLess(dir));
+        (*axis)[mid] = (unsigned char)dir;
+        return mid;
+    }
+    // builds the subtree of the range
+    void split(const Range& range) const
+    {
+        Range r = range;
+        while (r.second - r.first > TreeLeafSize) {
+            unsigned long mid = splitRange(r);
+            split(Range(r.first, mid));
+            r.first = mid + 1;
+        }
+    }
+    // builds the upper levels of the subtree and returns the ranges below
+    void partition(const Range& range, int depth, std::vector<Range>& ranges) const
+    {
+        if (depth == 0 || range.second - range.first <= TreeLeafSize) {
+            ranges.push_back(range);
+            return;
+        }
+
+        unsigned long mid = splitRange(range);
+        partition(Range(range.first, mid), depth - 1, ranges);
+        partition(Range(mid + 1, range.second), depth - 1, ranges);
+    }
+};
+
+static inline double distanceSquared(const Base::Vector3d& p1, const Base::Vector3f& p2)
+{
+    double dx = p1.x - p2.x;
+    double dy = p1.y - p2.y;
+    double dz = p1.z - p2.z;
+    return dx * dx + dy * dy + dz * dz;
+}
+
+// keeps the k nearest points in a max-heap
+static inline void addNeighbour(std::vector<std::pair<double, unsigned long> >& heap,
+                                unsigned long k, double dist, unsigned long pos)
+{
+    if (heap.size() < k) {
+        heap.push_back(std::make_pair(dist, pos));
+        std::push_heap(heap.begin(), heap.end());
+    }
+    else if (dist < heap.front().first) {
+        std::pop_heap(heap.begin(), heap.end());
+        heap.back() = std::make_pair(dist, pos);
+        std::push_heap(heap.begin(), heap.end());
+    }
+}
+}
+
+PointsTree::PointsTree()
+{
+}
+
+PointsTree::PointsTree(const PointKernel& kernel)
+{
+    Build(kernel);
+}
+
+PointsTree::~PointsTree()
+{
+}
+
+void PointsTree::Build(const PointKernel& kernel)
+{
+    Clear();
+    unsigned long count = kernel.size();
+    if (count == 0)
+        return;
+
+    std::vector<TreeEntry> entries(count);
+    for (unsigned long i = 0; i < count; i++) {
+        Base::Vector3d pt = kernel.getPoint(i);
+        entries[i].point.Set((float)pt.x, (float)pt.y, (float)pt.z);
+        entries[i].index = i;
+    }
+
+    _axis.resize(count);
+    TreeBuilder builder;
+    builder.entries = &entries;
+    builder.axis = &_axis;
+
+    // the upper levels are built serially, the subtrees below in parallel
+    int depth = 0;
+    if (count >= TreeParallelElements) {
+        int parts = 4 * std::max(QThread::idealThreadCount(), 1);
+        while ((1 << depth) < parts)
+            depth++;
+    }
+    std::vector<Range> ranges;
+    builder.partition(Range(0, count), depth, ranges);
+    if (ranges.size() > 1)
+        QtConcurrent::blockingMap(ranges, boost::bind(&TreeBuilder::split, &builder, _1));
+    else
+        builder.split(ranges.front());
+
+    _points.resize(count);
+    _indices.resize(count);
+    for (unsigned long i = 0; i < count; i++) {
+        _points[i] = entries[i].point;
+        _indices[i] = entries[i].index;
+    }
+}
+
+void PointsTree::Clear()
+{
+    std::vector<Base::Vector3f>().swap(_points);
+    std::vector<unsigned long>().swap(_indices);
+    std::vector<unsigned char>().swap(_axis);
+}
+
+void PointsTree::SearchNearest(unsigned long first, unsigned long last, const Base::Vector3d& rclPt,
+                               unsigned long k, std::vector<Neighbour>& heap) const
+{
+    if (last - first <= TreeLeafSize) {
+        for (unsigned long i = first; i < last; i++)
+            addNeighbour(heap, k, distanceSquared(rclPt, _points[i]), i);
+        return;
+    }
+
+    unsigned long mid = first + (last - first) / 2;
+    unsigned short axis = _axis[mid];
+    addNeighbour(heap, k, distanceSquared(rclPt, _points[mid]), mid);
+
+    // search the side of the point first, the other side only if it can be closer
+    double diff = rclPt[axis] - _points[mid][axis];
+    if (diff < 0.0) {
+        SearchNearest(first, mid, rclPt, k, heap);
+        if (heap.size() < k || diff * diff < heap.front().first)
+            SearchNearest(mid + 1, last, rclPt, k, heap);
+    }
+    else {
+        SearchNearest(mid + 1, last, rclPt, k, heap);
+        if (heap.size() < k || diff * diff < heap.front().first)
+            SearchNearest(first, mid, rclPt, k, heap);
+    }
+}
+
+void PointsTree::SearchRadius(unsigned long first, unsigned long last, const Base::Vector3d& rclPt,
+                              double fRadius2, std::vector<unsigned long>& raulIndices) const
+{
+    if (last - first <= TreeLeafSize) {
+        for (unsigned long i = first; i < last; i++) {
+            if (distanceSquared(rclPt, _points[i]) <= fRadius2)
+                raulIndices.push_back(_indices[i]);
+        }
+        return;
+    }
+
+    unsigned long mid = first + (last - first) / 2;
+    unsigned short axis = _axis[mid];
+    if (distanceSquared(rclPt, _points[mid]) <= fRadius2)
+        raulIndices.push_back(_indices[mid]);
+
+    double diff = rclPt[axis] - _points[mid][axis];
+    if (diff < 0.0 || diff * diff <= fRadius2)
+        SearchRadius(first, mid, rclPt, fRadius2, raulIndices);
+    if (diff >= 0.0 || diff * diff <= fRadius2)
+        SearchRadius(mid + 1, last, rclPt, fRadius2, raulIndices);
+}
+
+bool PointsTree::FindNearest(const Base::Vector3d& rclPt, unsigned long& ulIndex, double& fDist) const
+{
+    if (_points.empty())
+        return false;
+
+    std::vector<Neighbour> heap;
+    heap.reserve(1);
+    SearchNearest(0, _points.size(), rclPt, 1, heap);
+    ulIndex = _indices[heap.front().second];
+    fDist = sqrt(heap.front().first);
+    return true;
+}
+
+unsigned long PointsTree::FindNearest(const Base::Vector3d& rclPt, unsigned long k,
+                                      std::vector<unsigned long>& raulIndices,
+                                      std::vector<double>& rafDist) const
+{
+    raulIndices.clear();
+    rafDist.clear();
+    if (_points.empty() || k == 0)
+        return 0;
+
+    std::vector<Neighbour> heap;
+    heap.reserve(std::min<unsigned long>(k, _points.size()));
+    SearchNearest(0, _points.size(), rclPt, k, heap);
+
+    // sorts by increasing distance
+    std::sort_heap(heap.begin(), heap.end());
+    raulIndices.reserve(heap.size());
+    rafDist.reserve(heap.size());
+    for (std::vector<Neighbour>::iterator it = heap.begin(); it != heap.end(); ++it) {
+        raulIndices.push_back(_indices[it->second]);
+        rafDist.push_back(sqrt(it->first));
+    }
+    return heap.size();
+}
+
+unsigned long PointsTree::FindInRadius(const Base::Vector3d& rclPt, double fRadius,
+                                       std::vector<unsigned long>& raulIndices) const
+{
+    raulIndices.clear();
+    if (_points.empty() || fRadius < 0.0)
+        return 0;
+
+    SearchRadius(0, _points.size(), rclPt, fRadius * fRadius, raulIndices);
+    return raulIndices.size();
+}
+
+void PointsTree::NearestJob(const std::vector<Base::Vector3d>* pts, unsigned long k,
+                            std::vector<std::vector<unsigned long> >* indices, const Range& range) const
+{
+    std::vector<double> dist;
+    for (unsigned long i = range.first; i < range.second; i++)
+        FindNearest((*pts)[i], k, (*indices)[i], dist);
+}
+
+void PointsTree::RadiusJob(const std::vector<Base::Vector3d>* pts, double fRadius,
+                           std::vector<std::vector<unsigned long> >* indices, const Range& range) const
+{
+    for (unsigned long i = range.first; i < range.second; i++)
+        FindInRadius((*pts)[i], fRadius, (*indices)[i]);
+}
+
+void PointsTree::FindNearest(const std::vector<Base::Vector3d>& rclPts, unsigned long k,
+                             std::vector<std::vector<unsigned long> >& raulIndices) const
+{
+    raulIndices.clear();
+    raulIndices.resize(rclPts.size());
+
+    std::vector<Range> ranges;
+    for (unsigned long i = 0; i < rclPts.size(); i += TreeBatchSize)
+        ranges.push_back(Range(i, std::min<unsigned long>(i + TreeBatchSize, rclPts.size())));
+    if (ranges.size() > 1)
+        QtConcurrent::blockingMap(ranges, boost::bind(&PointsTree::NearestJob, this,
+                                  &rclPts, k, &raulIndices, _1));
+    else if (!ranges.empty())
+        NearestJob(&rclPts, k, &raulIndices, ranges.front());
+}
+
+void PointsTree::FindInRadius(const std::vector<Base::Vector3d>& rclPts, double fRadius,
+                              std::vector<std::vector<unsigned long> >& raulIndices) const
+{
+    raulIndices.clear();
+    raulIndices.resize(rclPts.size());
+
+    std::vector<Range> ranges;
+    for (unsigned long i = 0; i < rclPts.size(); i += TreeBatchSize)
+        ranges.push_back(Range(i, std::min<unsigned long>(i + TreeBatchSize, rclPts.size())));
+    if (ranges.size() > 1)
+        QtConcurrent::blockingMap(ranges, boost::bind(&PointsTree::RadiusJob, this,
+                                  &rclPts, fRadius, &raulIndices, _1));
+    else if (!ranges.empty())
+        RadiusJob(&rclPts, fRadius, &raulIndices, ranges.front());
+}
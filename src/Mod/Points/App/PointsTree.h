@@ -0,0 +1,109 @@
+/***************************************************************************
+ *   Copyright (c) 2014                                                    *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef POINTS_TREE_H
+#define POINTS_TREE_H
+
+#include <vector>
+#include <Base/Vector3D.h>
+
+#include "Points.h"
+
+namespace Points {
+
+/**
+ * The PointsTree class is a balanced kd-tree over the points of a point kernel.
+ * The points are stored in global coordinates in the order of the tree, so that
+ * points close to each other are also close in memory. The tree is implicit, i.e.
+ * the node of a range of points is the point in its middle. Small ranges are leaves
+ * which are searched linearly.
+ *
+ * Building the tree and the batched queries are done in parallel. All queries are
+ * read-only and thus may be called from several threads at the same time.
+ */
+class PointsExport PointsTree
+{
+public:
+    /// Construction
+    PointsTree();
+    /// Construction
+    PointsTree(const PointKernel&);
+    /// Destruction
+    ~PointsTree();
+
+    /** Builds the tree for the points of the kernel. */
+    void Build(const PointKernel&);
+    /** Removes all points from the tree. */
+    void Clear();
+    /** Returns the number of points of the tree. */
+    unsigned long Size() const
+    { return _points.size(); }
+
+    /** @name Search */
+    //@{
+    /** Searches for the nearest point to \a rclPt. Returns false if the tree is empty. */
+    bool FindNearest(const Base::Vector3d& rclPt, unsigned long& ulIndex, double& fDist) const;
+    /** Searches for the \a k nearest points to \a rclPt. The indices and distances
+     * are sorted by increasing distance. Returns the number of found points.
+     */
+    unsigned long FindNearest(const Base::Vector3d& rclPt, unsigned long k,
+                              std::vector<unsigned long>& raulIndices,
+                              std::vector<double>& rafDist) const;
+    /** Searches for all points within the distance \a fRadius to \a rclPt. The order
+     * of the indices is undefined. Returns the number of found points.
+     */
+    unsigned long FindInRadius(const Base::Vector3d& rclPt, double fRadius,
+                               std::vector<unsigned long>& raulIndices) const;
+    /** Searches for the \a k nearest points of each of the given points in parallel. */
+    void FindNearest(const std::vector<Base::Vector3d>& rclPts, unsigned long k,
+                     std::vector<std::vector<unsigned long> >& raulIndices) const;
+    /** Searches for the points within the distance \a fRadius of each of the given
+     * points in parallel.
+     */
+    void FindInRadius(const std::vector<Base::Vector3d>& rclPts, double fRadius,
+                      std::vector<std::vector<unsigned long> >& raulIndices) const;
+    //@}
+
+private:
+    typedef std::pair<double, unsigned long> Neighbour;
+    typedef std::pair<unsigned long, unsigned long> Range;
+
+    void SearchNearest(unsigned long first, unsigned long last, const Base::Vector3d& rclPt,
+                       unsigned long k, std::vector<Neighbour>& heap) const;
+    void SearchRadius(unsigned long first, unsigned long last, const Base::Vector3d& rclPt,
+                      double fRadius2, std::vector<unsigned long>& raulIndices) const;
+    void NearestJob(const std::vector<Base::Vector3d>* pts, unsigned long k,
+                    std::vector<std::vector<unsigned long> >* indices, const Range& range) const;
+    void RadiusJob(const std::vector<Base::Vector3d>* pts, double fRadius,
+                   std::vector<std::vector<unsigned long> >* indices, const Range& range) const;
+
+private:
+    std::vector<Base::Vector3f> _points;  /**< The points in the order of the tree. */
+    std::vector<unsigned long> _indices;  /**< The index in the kernel of each point. */
+    std::vector<unsigned char> _axis;     /**< The split axis of each inner node. */
+};
+
+} // namespace Points
+
+#endif // POINTS_TREE_H
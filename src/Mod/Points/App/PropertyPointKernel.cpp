@@ -51,9 +51,26 @@ PropertyPointKernel::~PropertyPointKernel()
 {
 }
 
+void PropertyPointKernel::detachPoints(bool copyData)
+{
+    // the kernel is shared with a copy of this property or a Python object
+    if (_cPoints.getRefCount() <= 1)
+        return;
+
+    PointKernel* points = new PointKernel();
+    if (copyData)
+        *points = *_cPoints;
+    else
+        points->setTransform(_cPoints->getTransform());
+    _cPoints = points;
+}
+
 void PropertyPointKernel::setValue(const PointKernel& m)
 {
+    // keep the passed kernel alive if it's the shared object
+    Base::Reference<PointKernel> tmp(_cPoints);
     aboutToSetValue();
+    detachPoints(false);
     *_cPoints = m;
     hasSetValue();
 }
@@ -124,6 +141,7 @@ void PropertyPointKernel::Restore(Base::XMLReader &reader)
         mtrx.fromString(Matrix);
 
         aboutToSetValue();
+        detachPoints(true);
         _cPoints->setTransform(mtrx);
         hasSetValue();
     }
@@ -137,28 +155,32 @@ void PropertyPointKernel::SaveDocFile (Base::Writer &writer) const
 void PropertyPointKernel::RestoreDocFile(Base::Reader &reader)
 {
     aboutToSetValue();
+    detachPoints(false);
     _cPoints->RestoreDocFile(reader);
     hasSetValue();
 }
 
 App::Property *PropertyPointKernel::Copy(void) const 
 {
+    // the kernel is duplicated when one of both properties gets modified
     PropertyPointKernel* prop = new PropertyPointKernel();
-    (*prop->_cPoints) = (*this->_cPoints);
+    prop->_cPoints = this->_cPoints;
     return prop;
 }
 
 void PropertyPointKernel::Paste(const App::Property &from)
 {
-    aboutToSetValue();
     const PropertyPointKernel& prop = dynamic_cast<const PropertyPointKernel&>(from);
-    *(this->_cPoints) = *(prop._cPoints);
+    Base::Reference<PointKernel> tmp(_cPoints);
+    aboutToSetValue();
+    _cPoints = prop._cPoints;
     hasSetValue();
 }
 
 unsigned int PropertyPointKernel::getMemSize (void) const
 {
-    return sizeof(Base::Vector3f) * this->_cPoints->size();
+    // a kernel shared with copies of this property is counted in proportion
+    return sizeof(Base::Vector3f) * this->_cPoints->size() / this->_cPoints.getRefCount();
 }
 
 void PropertyPointKernel::removeIndices( const std::vector<unsigned long>& uIndices )
@@ -192,6 +214,13 @@ void PropertyPointKernel::removeIndices( const std::vector<unsigned long>& uIndi
 void PropertyPointKernel::transformGeometry(const Base::Matrix4D &rclMat)
 {
     aboutToSetValue();
+    detachPoints(true);
     _cPoints->transformGeometry(rclMat);
     hasSetValue();
 }
+
+void PropertyPointKernel::setTransform(const Base::Matrix4D& rclTrf)
+{
+    detachPoints(true);
+    _cPoints->setTransform(rclTrf);
+}
@@ -30,6 +30,9 @@ namespace Points
 {
 
 /** The point kernel property
+ * The copies of the property that are made for the Undo/Redo share the point
+ * kernel with the property. The kernel is only duplicated when the property is
+ * modified while it is still referenced elsewhere (copy-on-write).
  */
 class PointsExport PropertyPointKernel : public App::PropertyComplexGeoData
 {
@@ -79,6 +82,12 @@ public:
     void Restore(Base::XMLReader &reader);
     void SaveDocFile (Base::Writer &writer) const;
     void RestoreDocFile(Base::Reader &reader);
+    bool canSaveDocFileConcurrently() const {
+        return true;
+    }
+    bool canRestoreDocFileConcurrently() const {
+        return true;
+    }
     //@}
 
     /** @name Modification */
@@ -86,8 +95,13 @@ public:
     /// Transform the real 3d point kernel
     void transformGeometry(const Base::Matrix4D &rclMat);
     void removeIndices( const std::vector<unsigned long>& );
+    /// Sets the transformation of the points without notification
+    void setTransform(const Base::Matrix4D& rclTrf);
     //@}
 
+private:
+    void detachPoints(bool copyData);
+
 private:
     Base::Reference<PointKernel> _cPoints;
 };
@@ -34,7 +34,7 @@
 #include <Base/Exception.h>
 #include <Base/TimeInfo.h>
 #include <Base/Console.h>
-
+#include <App/Application.h>
 #include <Base/VectorPy.h>
 
 #include <Mod/Part/App/Geometry.h>
@@ -1615,13 +1615,34 @@ int Sketch::solve(void)
         isFine = true;
     }
 
+    // optionally race the DogLeg, LevenbergMarquardt and BFGS solvers instead of
+    // trying them one after the other, the first one that succeeds wins
+    bool raceSolvers = false;
+    if (!isInitMove) {
+        ParameterGrp::handle hGrp = App::GetApplication().GetParameterGroupByPath
+            ("User parameter:BaseApp/Preferences/Mod/Sketcher");
+        raceSolvers = hGrp->GetBool("RaceSolvers", false);
+    }
+
     int ret;
     bool valid_solution;
     for (int soltype=0; soltype < (isInitMove ? 1 : 4); soltype++) {
+        // the race already includes the LevenbergMarquardt and BFGS solvers
+        if (raceSolvers && (soltype == 1 || soltype == 2))
+            continue;
         std::string solvername;
         switch (soltype) {
         case 0: // solving with the default DogLeg solver
                 // (or with SQP if we are in moving mode)
+            if (raceSolvers) {
+                solvername = "DogLeg/LevenbergMarquardt/BFGS";
+                std::vector<GCS::Algorithm> algs;
+                algs.push_back(GCS::DogLeg);
+                algs.push_back(GCS::LevenbergMarquardt);
+                algs.push_back(GCS::BFGS);
+                ret = GCSsys.solve(algs, isFine);
+                break;
+            }
             solvername = isInitMove ? "SQP" : "DogLeg";
             ret = GCSsys.solve(isFine, GCS::DogLeg);
             break;
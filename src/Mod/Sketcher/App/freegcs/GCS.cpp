@@ -29,6 +29,11 @@
 
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/connected_components.hpp>
+#include <boost/bind.hpp>
+
+#include <QAtomicInt>
+#include <QtConcurrentMap>
+#include <QThread>
 
 // http://forum.freecadweb.org/viewtopic.php?f=3&t=4651&start=40
 namespace Eigen {
@@ -134,6 +139,92 @@ namespace GCS
 
 typedef boost::adjacency_list <boost::vecS, boost::vecS, boost::undirectedS> Graph;
 
+// creates a copy of the constraint that refers to the same parameters
+static Constraint *copyConstraint(Constraint *constr)
+{
+    switch (constr->getTypeId()) {
+        case Equal:
+            return new ConstraintEqual(*static_cast<ConstraintEqual *>(constr));
+        case Difference:
+            return new ConstraintDifference(*static_cast<ConstraintDifference *>(constr));
+        case P2PDistance:
+            return new ConstraintP2PDistance(*static_cast<ConstraintP2PDistance *>(constr));
+        case P2PAngle:
+            return new ConstraintP2PAngle(*static_cast<ConstraintP2PAngle *>(constr));
+        case P2LDistance:
+            return new ConstraintP2LDistance(*static_cast<ConstraintP2LDistance *>(constr));
+        case PointOnLine:
+            return new ConstraintPointOnLine(*static_cast<ConstraintPointOnLine *>(constr));
+        case PointOnPerpBisector:
+            return new ConstraintPointOnPerpBisector(*static_cast<ConstraintPointOnPerpBisector *>(constr));
+        case Parallel:
+            return new ConstraintParallel(*static_cast<ConstraintParallel *>(constr));
+        case Perpendicular:
+            return new ConstraintPerpendicular(*static_cast<ConstraintPerpendicular *>(constr));
+        case L2LAngle:
+            return new ConstraintL2LAngle(*static_cast<ConstraintL2LAngle *>(constr));
+        case MidpointOnLine:
+            return new ConstraintMidpointOnLine(*static_cast<ConstraintMidpointOnLine *>(constr));
+        case TangentCircumf:
+            return new ConstraintTangentCircumf(*static_cast<ConstraintTangentCircumf *>(constr));
+        case None:
+            break;
+    }
+    return 0;
+}
+
+// solves one of the decoupled components of a system
+struct SolveJob
+{
+    SolveJob(System *sys_, SubSystem *subsys_, SubSystem *subsysAux_, bool isFine_, Algorithm alg_)
+      : sys(sys_), subsys(subsys_), subsysAux(subsysAux_), isFine(isFine_), alg(alg_), result(Failed),
+        race(0), index(0)
+    {
+    }
+    void run()
+    {
+        if (subsys && subsysAux)
+            result = sys->solve(subsys, subsysAux, isFine);
+        else if (subsys)
+            result = sys->solve(subsys, isFine, alg);
+        else if (subsysAux)
+            result = sys->solve(subsysAux, isFine, alg);
+
+        // the first algorithm that succeeds cancels the others of the race
+        if (race && result == Success)
+            race->testAndSetOrdered(0, index+1);
+    }
+
+    System *sys;
+    SubSystem *subsys, *subsysAux;
+    bool isFine;
+    Algorithm alg;
+    int result;
+    QAtomicInt *race; // shared by the algorithms racing on the same component
+    int index;        // position of the algorithm in the race
+};
+
+// the components don't share any parameters or constraints and thus can be
+// solved concurrently, the algorithms of a race are always run concurrently
+static void runSolveJobs(std::vector<SolveJob> &jobs, bool race=false)
+{
+    int size = 0;
+    for (std::vector<SolveJob>::const_iterator it = jobs.begin(); it != jobs.end(); ++it) {
+        if (it->subsys)
+            size += it->subsys->pSize();
+        if (it->subsysAux)
+            size += it->subsysAux->pSize();
+    }
+
+    if (jobs.size() > 1 && (race || size >= ParallelThreshold) && QThread::idealThreadCount() > 1) {
+        QtConcurrent::blockingMap(jobs, boost::bind(&SolveJob::run, _1));
+    }
+    else {
+        for (std::vector<SolveJob>::iterator it = jobs.begin(); it != jobs.end(); ++it)
+            it->run();
+    }
+}
+
 ///////////////////////////////////////
 // Solver
 ///////////////////////////////////////
@@ -158,61 +249,7 @@ System::System(std::vector<Constraint *> clist_)
     // create own (shallow) copy of constraints
     for (std::vector<Constraint *>::iterator constr=clist_.begin();
          constr != clist_.end(); ++constr) {
-        Constraint *newconstr;
-        switch ((*constr)->getTypeId()) {
-            case Equal: {
-                ConstraintEqual *oldconstr = static_cast<ConstraintEqual *>(*constr);
-                newconstr = new ConstraintEqual(*oldconstr);
-                break;
-            }
-            case Difference: {
-                ConstraintDifference *oldconstr = static_cast<ConstraintDifference *>(*constr);
-                newconstr = new ConstraintDifference(*oldconstr);
-                break;
-            }
-            case P2PDistance: {
-                ConstraintP2PDistance *oldconstr = static_cast<ConstraintP2PDistance *>(*constr);
-                newconstr = new ConstraintP2PDistance(*oldconstr);
-                break;
-            }
-            case P2PAngle: {
-                ConstraintP2PAngle *oldconstr = static_cast<ConstraintP2PAngle *>(*constr);
-                newconstr = new ConstraintP2PAngle(*oldconstr);
-                break;
-            }
-            case P2LDistance: {
-                ConstraintP2LDistance *oldconstr = static_cast<ConstraintP2LDistance *>(*constr);
-                newconstr = new ConstraintP2LDistance(*oldconstr);
-                break;
-            }
-            case PointOnLine: {
-                ConstraintPointOnLine *oldconstr = static_cast<ConstraintPointOnLine *>(*constr);
-                newconstr = new ConstraintPointOnLine(*oldconstr);
-                break;
-            }
-            case Parallel: {
-                ConstraintParallel *oldconstr = static_cast<ConstraintParallel *>(*constr);
-                newconstr = new ConstraintParallel(*oldconstr);
-                break;
-            }
-            case Perpendicular: {
-                ConstraintPerpendicular *oldconstr = static_cast<ConstraintPerpendicular *>(*constr);
-                newconstr = new ConstraintPerpendicular(*oldconstr);
-                break;
-            }
-            case L2LAngle: {
-                ConstraintL2LAngle *oldconstr = static_cast<ConstraintL2LAngle *>(*constr);
-                newconstr = new ConstraintL2LAngle(*oldconstr);
-                break;
-            }
-            case MidpointOnLine: {
-                ConstraintMidpointOnLine *oldconstr = static_cast<ConstraintMidpointOnLine *>(*constr);
-                newconstr = new ConstraintMidpointOnLine(*oldconstr);
-                break;
-            }
-            case None:
-                break;
-        }
+        Constraint *newconstr = copyConstraint(*constr);
         if (newconstr)
             addConstraint(newconstr);
     }
@@ -854,33 +891,127 @@ int System::solve(bool isFine, Algorithm alg)
     if (!isInit)
         return Failed;
 
-    bool isReset = false;
+    std::vector<SolveJob> jobs;
+    for (int cid=0; cid < int(subSystems.size()); cid++) {
+        if (subSystems[cid] || subSystemsAux[cid])
+            jobs.push_back(SolveJob(this, subSystems[cid], subSystemsAux[cid], isFine, alg));
+    }
+
     // return success by default in order to permit coincidence constraints to be applied
     // even if no other system has to be solved
     int res = Success;
+    if (!jobs.empty()) {
+        resetToReference();
+        runSolveJobs(jobs);
+        for (std::vector<SolveJob>::const_iterator it = jobs.begin(); it != jobs.end(); ++it)
+            res = std::max(res, it->result);
+    }
+    if (res == Success && violatesRedundant())
+        res = Converged;
+    return res;
+}
+
+int System::solve(const std::vector<Algorithm> &algs, bool isFine)
+{
+    if (!isInit)
+        return Failed;
+    if (algs.size() < 2)
+        return solve(isFine, algs.empty() ? DogLeg : algs.front());
+
+    // The first algorithm works on the subsystem itself and the others on copies
+    // of it. A copy has its own constraints and variables but refers to the same
+    // parameters, which are only read while solving.
+    std::vector<SolveJob> jobs;
+    std::vector<int> jobsPerComponent;
+    std::vector<SubSystem *> subsysCopies;
+    std::vector<Constraint *> constrCopies;
+    std::vector<QAtomicInt> races(subSystems.size());
     for (int cid=0; cid < int(subSystems.size()); cid++) {
-        if ((subSystems[cid] || subSystemsAux[cid]) && !isReset) {
-             resetToReference();
-             isReset = true;
+        if (subSystems[cid] && subSystemsAux[cid]) {
+            // the augmented system is always solved with SQP
+            jobs.push_back(SolveJob(this, subSystems[cid], subSystemsAux[cid], isFine, algs[0]));
+            jobsPerComponent.push_back(1);
+            continue;
         }
-        if (subSystems[cid] && subSystemsAux[cid])
-            res = std::max(res, solve(subSystems[cid], subSystemsAux[cid], isFine));
-        else if (subSystems[cid])
-            res = std::max(res, solve(subSystems[cid], isFine, alg));
-        else if (subSystemsAux[cid])
-            res = std::max(res, solve(subSystemsAux[cid], isFine, alg));
+
+        SubSystem *subsys = subSystems[cid] ? subSystems[cid] : subSystemsAux[cid];
+        if (!subsys)
+            continue;
+        bool isAux = (subsys == subSystemsAux[cid]);
+        for (std::size_t i=0; i < algs.size(); i++) {
+            SubSystem *racer = subsys;
+            if (i > 0) {
+                std::vector<Constraint *> clistCopy;
+                for (std::vector<Constraint *>::const_iterator constr=clists[cid].begin();
+                     constr != clists[cid].end(); ++constr) {
+                    if (((*constr)->getTag() < 0) == isAux)
+                        clistCopy.push_back(copyConstraint(*constr));
+                }
+                constrCopies.insert(constrCopies.end(), clistCopy.begin(), clistCopy.end());
+                racer = new SubSystem(clistCopy, plists[cid], reductionmaps[cid]);
+                subsysCopies.push_back(racer);
+            }
+            racer->setCancelFlag(&races[cid]);
+            jobs.push_back(SolveJob(this, racer, 0, isFine, algs[i]));
+            jobs.back().race = &races[cid];
+            jobs.back().index = int(i);
+        }
+        jobsPerComponent.push_back(int(algs.size()));
     }
-    if (res == Success) {
-        for (std::set<Constraint *>::const_iterator constr=redundant.begin();
-             constr != redundant.end(); constr++)
-             if ((*constr)->error() > XconvergenceFine) {
-                 res = Converged;
-                 return res;
-             }
+
+    int res = Success;
+    if (!jobs.empty()) {
+        resetToReference();
+        runSolveJobs(jobs, true);
+
+        // keep the solution of the algorithm that succeeded first, if none did keep the
+        // best result, a copy has the same parameter order as the subsystem it was made of
+        std::size_t first = 0;
+        for (std::vector<int>::const_iterator it = jobsPerComponent.begin();
+             it != jobsPerComponent.end(); ++it) {
+            std::size_t best = first;
+            QAtomicInt *race = jobs[first].race;
+            if (race) {
+                jobs[first].subsys->setCancelFlag(0);
+                int winner = *race;
+                if (winner > 0) {
+                    best = first + winner - 1;
+                }
+                else {
+                    for (std::size_t i=first+1; i < first + *it; i++) {
+                        if (jobs[i].result < jobs[best].result)
+                            best = i;
+                    }
+                }
+            }
+            if (best != first) {
+                Eigen::VectorXd x;
+                jobs[best].subsys->getParams(x);
+                jobs[first].subsys->setParams(x);
+            }
+            res = std::max(res, jobs[best].result);
+            first += *it;
+        }
     }
+
+    free(subsysCopies);
+    free(constrCopies);
+
+    if (res == Success && violatesRedundant())
+        res = Converged;
     return res;
 }
 
+bool System::violatesRedundant()
+{
+    for (std::set<Constraint *>::const_iterator constr=redundant.begin();
+         constr != redundant.end(); constr++) {
+        if ((*constr)->error() > XconvergenceFine)
+            return true;
+    }
+    return false;
+}
+
 int System::solve(SubSystem *subsys, bool isFine, Algorithm alg)
 {
     if (alg == BFGS)
@@ -928,6 +1059,8 @@ int System::solve_BFGS(SubSystem *subsys, bool isFine)
 
         if (h.norm() <= convergence || err <= smallF)
             break;
+        if (subsys->isCanceled()) // another solver already succeeded
+            break;
         if (err > divergingLim || err != err) // check for diverging and NaN
             break;
 
@@ -966,7 +1099,79 @@ int System::solve_BFGS(SubSystem *subsys, bool isFine)
     return Failed;
 }
 
+// The linear algebra of the Levenberg-Marquardt and DogLeg solvers for dense
+// and sparse jacobi matrices. Each constraint only depends on a few parameters
+// so that the jacobi matrices of large subsystems are very sparse.
+
+// solves the symmetric system A*h = g
+static void solveNormal(const Eigen::MatrixXd &A, const Eigen::VectorXd &g, Eigen::VectorXd &h)
+{
+    h = A.fullPivLu().solve(g);
+}
+
+// computes the Gauss-Newton step, i.e. solves J*h = -fx
+static void solveGaussNewton(const Eigen::MatrixXd &J, const Eigen::VectorXd &fx, Eigen::VectorXd &h)
+{
+    h = J.fullPivLu().solve(-fx);
+}
+
+#ifdef FREEGCS_SPARSE
+// solves the symmetric positive semi-definite system A*h = g, returns false if
+// the factorization fails or the solution is not accurate, e.g. if A is singular
+static bool solveSparse(const Eigen::SparseMatrix<double> &A, const Eigen::VectorXd &g, Eigen::VectorXd &h)
+{
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double> > ldlt(A);
+    if (ldlt.info() != Eigen::Success)
+        return false;
+    h = ldlt.solve(g);
+    for (int i=0; i < h.size(); i++) {
+        if (!(fabs(h[i]) <= DBL_MAX)) // NaN or infinite
+            return false;
+    }
+    return (A*h - g).norm() <= 1e-8 * g.norm();
+}
+
+static void solveNormal(const Eigen::SparseMatrix<double> &A, const Eigen::VectorXd &g, Eigen::VectorXd &h)
+{
+    if (!solveSparse(A, g, h))
+        solveNormal(Eigen::MatrixXd(A), g, h);
+}
+
+static void solveGaussNewton(const Eigen::SparseMatrix<double> &J, const Eigen::VectorXd &fx, Eigen::VectorXd &h)
+{
+    // the minimum norm solution of an under-determined system or the least
+    // squares solution of an over-determined system
+    Eigen::SparseMatrix<double> Jt = J.transpose();
+    bool ok;
+    if (J.rows() <= J.cols()) {
+        Eigen::SparseMatrix<double> JJt = J * Jt;
+        Eigen::VectorXd y;
+        ok = solveSparse(JJt, -fx, y);
+        if (ok)
+            h = Jt * y;
+    }
+    else {
+        Eigen::SparseMatrix<double> JtJ = Jt * J;
+        Eigen::VectorXd g = Jt * (-fx);
+        ok = solveSparse(JtJ, g, h);
+    }
+
+    if (!ok)
+        solveGaussNewton(Eigen::MatrixXd(J), fx, h);
+}
+#endif
+
 int System::solve_LM(SubSystem* subsys)
+{
+#ifdef FREEGCS_SPARSE
+    if (subsys->pSize() >= SparseThreshold)
+        return solveLM<Eigen::SparseMatrix<double> >(subsys);
+#endif
+    return solveLM<Eigen::MatrixXd>(subsys);
+}
+
+template <typename MatrixType>
+int System::solveLM(SubSystem* subsys)
 {
     int xsize = subsys->pSize();
     int csize = subsys->cSize();
@@ -975,8 +1180,8 @@ int System::solve_LM(SubSystem* subsys)
         return Success;
 
     Eigen::VectorXd e(csize), e_new(csize); // vector of all function errors (every constraint is one function)
-    Eigen::MatrixXd J(csize, xsize);        // Jacobi of the subsystem
-    Eigen::MatrixXd A(xsize, xsize);
+    MatrixType J(csize, xsize);             // Jacobi of the subsystem
+    MatrixType A(xsize, xsize);
     Eigen::VectorXd x(xsize), h(xsize), x_new(xsize), g(xsize), diag_A(xsize);
 
     subsys->redirectParams();
@@ -1004,6 +1209,10 @@ int System::solve_LM(SubSystem* subsys)
             stop = 6;
             break;
         }
+        else if (subsys->isCanceled()) { // another solver already succeeded
+            stop = 8;
+            break;
+        }
 
         // J^T J, J^T e
         subsys->calcJacobi(J);;
@@ -1013,7 +1222,8 @@ int System::solve_LM(SubSystem* subsys)
 
         // Compute ||J^T e||_inf
         double g_inf = g.lpNorm<Eigen::Infinity>();
-        diag_A = A.diagonal(); // save diagonal entries so that augmentation can be later canceled
+        for (int i=0; i < xsize; ++i) // save diagonal entries so that augmentation can be later canceled
+            diag_A(i) = A.coeff(i,i);
 
         // check for convergence
         if (g_inf <= eps1) {
@@ -1030,10 +1240,10 @@ int System::solve_LM(SubSystem* subsys)
         while (k < 50) {
             // augment normal equations A = A+uI
             for (int i=0; i < xsize; ++i)
-                A(i,i) += mu;
+                A.coeffRef(i,i) += mu;
 
             //solve augmented functions A*h=-g
-            h = A.fullPivLu().solve(g);
+            solveNormal(A, g, h);
             double rel_error = (A*h - g).norm() / g.norm();
 
             // check if solving works
@@ -1082,7 +1292,7 @@ int System::solve_LM(SubSystem* subsys)
             mu*=nu;
             nu*=2.0;
             for (int i=0; i < xsize; ++i) // restore diagonal J^T J entries
-                A(i,i) = diag_A(i);
+                A.coeffRef(i,i) = diag_A(i);
 
             k++;
         }
@@ -1102,6 +1312,16 @@ int System::solve_LM(SubSystem* subsys)
 
 
 int System::solve_DL(SubSystem* subsys)
+{
+#ifdef FREEGCS_SPARSE
+    if (subsys->pSize() >= SparseThreshold)
+        return solveDL<Eigen::SparseMatrix<double> >(subsys);
+#endif
+    return solveDL<Eigen::MatrixXd>(subsys);
+}
+
+template <typename MatrixType>
+int System::solveDL(SubSystem* subsys)
 {
     double tolg=1e-80, tolx=1e-80, tolf=1e-10;
 
@@ -1113,7 +1333,7 @@ int System::solve_DL(SubSystem* subsys)
 
     Eigen::VectorXd x(xsize), x_new(xsize);
     Eigen::VectorXd fx(csize), fx_new(csize);
-    Eigen::MatrixXd Jx(csize, xsize), Jx_new(csize, xsize);
+    MatrixType Jx(csize, xsize), Jx_new(csize, xsize);
     Eigen::VectorXd g(xsize), h_sd(xsize), h_gn(xsize), h_dl(xsize);
 
     subsys->redirectParams();
@@ -1150,13 +1370,16 @@ int System::solve_DL(SubSystem* subsys)
         else if (err > divergingLim || err != err) { // check for diverging and NaN
             stop = 6;
         }
+        else if (subsys->isCanceled()) { // another solver already succeeded
+            stop = 7;
+        }
         else {
             // get the steepest descent direction
             alpha = g.squaredNorm()/(Jx*g).squaredNorm();
             h_sd  = alpha*g;
 
             // get the gauss-newton step
-            h_gn = Jx.fullPivLu().solve(-fx);
+            solveGaussNewton(Jx, fx, h_gn);
             double rel_error = (Jx*h_gn + fx).norm() / fx.norm();
             if (rel_error > 1e15)
                 break;
@@ -1452,15 +1675,21 @@ int System::diagnose()
     redundant.clear();
     conflictingTags.clear();
     redundantTags.clear();
-    Eigen::MatrixXd J(clist.size(), plist.size());
+    Eigen::MatrixXd J = Eigen::MatrixXd::Zero(clist.size(), plist.size());
     int count=0;
     for (std::vector<Constraint *>::iterator constr=clist.begin();
          constr != clist.end(); ++constr) {
         (*constr)->revertParams();
         if ((*constr)->getTag() >= 0) {
             count++;
-            for (int j=0; j < int(plist.size()); j++)
-                J(count-1,j) = (*constr)->grad(plist[j]);
+            // only the parameters of the constraint have non-zero derivatives
+            VEC_pD &constr_params = c2p[*constr];
+            for (VEC_pD::const_iterator param=constr_params.begin();
+                 param != constr_params.end(); ++param) {
+                MAP_pD_I::const_iterator it = pIndex.find(*param);
+                if (it != pIndex.end())
+                    J(count-1,it->second) = (*constr)->grad(*param);
+            }
         }
     }
 
@@ -75,9 +75,14 @@ namespace GCS
         bool hasDiagnosis; // if dofs, conflictingTags, redundantTags are up to date
         bool isInit;       // if plists, clists, reductionmaps are up to date
 
+        bool violatesRedundant(); // if the solution violates one of the redundant constraints
+
         int solve_BFGS(SubSystem *subsys, bool isFine);
         int solve_LM(SubSystem *subsys);
         int solve_DL(SubSystem *subsys);
+        // the solvers for dense or sparse jacobi matrices
+        template <typename MatrixType> int solveLM(SubSystem *subsys);
+        template <typename MatrixType> int solveDL(SubSystem *subsys);
     public:
         System();
         System(std::vector<Constraint *> clist_);
@@ -164,6 +169,9 @@ namespace GCS
         int solve(VEC_pD &params, bool isFine=true, Algorithm alg=DogLeg);
         int solve(SubSystem *subsys, bool isFine=true, Algorithm alg=DogLeg);
         int solve(SubSystem *subsysA, SubSystem *subsysB, bool isFine=true);
+        // races the given algorithms on copies of each subsystem, the first one that
+        // succeeds cancels the others
+        int solve(const std::vector<Algorithm> &algs, bool isFine=true);
 
         void applySolution();
         void undoSolution();
@@ -183,6 +191,8 @@ namespace GCS
     #define XconvergenceFine  1e-10
     #define smallF            1e-20
     #define MaxIterations     100 //Note that the total number of iterations allowed is MaxIterations *xLength
+    #define SparseThreshold   100 //Subsystems with at least this number of parameters are solved with sparse matrices
+    #define ParallelThreshold 20  //Independent subsystems are solved concurrently if they have at least this number of parameters in total
 
     ///////////////////////////////////////
     // Helper elements
@@ -23,13 +23,14 @@
 #include <iostream>
 #include <iterator>
 #include "SubSystem.h"
+#include <QAtomicInt>
 
 namespace GCS
 {
 
 // SubSystem
 SubSystem::SubSystem(std::vector<Constraint *> &clist_, VEC_pD &params)
-: clist(clist_)
+: clist(clist_), cancel(0)
 {
     MAP_pD_pD dummymap;
     initialize(params, dummymap);
@@ -37,7 +38,7 @@ SubSystem::SubSystem(std::vector<Constraint *> &clist_, VEC_pD &params)
 
 SubSystem::SubSystem(std::vector<Constraint *> &clist_, VEC_pD &params,
                      MAP_pD_pD &reductionmap)
-: clist(clist_)
+: clist(clist_), cancel(0)
 {
     initialize(params, reductionmap);
 }
@@ -150,6 +151,11 @@ void SubSystem::revertParams()
         (*constr)->revertParams();
 }
 
+bool SubSystem::isCanceled() const
+{
+    return cancel && *cancel != 0;
+}
+
 void SubSystem::getParamMap(MAP_pD_pD &pmapOut)
 {
     pmapOut = pmap;
@@ -270,6 +276,26 @@ void SubSystem::calcJacobi(Eigen::MatrixXd &jacobi)
     calcJacobi(plist, jacobi);
 }
 
+#ifdef FREEGCS_SPARSE
+void SubSystem::calcJacobi(Eigen::SparseMatrix<double> &jacobi)
+{
+    // only the parameters of a constraint can have a non-zero derivative,
+    // the column of a parameter is its position in pvals
+    std::vector<Eigen::Triplet<double> > triplets;
+    for (int i=0; i < csize; i++) {
+        std::map<Constraint *,VEC_pD >::const_iterator it = c2p.find(clist[i]);
+        if (it == c2p.end())
+            continue;
+        for (VEC_pD::const_iterator param=it->second.begin();
+             param != it->second.end(); ++param)
+            triplets.push_back(Eigen::Triplet<double>(i, int(*param - &pvals[0]),
+                                                      clist[i]->grad(*param)));
+    }
+    jacobi.resize(csize, psize);
+    jacobi.setFromTriplets(triplets.begin(), triplets.end());
+}
+#endif
+
 void SubSystem::calcGrad(VEC_pD &params, Eigen::VectorXd &grad)
 {
     assert(grad.size() == int(params.size()));
@@ -27,8 +27,15 @@
 #undef max
 
 #include <Eigen/Core>
+#if EIGEN_VERSION_AT_LEAST(3,1,0)
+// sparse matrices and their solvers are stable since Eigen 3.1
+# define FREEGCS_SPARSE
+# include <Eigen/Sparse>
+#endif
 #include "Constraints.h"
 
+class QAtomicInt;
+
 namespace GCS
 {
 
@@ -43,6 +50,7 @@ namespace GCS
 //        JacobianMatrix jacobi;  // jacobi matrix of the residuals
         std::map<Constraint *,VEC_pD > c2p; // constraint to parameter adjacency list
         std::map<double *,std::vector<Constraint *> > p2c; // parameter to constraint adjacency list
+        const QAtomicInt *cancel; // set by another solver that already succeeded
         void initialize(VEC_pD &params, MAP_pD_pD &reductionmap); // called by the constructors
     public:
         SubSystem(std::vector<Constraint *> &clist_, VEC_pD &params);
@@ -56,6 +64,9 @@ namespace GCS
         void redirectParams();
         void revertParams();
 
+        void setCancelFlag(const QAtomicInt *flag) { cancel = flag; }
+        bool isCanceled() const;
+
         void getParamMap(MAP_pD_pD &pmapOut);
         void getParamList(VEC_pD &plistOut);
 
@@ -69,6 +80,9 @@ namespace GCS
         void calcResidual(Eigen::VectorXd &r, double &err);
         void calcJacobi(VEC_pD &params, Eigen::MatrixXd &jacobi);
         void calcJacobi(Eigen::MatrixXd &jacobi);
+#ifdef FREEGCS_SPARSE
+        void calcJacobi(Eigen::SparseMatrix<double> &jacobi);
+#endif
         void calcGrad(VEC_pD &params, Eigen::VectorXd &grad);
         void calcGrad(Eigen::VectorXd &grad);
 
@@ -241,6 +241,9 @@ ViewProviderSketch::ViewProviderSketch()
     xInit=0;
     yInit=0;
     relative=false;
+
+    // the selection is only observed in edit mode
+    detachSelection();
 }
 
 ViewProviderSketch::~ViewProviderSketch()
@@ -2931,6 +2934,7 @@ bool ViewProviderSketch::setEdit(int ModNum)
     // create the container for the additional edit data
     assert(!edit);
     edit = new EditData();
+    attachSelection();
 
     createEditInventorNodes();
     this->hide(); // avoid that the wires interfere with the edit lines
@@ -3242,6 +3246,7 @@ void ViewProviderSketch::unsetEdit(int ModNum)
 
     delete edit;
     edit = 0;
+    detachSelection();
 
     this->show();
 
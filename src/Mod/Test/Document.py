@@ -304,6 +304,34 @@ class UndoRedoCases(unittest.TestCase):
     self.Doc.clearUndos()
     self.assertEqual(self.Doc.ActiveObject,None)
 
+  def testUndoLimit(self):
+    # switch on the Undo
+    self.Doc.UndoMode = 1
+    self.Doc.getObject("Base").FloatList = []
+    for i in range(5):
+      self.Doc.openTransaction("Transaction%d" % i)
+      self.Doc.getObject("Base").FloatList = [float(i)] * 10000
+      self.Doc.commitTransaction()
+    self.assertEqual(self.Doc.UndoCount,5)
+    self.assertEqual(len(self.Doc.UndoSizes),5)
+    self.failUnless(self.Doc.UndoSizes[0] > 0)
+    self.assertEqual(sum(self.Doc.UndoSizes),self.Doc.UndoRedoMemSize)
+
+    # the oldest undos are removed to fit into the limit
+    self.Doc.UndoLimit = sum(self.Doc.UndoSizes[0:2])
+    self.assertEqual(self.Doc.UndoNames,['Transaction4','Transaction3'])
+    self.failUnless(self.Doc.UndoRedoMemSize <= self.Doc.UndoLimit)
+
+    self.Doc.undo()
+    self.assertEqual(len(self.Doc.RedoSizes),1)
+    self.assertEqual(self.Doc.getObject("Base").FloatList[0],3.0)
+
+    # the most recent undo is always kept
+    self.Doc.UndoLimit = 1
+    self.assertEqual(self.Doc.UndoCount,1)
+    self.Doc.UndoLimit = 0
+    self.Doc.UndoMode = 0
+
   def testUndo(self):
     # switch on the Undo
     self.Doc.UndoMode = 1